@@ -0,0 +1,321 @@
+// Microbenchmark for the gamepad -> keyboard mapping pipeline.
+//
+// Feeds synthetic DIJOYSTATE2 streams through InputProcessor (nothing is
+// actually injected: queued events go to a NullInputSink) and times the
+// other per-frame hot spots in isolation. Reports ns/frame, heap
+// allocations/frame and throughput so hot-path regressions show up here
+// before they show up on a real machine.
+//
+// GamepadMapperBench <recording.gmrec> [gamepad_config.json] also replays a
+// recorded input stream through the pipeline, optionally with that config.
+#include <windows.h>
+#include <dinput.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include "ConfigManager.h"
+#include "DisplayBuffer.h"
+#include "InputProcessor.h"
+#include "InputQueue.h"
+#include "InputRecording.h"
+#include "InputSink.h"
+#include "KeyResolver.h"
+#include "KeyStateTable.h"
+#include "LatencyStats.h"
+
+// =====================================
+// Allocation counting
+// =====================================
+
+namespace {
+std::atomic<uint64_t> g_allocationCount{ 0 };
+}
+
+void* operator new(size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// =====================================
+// Harness
+// =====================================
+
+constexpr size_t WARMUP_FRAMES = 1000;
+constexpr size_t MEASURED_FRAMES = 200000;
+constexpr size_t MAX_PADS = 8;
+
+struct BenchResult {
+    double nsPerFrame = 0.0;
+    double allocationsPerFrame = 0.0;
+    double framesPerSecond = 0.0;
+    double eventsPerFrame = 0.0;
+};
+
+// frame(i) runs one frame and returns the number of key events it produced
+BenchResult Measure(size_t frames, const std::function<size_t(size_t)>& frame)
+{
+    for (size_t i = 0; i < WARMUP_FRAMES; ++i) {
+        frame(i);
+    }
+
+    uint64_t events = 0;
+    const uint64_t allocationsBefore = g_allocationCount.load(std::memory_order_relaxed);
+    const int64_t start = Qpc::Now();
+    for (size_t i = 0; i < frames; ++i) {
+        events += frame(WARMUP_FRAMES + i);
+    }
+    const int64_t elapsed = Qpc::Now() - start;
+    const uint64_t allocations = g_allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+    const double seconds = static_cast<double>(elapsed) / static_cast<double>(Qpc::Frequency());
+    BenchResult result;
+    result.nsPerFrame = seconds * 1e9 / static_cast<double>(frames);
+    result.allocationsPerFrame = static_cast<double>(allocations) / static_cast<double>(frames);
+    result.framesPerSecond = seconds > 0.0 ? static_cast<double>(frames) / seconds : 0.0;
+    result.eventsPerFrame = static_cast<double>(events) / static_cast<double>(frames);
+    return result;
+}
+
+void Report(const char* name, const BenchResult& r)
+{
+    std::printf("%-28s %12.1f %12.3f %14.0f %12.2f\n",
+                name, r.nsPerFrame, r.allocationsPerFrame, r.framesPerSecond, r.eventsPerFrame);
+}
+
+// =====================================
+// Synthetic input streams
+// =====================================
+
+DIJOYSTATE2 IdleState()
+{
+    DIJOYSTATE2 state{};
+    for (auto& pov : state.rgdwPOV) {
+        pov = 0xFFFFFFFF;
+    }
+    return state;
+}
+
+// Default mapping uses buttons 0,1,2,3,5,7: press/release a different one every frame
+void ApplyButtonMashing(DIJOYSTATE2& state, size_t frame, size_t phase)
+{
+    static constexpr size_t mapped[] = { 0, 1, 2, 3, 5, 7 };
+    for (size_t b : mapped) {
+        state.rgbButtons[b] = 0;
+    }
+    state.rgbButtons[mapped[(frame + phase) % std::size(mapped)]] = 0x80;
+}
+
+// Full circle every 64 frames; crosses the stick threshold on every axis
+void ApplyStickSweep(DIJOYSTATE2& state, size_t frame, size_t phase)
+{
+    static constexpr LONG circle[16][2] = {
+        { 1000, 0 }, { 924, 383 }, { 707, 707 }, { 383, 924 },
+        { 0, 1000 }, { -383, 924 }, { -707, 707 }, { -924, 383 },
+        { -1000, 0 }, { -924, -383 }, { -707, -707 }, { -383, -924 },
+        { 0, -1000 }, { 383, -924 }, { 707, -707 }, { 924, -383 },
+    };
+    const auto& point = circle[((frame + phase) / 4) % 16];
+    state.lX = point[0];
+    state.lY = point[1];
+}
+
+// =====================================
+// Pipeline fixture
+// =====================================
+
+struct Pad {
+    std::unique_ptr<ConfigManager> config;
+    std::unique_ptr<InputProcessor> processor;
+    DIJOYSTATE2 state = IdleState();
+};
+
+struct Pipeline {
+    NullInputSink sink;
+    KeyStateTable keyState; // As in GamepadManager: pads share the arbitration
+    InputQueue queue{ sink };
+    std::vector<Pad> pads;
+
+    explicit Pipeline(size_t padCount)
+    {
+        queue.SetKeyState(&keyState);
+        auto [gamepadConfig, systemConfig] = ConfigManager::createDefaultConfig();
+        for (size_t i = 0; i < padCount; ++i) {
+            Pad pad;
+            pad.config = std::make_unique<ConfigManager>("bench_pad_" + std::to_string(i) + ".json");
+            pad.config->setConfig(gamepadConfig, systemConfig);
+            pad.processor = std::make_unique<InputProcessor>(*pad.config);
+            pad.processor->SetInputQueue(&queue);
+            pads.push_back(std::move(pad));
+        }
+    }
+
+    // Stubbed injection: the null sink counts the frame's events and drops them
+    size_t Drain()
+    {
+        return queue.FlushTo(sink);
+    }
+};
+
+BenchResult BenchPipeline(size_t padCount, bool mash, bool sweep)
+{
+    Pipeline pipeline(padCount);
+    return Measure(MEASURED_FRAMES, [&](size_t frame) {
+        for (size_t p = 0; p < pipeline.pads.size(); ++p) {
+            Pad& pad = pipeline.pads[p];
+            if (mash) ApplyButtonMashing(pad.state, frame, p);
+            if (sweep) ApplyStickSweep(pad.state, frame, p * 3);
+            pad.processor->ProcessGamepadInput(pad.state);
+        }
+        return pipeline.Drain();
+    });
+}
+
+// Recorded stream: one recorded state per frame, looping at the end
+BenchResult BenchReplay(RecordingReader& recording, const char* configPath)
+{
+    Pipeline pipeline(1);
+    Pad& pad = pipeline.pads.front();
+    if (configPath) {
+        auto config = std::make_unique<ConfigManager>(configPath);
+        if (config->load() == ConfigManager::LoadResult::Loaded) {
+            pad.processor->SetConfig(*config);
+            pad.config = std::move(config);
+        } else {
+            std::fprintf(stderr, "Could not load %s, replaying with the default mapping\n", configPath);
+        }
+    }
+
+    return Measure(MEASURED_FRAMES, [&](size_t) {
+        if (!recording.Next()) {
+            // The rewound stream restarts from the zero state; let go of everything first
+            pad.processor->ReleaseAllKeys();
+            recording.Rewind();
+            recording.Next();
+        }
+        pad.processor->ProcessGamepadInput(recording.GetState());
+        return pipeline.Drain();
+    });
+}
+
+// =====================================
+// Component benchmarks
+// =====================================
+
+BenchResult BenchConfigLookups()
+{
+    ConfigManager config("bench_lookup.json");
+    auto [gamepadConfig, systemConfig] = ConfigManager::createDefaultConfig();
+    config.setConfig(gamepadConfig, systemConfig);
+
+    return Measure(MEASURED_FRAMES, [&](size_t) {
+        size_t keys = 0;
+        for (int b = 0; b < static_cast<int>(AppConstants::MAX_BUTTONS); ++b) {
+            keys += config.getButtonKeys(b).size();
+        }
+        for (size_t d = 0; d < AppConstants::AXIS_DIRECTIONS; ++d) {
+            keys += config.getDpadKeys(d).size() + config.getStickKeys(d).size();
+        }
+        return keys;
+    });
+}
+
+BenchResult BenchKeyResolver()
+{
+    static const std::string names[] = { "a", "Z", "space", "ENTER", "alt", "f12", "printscreen", "0x41", "65", "nope" };
+    return Measure(MEASURED_FRAMES / 10, [&](size_t) {
+        size_t resolved = 0;
+        for (const auto& name : names) {
+            resolved += KeyResolver::resolve(name).has_value() ? 1 : 0;
+        }
+        return resolved;
+    });
+}
+
+BenchResult BenchDisplayFormatting()
+{
+    DisplayBuffer display(150);
+    const std::wstring deviceName = L"Bench Pad";
+    DIJOYSTATE2 state = IdleState();
+    DisplayBuffer::DirtyRows dirtyRows;
+
+    return Measure(MEASURED_FRAMES / 10, [&](size_t frame) {
+        display.Clear();
+        ApplyStickSweep(state, frame, 0);
+        ApplyButtonMashing(state, frame, 0);
+        display.AddGamepadState(deviceName, state);
+        display.PublishFrame(&dirtyRows);
+        return size_t{0};
+    });
+}
+
+// The compiled tables use 16-bit offsets: the last entry that fits must still
+// resolve, and one more must mark the map overflowed instead of wrapping
+bool CheckKeyMapLimits()
+{
+    CompiledKeyMap map;
+    map.setButtonKeys(0, std::vector<WORD>(CompiledKeyMap::MAX_TABLE_ENTRIES - 1, 'A'));
+    map.setButtonKeys(1, { 'B' });
+    bool ok = !map.overflowed() && map.buttonKeys(1).size() == 1 && map.buttonKeys(1)[0] == 'B';
+    map.setButtonKeys(2, { 'C' });
+    ok = ok && map.overflowed() && map.buttonKeys(2).empty();
+
+    map.clear();
+    for (size_t i = 0; i < CompiledKeyMap::MAX_TABLE_ENTRIES; ++i) {
+        map.addMacroStep(0, {}, 1, 0);
+    }
+    ok = ok && !map.overflowed() && map.macroSteps(0).size() == CompiledKeyMap::MAX_TABLE_ENTRIES;
+    map.addMacroStep(0, {}, 1, 0);
+    ok = ok && map.overflowed();
+
+    if (!ok) {
+        std::fprintf(stderr, "CompiledKeyMap: 16-bit table limit not enforced\n");
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    RecordingReader recording;
+    const bool hasRecording = argc > 1 && recording.Open(std::filesystem::path(argv[1]).wstring()) && recording.Next();
+    if (argc > 1 && !hasRecording) {
+        std::fprintf(stderr, "Could not read recording %s\n", argv[1]);
+    }
+    recording.Rewind();
+
+    if (!CheckKeyMapLimits()) {
+        return 1;
+    }
+
+    std::printf("%-28s %12s %12s %14s %12s\n", "benchmark", "ns/frame", "allocs/frame", "frames/s", "events/frame");
+
+    Report("pipeline: idle (1 pad)", BenchPipeline(1, false, false));
+    Report("pipeline: button mashing", BenchPipeline(1, true, false));
+    Report("pipeline: stick sweep", BenchPipeline(1, false, true));
+    Report("pipeline: 8 pads mash+sweep", BenchPipeline(MAX_PADS, true, true));
+    if (hasRecording) {
+        Report("pipeline: recorded input", BenchReplay(recording, argc > 2 ? argv[2] : nullptr));
+    }
+    Report("ConfigManager lookups", BenchConfigLookups());
+    Report("KeyResolver::resolve x10", BenchKeyResolver());
+    Report("DisplayBuffer build+publish", BenchDisplayFormatting());
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "AnalogEngine.h"
+#include <algorithm>
+
+namespace {
+
+// Integer square root (floor), enough for |stick|^2 <= 2 * FULL_SCALE^2
+uint32_t ISqrt(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t bit = 1u << 30;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+} // namespace
+
+void AnalogEngine::Configure(const AnalogSettings& settings)
+{
+    m_settings = settings;
+    m_settings.deadzone = std::clamp(settings.deadzone, 0, FULL_SCALE - 1);
+    m_rescaleQ16 = static_cast<uint32_t>((FULL_SCALE << 16) / (FULL_SCALE - m_settings.deadzone));
+
+    // DirectInput layout: a pad without Rx/Ry reports them centred, which reads as trigger level
+    // FULL_SCALE / 2; a lower threshold would hold that trigger down for good
+    if (m_settings.layout == AnalogLayout::DirectInput) {
+        m_settings.triggerPress = (std::max)(settings.triggerPress, FULL_SCALE / 2);
+    }
+
+    // Release must lie in [0, press]: above press it would flap, below 0 a centred stick never releases
+    const int32_t stickRelease = std::clamp(settings.stickRelease, 0, (std::max)(settings.stickPress, 0));
+    const int32_t triggerRelease = std::clamp(settings.triggerRelease, 0, (std::max)(m_settings.triggerPress, 0));
+    for (size_t i = 0; i < ANALOG_SOURCE_COUNT; ++i) {
+        const bool trigger = i == AN_LTRIGGER || i == AN_RTRIGGER;
+        m_press[i] = trigger ? m_settings.triggerPress : settings.stickPress;
+        m_release[i] = trigger ? triggerRelease : stickRelease;
+    }
+}
+
+int32_t AnalogEngine::ShapeAxis(int32_t value) const
+{
+    const int32_t magnitude = value < 0 ? -value : value;
+    if (magnitude <= m_settings.deadzone) {
+        return 0;
+    }
+    const int32_t shaped = (std::min)(static_cast<int32_t>((static_cast<uint64_t>(magnitude - m_settings.deadzone) * m_rescaleQ16) >> 16), FULL_SCALE);
+    return value < 0 ? -shaped : shaped;
+}
+
+void AnalogEngine::ShapeStick(int32_t& x, int32_t& y) const
+{
+    if (m_settings.deadzone == 0) {
+        return; // Unshaped: thresholds apply to the raw axes
+    }
+    if (!m_settings.radialDeadzone) {
+        x = ShapeAxis(x);
+        y = ShapeAxis(y);
+        return;
+    }
+
+    const uint32_t lengthSquared = static_cast<uint32_t>(x * x + y * y);
+    const uint32_t deadzone = static_cast<uint32_t>(m_settings.deadzone);
+    if (lengthSquared <= deadzone * deadzone) {
+        x = y = 0;
+        return;
+    }
+
+    // Rescale the vector length from (deadzone, FULL_SCALE] to (0, FULL_SCALE], keeping its direction
+    const int32_t length = static_cast<int32_t>(ISqrt(lengthSquared));
+    const int32_t shaped = (std::min)(static_cast<int32_t>((static_cast<uint64_t>(length - m_settings.deadzone) * m_rescaleQ16) >> 16), FULL_SCALE);
+    x = x * shaped / length;
+    y = y * shaped / length;
+}
+
+AnalogEngine::SourceMask AnalogEngine::Update(const DIJOYSTATE2& js)
+{
+    // Read all six axes once, clamped to the configured range
+    const LONG raw[6] = { js.lX, js.lY, js.lZ, js.lRx, js.lRy, js.lRz };
+    int32_t axes[6];
+    for (size_t i = 0; i < 6; ++i) {
+        axes[i] = static_cast<int32_t>(std::clamp<LONG>(raw[i], -FULL_SCALE, FULL_SCALE));
+    }
+
+    int32_t lx = axes[0];
+    int32_t ly = axes[1];
+    int32_t rx, ry, leftTrigger, rightTrigger;
+    if (m_settings.layout == AnalogLayout::XInput) {
+        rx = axes[3];
+        ry = axes[4];
+        leftTrigger = (std::max)(axes[2], 0);
+        rightTrigger = (std::max)(-axes[2], 0);
+    } else {
+        rx = axes[2];
+        ry = axes[5];
+        leftTrigger = (axes[3] + FULL_SCALE) / 2;
+        rightTrigger = (axes[4] + FULL_SCALE) / 2;
+    }
+
+    ShapeStick(lx, ly);
+    ShapeStick(rx, ry);
+
+    // Up is the negative direction on both sticks
+    const std::array<int32_t, ANALOG_SOURCE_COUNT> levels = {
+        -lx, lx, -ly, ly,
+        -rx, rx, -ry, ry,
+        leftTrigger, rightTrigger,
+    };
+
+    SourceMask current = 0;
+    for (size_t i = 0; i < ANALOG_SOURCE_COUNT; ++i) {
+        const bool held = (m_active >> i) & 1;
+        const int32_t threshold = held ? m_release[i] : m_press[i];
+        current |= static_cast<SourceMask>(levels[i] > threshold) << i;
+    }
+
+    const SourceMask changed = current ^ m_active;
+    m_active = current;
+    return changed;
+}
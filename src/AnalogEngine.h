@@ -0,0 +1,65 @@
+#pragma once
+#include <windows.h>
+#include <dinput.h>
+#include <array>
+#include <cstdint>
+#include "Constants.h"
+
+// Which DirectInput axes carry the right stick and the triggers
+enum class AnalogLayout : uint8_t {
+    DirectInput, // Right stick Z/Rz, triggers on Rx/Ry (rest at the axis minimum; press threshold at least half travel)
+    XInput,      // Right stick Rx/Ry, both triggers share Z (left +, right -)
+};
+
+/**
+ * @brief Analog processing parameters, compiled from SystemConfig
+ *
+ * All values are on the axis scale set by DirectInputDevice::SetAxisRanges,
+ * which XInputDevice scales to as well (0 = centre / rest, AXIS_RANGE_MAX =
+ * full deflection).
+ */
+struct AnalogSettings {
+    int32_t deadzone = 0;        // Inner deadzone; the remaining travel is rescaled to the full range
+    bool radialDeadzone = true;  // false: applied per axis
+    int32_t stickPress = AppConstants::AXIS_THRESHOLD_DEFAULT;
+    int32_t stickRelease = AppConstants::AXIS_THRESHOLD_DEFAULT - AppConstants::AXIS_HYSTERESIS_DEFAULT;
+    int32_t triggerPress = AppConstants::TRIGGER_THRESHOLD_DEFAULT;
+    int32_t triggerRelease = AppConstants::TRIGGER_THRESHOLD_DEFAULT - AppConstants::AXIS_HYSTERESIS_DEFAULT;
+    AnalogLayout layout = AnalogLayout::DirectInput;
+};
+
+/**
+ * @brief Turns the six DIJOYSTATE2 axes into per-source on/off state
+ *
+ * One Update reads lX..lRz, applies the deadzone to both sticks, derives the
+ * ten half-axis levels (stick directions and triggers) and compares them all
+ * against press or release thresholds depending on each source's current
+ * state. Everything is integer arithmetic on the axis scale. The hysteresis
+ * band means a stick resting near the threshold no longer chatters; only
+ * genuine transitions come out of Update.
+ */
+class AnalogEngine {
+public:
+    using SourceMask = uint16_t; // Bit i <=> AnalogSource i
+
+    AnalogEngine() { Configure(AnalogSettings{}); }
+
+    void Configure(const AnalogSettings& settings);
+
+    // Returns the sources whose state changed; Active() holds the new state
+    SourceMask Update(const DIJOYSTATE2& js);
+    SourceMask Active() const { return m_active; }
+    void Reset() { m_active = 0; }
+
+private:
+    static constexpr int32_t FULL_SCALE = AppConstants::AXIS_RANGE_MAX;
+
+    void ShapeStick(int32_t& x, int32_t& y) const;
+    int32_t ShapeAxis(int32_t value) const;
+
+    AnalogSettings m_settings;
+    uint32_t m_rescaleQ16 = 1u << 16; // FULL_SCALE / (FULL_SCALE - deadzone) in Q16.16
+    std::array<int32_t, ANALOG_SOURCE_COUNT> m_press{};
+    std::array<int32_t, ANALOG_SOURCE_COUNT> m_release{};
+    SourceMask m_active = 0;
+};
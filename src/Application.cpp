@@ -4,8 +4,11 @@
 #include "GamepadDevice.h"
 #include "Logger.h"
 #include "DisplayBuffer.h"
+#include "TextConversion.h"
+#include <avrt.h>
 #include <memory>
 #include <stdexcept>
+#include <system_error>
 #include <filesystem>
 #include <algorithm>
 
@@ -57,8 +60,20 @@ bool Application::Initialize()
 
 bool Application::InitializeLogger()
 {
+    m_systemConfig = ConfigManager::loadSystemConfig(GenerateSystemConfigPath());
+    
+    LoggerOptions options;
+    options.async = m_systemConfig.log_async;
+    options.queueSize = static_cast<size_t>((std::max)(m_systemConfig.log_queue_size, 1));
+    options.discardOldestOnOverflow = m_systemConfig.log_overflow_policy != "block";
+    options.flushInterval = std::chrono::milliseconds((std::max)(m_systemConfig.log_flush_interval_ms, 0));
+    options.level = spdlog::level::from_str(m_systemConfig.log_level);
+    if (options.level == spdlog::level::off && m_systemConfig.log_level != "off") {
+        options.level = spdlog::level::info; // from_str maps unknown names to "off"
+    }
+    
     std::string logPath = GenerateLogPath();
-    if (!Logger::GetInstance().Init(logPath)) {
+    if (!Logger::GetInstance().Init(logPath, options)) {
         MessageBox(nullptr, L"Failed to initialize log file!", L"Error", MB_ICONERROR);
         return false;
     }
@@ -71,7 +86,8 @@ bool Application::InitializeLogger()
 bool Application::InitializeWindow()
 {
     m_windowManager = std::make_unique<WindowManager>(m_hInstance, L"Gamepad Mapper", m_displayBuffer.get());
-    if (!m_windowManager->Init(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+    const bool trayMode = m_systemConfig.display_mode == "tray";
+    if (!m_windowManager->Init(WINDOW_WIDTH, WINDOW_HEIGHT, trayMode)) {
         MessageBox(nullptr, L"Window initialization failed!", L"Error", MB_ICONERROR);
         return false;
     }
@@ -84,6 +100,14 @@ bool Application::InitializeGamepadManager()
     
     // Inject display buffer dependency
     m_gamepadManager->SetDisplayBuffer(m_displayBuffer.get());
+    m_gamepadManager->SetDeviceWorkerCount(static_cast<size_t>((std::max)(m_systemConfig.device_workers, 0)));
+    m_gamepadManager->SetConfigHotReload(m_systemConfig.config_hot_reload);
+    m_gamepadManager->SetXInputEnabled(m_systemConfig.xinput);
+    m_gamepadManager->SetHidEnabled(m_systemConfig.hid_input);
+    m_gamepadManager->SetRecordingDirectory(Text::Utf8ToWide(m_systemConfig.record_directory));
+    m_gamepadManager->SetReplayFile(Text::Utf8ToWide(m_systemConfig.replay_file), m_systemConfig.replay_realtime);
+    m_gamepadManager->SetProfileRules(m_systemConfig.profiles);
+    m_gamepadManager->SetMetricsExport(Text::Utf8ToWide(m_systemConfig.metrics_shared_memory));
     
     if (!m_gamepadManager->Initialize(m_hInstance, m_windowManager->GetHwnd())) {
         // This will only fail in case of a fatal error, like DirectInput8Create failing.
@@ -91,6 +115,11 @@ bool Application::InitializeGamepadManager()
         return false;
     }
     
+    // Hot-plug: device arrival/removal triggers a background rescan
+    m_windowManager->SetDeviceChangeHandler([manager = m_gamepadManager.get()](WPARAM eventType) {
+        manager->OnDeviceChange(eventType);
+    });
+    
     // Log initial gamepad status
     LogGamepadStatus();
     
@@ -108,38 +137,149 @@ int Application::Run()
     m_running = true;
     LOG_INFO("Multi-gamepad polling started... press Esc or close the window to quit.");
     
-    // Main application loop
-    while (m_running && m_windowManager->IsRunning()) {
-        ProcessMessages();
-        
-        if (!m_running || !m_windowManager->IsRunning()) {
-            break;
-        }
-        
-        UpdateFrame();
-        Sleep(FRAME_SLEEP_MS);
+    if (!StartInputThread()) {
+        m_running = false;
+        return 1;
     }
     
+    // The window thread only pumps messages; WM_PAINT consumes published display snapshots
+    ProcessMessages();
+    
+    StopInputThread();
     return 0;
 }
 
 void Application::ProcessMessages()
 {
-    while (PeekMessage(&m_msg, nullptr, 0, 0, PM_REMOVE)) {
-        if (m_msg.message == WM_QUIT) {
+    while (m_running && m_windowManager->IsRunning()) {
+        BOOL result = GetMessage(&m_msg, nullptr, 0, 0);
+        if (result <= 0) {
+            // WM_QUIT (0) or error (-1)
             m_windowManager->SetRunning(false);
+            break;
         }
         TranslateMessage(&m_msg);
         DispatchMessage(&m_msg);
     }
 }
 
+bool Application::StartInputThread()
+{
+    if (m_inputThread.joinable()) {
+        return true;
+    }
+    
+    // Manual-reset so every wait after shutdown is requested returns immediately
+    m_stopInputEvent.reset(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    if (!m_stopInputEvent) {
+        LOG_ERROR("Failed to create input thread stop event. Error: {}", GetLastError());
+        return false;
+    }
+    
+    try {
+        m_inputThread = std::thread(&Application::InputThreadMain, this);
+    } catch (const std::system_error& e) {
+        LOG_ERROR("Failed to start input thread: {}", e.what());
+        return false;
+    }
+    
+    return true;
+}
+
+void Application::StopInputThread()
+{
+    if (!m_inputThread.joinable()) {
+        return;
+    }
+    
+    SetEvent(m_stopInputEvent.get());
+    m_inputThread.join();
+    m_stopInputEvent.reset();
+    LOG_INFO("Input thread stopped.");
+}
+
+void Application::InputThreadMain()
+{
+    HANDLE mmcssHandle = ConfigureInputThread();
+    
+    FrameScheduler::Options frameOptions;
+    frameOptions.pollRateHz = static_cast<DWORD>((std::max)(m_systemConfig.poll_rate, 1));
+    frameOptions.idleRateHz = static_cast<DWORD>((std::max)(m_systemConfig.idle_poll_rate, 1));
+    frameOptions.idleTimeoutMs = static_cast<DWORD>((std::max)(m_systemConfig.idle_timeout_ms, 0));
+    m_frameScheduler.Initialize(frameOptions); // Without a timer it still paces with plain waits
+    
+    try {
+        while (m_running) {
+            UpdateFrame();
+            m_frameScheduler.OnFrame(m_gamepadManager && m_gamepadManager->HadInputActivity());
+            if (!WaitForInput()) {
+                break;
+            }
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Input thread terminated by exception: {}", e.what());
+        m_windowManager->RequestExit();
+    }
+    
+    if (mmcssHandle) {
+        AvRevertMmThreadCharacteristics(mmcssHandle);
+    }
+}
+
+HANDLE Application::ConfigureInputThread()
+{
+    // Prefer MMCSS so the scheduler boosts us like a game's input thread
+    DWORD taskIndex = 0;
+    HANDLE mmcssHandle = AvSetMmThreadCharacteristicsW(AppConstants::INPUT_THREAD_MMCSS_TASK, &taskIndex);
+    if (mmcssHandle) {
+        AvSetMmThreadPriority(mmcssHandle, AVRT_PRIORITY_HIGH);
+        LOG_INFO("Input thread registered with MMCSS task \"Games\" (index {}).", taskIndex);
+    } else {
+        LOG_WARN("MMCSS registration failed (Error: {}), using THREAD_PRIORITY_TIME_CRITICAL.", GetLastError());
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+    }
+    
+    if (AppConstants::INPUT_THREAD_AFFINITY_MASK != 0) {
+        if (!SetThreadAffinityMask(GetCurrentThread(), AppConstants::INPUT_THREAD_AFFINITY_MASK)) {
+            LOG_WARN("SetThreadAffinityMask failed. Error: {}", GetLastError());
+        }
+    }
+    
+    return mmcssHandle;
+}
+
+bool Application::WaitForInput()
+{
+    // Returns false once shutdown has been requested
+    HANDLE stopEvent = m_stopInputEvent.get();
+    
+    m_inputEvents.clear();
+    bool eventDriven = m_gamepadManager && m_gamepadManager->CollectInputEvents(m_inputEvents);
+    
+    // Wake up in time for the next turbo/macro event as well
+    const DWORD timerDelay = m_gamepadManager ? m_gamepadManager->GetNextTimerDelayMs() : INFINITE;
+    
+    // Fall back to fixed-rate polling if any device cannot signal, or there are too many to wait on
+    m_polling = !eventDriven || m_inputEvents.size() >= MAXIMUM_WAIT_OBJECTS;
+    if (m_polling) {
+        return m_frameScheduler.WaitForNextFrame(stopEvent, timerDelay);
+    }
+    
+    // Block until a device has new buffered data, shutdown is requested, or the idle timeout expires
+    DWORD count = static_cast<DWORD>(m_inputEvents.size());
+    m_inputEvents.push_back(stopEvent);
+    DWORD result = WaitForMultipleObjects(count + 1, m_inputEvents.data(), FALSE,
+                                          (std::min)(EVENT_WAIT_TIMEOUT_MS, timerDelay));
+    
+    return result != WAIT_OBJECT_0 + count && result != WAIT_FAILED;
+}
+
 void Application::UpdateFrame()
 {
     // Build new frame content
     BuildFrameContent();
     
-    // Only update display if content has changed
+    // Hand the finished frame to the window thread
     UpdateDisplay();
     CheckExitConditions();
 }
@@ -147,10 +287,13 @@ void Application::UpdateFrame()
 void Application::BuildFrameContent()
 {
     // Clear display buffer and rebuild content
+    // (always cleared, so re-enabling the view mid-frame never appends to a stale frame)
     m_displayBuffer->Clear();
     
-    // Display gamepad information at the top
-    LogGamepadStatus();
+    // Display gamepad information at the top; skipped entirely while hidden in the tray
+    if (m_displayBuffer->IsEnabled()) {
+        LogGamepadStatus();
+    }
     
     // Process gamepad input
     ProcessGamepadInput();
@@ -172,6 +315,26 @@ void Application::LogGamepadStatus()
         m_displayBuffer->AddFormattedLine(L"Gamepad Status: %zu/%zu devices connected", 
                                          connectedDevices, totalDevices);
         
+        if (Logger::GetInstance().IsAsync()) {
+            m_displayBuffer->AddFormattedLine(L"Log: %llu messages dropped",
+                                             static_cast<unsigned long long>(Logger::GetInstance().GetDroppedMessageCount()));
+        }
+        
+        const InputQueue& inputQueue = m_gamepadManager->GetInputQueue();
+        m_displayBuffer->AddFormattedLine(L"SendInput: last %u / max %u events per flush (%llu flushes, %llu shared-key events absorbed)",
+                                         inputQueue.GetLastFlushEventCount(),
+                                         inputQueue.GetMaxFlushEventCount(),
+                                         static_cast<unsigned long long>(inputQueue.GetFlushCount()),
+                                         static_cast<unsigned long long>(inputQueue.GetSuppressedEventCount()));
+        
+        if (m_polling) {
+            m_displayBuffer->AddFormattedLine(L"Polling: %u Hz%s (%s timer, %llu late frames)",
+                                             m_frameScheduler.GetCurrentRateHz(),
+                                             m_frameScheduler.IsIdle() ? L" idle" : L"",
+                                             m_frameScheduler.IsHighResolution() ? L"high resolution" : L"system",
+                                             static_cast<unsigned long long>(m_frameScheduler.GetLateFrameCount()));
+        }
+        
         // Log individual device status
         auto connectedNames = m_gamepadManager->GetConnectedDeviceNames();
         for (const auto& name : connectedNames) {
@@ -202,7 +365,9 @@ void Application::ProcessGamepadInput()
         m_gamepadManager->ProcessAllDevices();
     } else {
         // No devices connected, show waiting message
-        m_displayBuffer->AddLine(L"Waiting for gamepad connections...");
+        if (m_displayBuffer->IsEnabled()) {
+            m_displayBuffer->AddLine(L"Waiting for gamepad connections...");
+        }
         
         // The gamepad manager will automatically scan for new devices periodically
         // We just need to call ProcessAllDevices to trigger the scan
@@ -212,14 +377,23 @@ void Application::ProcessGamepadInput()
 
 void Application::UpdateDisplay()
 {
-    // Only invalidate the rect, don't force immediate update
-    // This reduces flickering by allowing Windows to batch updates
-    InvalidateRect(m_windowManager->GetHwnd(), nullptr, FALSE);
+    // Unchanged frames are not published and cause no repaint at all;
+    // otherwise only the changed rows are invalidated, don't force immediate update
+    // (safe from the input thread; the paint itself happens on the window thread)
+    if (!m_displayBuffer->IsEnabled()) {
+        return;
+    }
+    if (m_displayBuffer->PublishFrame(&m_dirtyRows)) {
+        m_windowManager->InvalidateRows(m_dirtyRows);
+    }
 }
 
 void Application::CheckExitConditions()
 {
-    // Check for Esc key to exit
+    // Check for Esc key to exit (only while the live view is up; a tray instance is exited from its menu)
+    if (!m_windowManager->IsLiveViewVisible()) {
+        return;
+    }
     SHORT esc = GetAsyncKeyState(VK_ESCAPE);
     if (esc & 0x8000) {
         PostMessage(m_windowManager->GetHwnd(), WM_CLOSE, 0, 0);
@@ -241,7 +415,13 @@ void Application::Shutdown()
 
 void Application::CleanupResources()
 {
+    // The input thread uses every component below, so it must go first
+    StopInputThread();
+    
     // Clean up components in reverse order
+    if (m_windowManager) {
+        m_windowManager->SetDeviceChangeHandler(nullptr);
+    }
     if (m_gamepadManager) {
         m_gamepadManager->Shutdown();
         m_gamepadManager.reset();
@@ -253,6 +433,14 @@ void Application::CleanupResources()
     Logger::GetInstance().Close();
 }
 
+std::string Application::GenerateSystemConfigPath() const
+{
+    wchar_t exePath[MAX_PATH];
+    GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+
+    return (std::filesystem::path(exePath).parent_path() / "gamepad_mapper.json").string();
+}
+
 std::string Application::GenerateLogPath() const
 {
     wchar_t exePath[MAX_PATH];
@@ -3,13 +3,19 @@
 #include <dinput.h>
 #include <string>
 #include <memory>
+#include <vector>
+#include <thread>
+#include <atomic>
 #include "Constants.h"
 #include "Logger.h"
+#include "Win32Handle.h"
+#include "ConfigManager.h"
+#include "DisplayBuffer.h"
+#include "FrameScheduler.h"
 
 // Forward declarations
 class WindowManager;
 class GamepadManager;
-class DisplayBuffer;
 
 /**
  * @brief Main application class with multiple gamepad support
@@ -44,8 +50,15 @@ private:
     bool InitializeWindow();
     bool InitializeGamepadManager();
     
-    // Main loop methods
+    // Main loop methods (window thread)
     void ProcessMessages();
+    
+    // Input thread methods
+    bool StartInputThread();
+    void StopInputThread();
+    void InputThreadMain();
+    HANDLE ConfigureInputThread();
+    bool WaitForInput();
     void UpdateFrame();
     void BuildFrameContent();
     void ProcessGamepadInput();
@@ -54,6 +67,7 @@ private:
     
     // Helper methods
     std::string GenerateLogPath() const;
+    std::string GenerateSystemConfigPath() const;
     void CleanupResources();
     void LogGamepadStatus();
     
@@ -63,15 +77,26 @@ private:
     std::unique_ptr<GamepadManager> m_gamepadManager;
     std::unique_ptr<DisplayBuffer> m_displayBuffer;
     
+    // Application-wide settings (gamepad_mapper.json next to the executable)
+    SystemConfig m_systemConfig;
+    
     // Application state
-    bool m_running;
+    std::atomic<bool> m_running;
     bool m_initialized;
     
     // Runtime data
     MSG m_msg;
     
+    // Input thread (polling, mapping and key injection run here, never on the window thread)
+    std::thread m_inputThread;
+    UniqueHandle m_stopInputEvent;
+    std::vector<HANDLE> m_inputEvents; // Reused every frame to avoid reallocating
+    FrameScheduler m_frameScheduler;   // Cadence while any device has to be polled
+    bool m_polling = false;            // Last wait was on the frame scheduler
+    DisplayBuffer::DirtyRows m_dirtyRows; // Rows changed by the last published frame
+    
     // Configuration
     static constexpr int WINDOW_WIDTH = AppConstants::WINDOW_WIDTH;
     static constexpr int WINDOW_HEIGHT = AppConstants::WINDOW_HEIGHT;
-    static constexpr DWORD FRAME_SLEEP_MS = AppConstants::FRAME_SLEEP_MS;
+    static constexpr DWORD EVENT_WAIT_TIMEOUT_MS = AppConstants::EVENT_WAIT_TIMEOUT_MS;
 };
\ No newline at end of file
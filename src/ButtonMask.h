@@ -0,0 +1,77 @@
+#pragma once
+#include <windows.h>
+#include <intrin.h>
+#include <emmintrin.h>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief 128-bit button state mask (one bit per DIJOYSTATE2::rgbButtons entry)
+ *
+ * Packing the 128 button bytes into two 64-bit words lets InputProcessor
+ * diff a whole frame with a couple of XOR/AND ops and only visit the buttons
+ * that actually changed.
+ */
+struct ButtonMask {
+    uint64_t lo = 0; // Buttons 0-63
+    uint64_t hi = 0; // Buttons 64-127
+
+    static constexpr size_t BUTTON_COUNT = 128;
+
+    // Pack the "pressed" (0x80) bit of each button byte: 8 SSE2 loads + movemasks
+    static ButtonMask FromButtons(const BYTE (&buttons)[BUTTON_COUNT]) {
+        ButtonMask mask;
+        mask.lo = PackWord(buttons);
+        mask.hi = PackWord(buttons + 64);
+        return mask;
+    }
+
+    bool Any() const { return (lo | hi) != 0; }
+    bool None() const { return !Any(); }
+
+    bool Test(size_t index) const {
+        const uint64_t word = index < 64 ? lo : hi;
+        return (word >> (index & 63)) & 1;
+    }
+
+    void Set(size_t index) {
+        (index < 64 ? lo : hi) |= uint64_t{1} << (index & 63);
+    }
+
+    void Reset(size_t index) {
+        (index < 64 ? lo : hi) &= ~(uint64_t{1} << (index & 63));
+    }
+
+    // Calls fn(index) for every set bit, lowest index first
+    template<typename Fn>
+    void ForEachSetBit(Fn&& fn) const {
+        ForEachSetBitInWord(lo, 0, fn);
+        ForEachSetBitInWord(hi, 64, fn);
+    }
+
+    friend ButtonMask operator^(const ButtonMask& a, const ButtonMask& b) { return { a.lo ^ b.lo, a.hi ^ b.hi }; }
+    friend ButtonMask operator&(const ButtonMask& a, const ButtonMask& b) { return { a.lo & b.lo, a.hi & b.hi }; }
+    friend ButtonMask operator|(const ButtonMask& a, const ButtonMask& b) { return { a.lo | b.lo, a.hi | b.hi }; }
+    friend ButtonMask operator~(const ButtonMask& a) { return { ~a.lo, ~a.hi }; }
+    ButtonMask& operator^=(const ButtonMask& other) { lo ^= other.lo; hi ^= other.hi; return *this; }
+    friend bool operator==(const ButtonMask& a, const ButtonMask& b) = default;
+
+private:
+    static uint64_t PackWord(const BYTE* bytes) {
+        uint64_t bits = 0;
+        for (int chunk = 0; chunk < 4; ++chunk) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + chunk * 16));
+            bits |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(v))) << (chunk * 16);
+        }
+        return bits;
+    }
+
+    template<typename Fn>
+    static void ForEachSetBitInWord(uint64_t bits, size_t base, Fn& fn) {
+        unsigned long index;
+        while (_BitScanForward64(&index, bits)) {
+            fn(base + index);
+            bits &= bits - 1; // Clear lowest set bit
+        }
+    }
+};
@@ -0,0 +1,319 @@
+#pragma once
+#include <windows.h>
+#include <array>
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+#include "Constants.h"
+#include "ButtonMask.h"
+
+/**
+ * @brief Flat, immutable key mapping table compiled from GamepadConfig
+ *
+ * Every key sequence lives in one packed WORD pool. Buttons, D-pad directions
+ * and analog sources (stick directions, triggers) are fixed-size slot arrays
+ * holding an offset/length into that pool, so a lookup is an array index
+ * returning a span: no hashing, no string keys and no allocation on the input
+ * path.
+ */
+class CompiledKeyMap {
+public:
+    static constexpr size_t MAX_BUTTONS = AppConstants::MAX_BUTTONS;
+    static constexpr size_t AXIS_DIRECTIONS = AppConstants::AXIS_DIRECTIONS;
+    static constexpr size_t ANALOG_SOURCES = ANALOG_SOURCE_COUNT;
+    static constexpr size_t MAX_CHORDS = 64; // One bit each in InputProcessor's chord state
+    static constexpr size_t MAX_TABLE_ENTRIES = 0xFFFF; // Key pool, macro steps, chord order: 16-bit offsets
+
+    // Offset/length of one key sequence in the pool
+    struct Slot {
+        uint16_t offset = 0;
+        uint16_t count = 0;
+    };
+
+    // Lookups (hot path). Out-of-range indices yield an empty span.
+    std::span<const WORD> buttonKeys(size_t buttonIndex) const {
+        return buttonIndex < MAX_BUTTONS ? view(m_buttons[buttonIndex]) : std::span<const WORD>{};
+    }
+    // Bit i set <=> button i has a non-empty key sequence, timed behaviour or is part of a chord
+    const ButtonMask& mappedButtons() const { return m_mappedButtons; }
+    std::span<const WORD> dpadKeys(size_t direction) const {
+        return direction < AXIS_DIRECTIONS ? view(m_dpad[direction]) : std::span<const WORD>{};
+    }
+    // Left stick directions are the first AXIS_DIRECTIONS analog sources
+    std::span<const WORD> stickKeys(size_t direction) const {
+        return direction < AXIS_DIRECTIONS ? view(m_analog[direction]) : std::span<const WORD>{};
+    }
+    std::span<const WORD> analogKeys(size_t source) const {
+        return source < ANALOG_SOURCES ? view(m_analog[source]) : std::span<const WORD>{};
+    }
+
+    // Timed behaviour (turbo / hold-to-repeat / macro), all durations in milliseconds
+    struct ButtonTiming {
+        uint16_t turboMs = 0;          // > 0: toggle the keys at this period while held
+        uint16_t repeatDelayMs = 0;    // With repeatIntervalMs > 0: re-press after this long
+        uint16_t repeatIntervalMs = 0;
+        uint16_t macroOffset = 0;      // Into the macro step table
+        uint16_t macroCount = 0;       // > 0: run these steps on press instead of holding the keys
+        uint16_t holdMs = 0;           // With holdKeys: held this long -> holdKeys, released earlier -> tap keys
+        Slot holdKeys;
+    };
+    struct MacroStep {
+        Slot keys;
+        uint16_t holdMs = 0; // Down -> up
+        uint16_t waitMs = 0; // Up -> next step
+    };
+    // Bit i set <=> button i has any timed behaviour
+    const ButtonMask& timedButtons() const { return m_timedButtons; }
+    const ButtonTiming& buttonTiming(size_t buttonIndex) const { return m_timing[buttonIndex < MAX_BUTTONS ? buttonIndex : 0]; }
+    std::span<const MacroStep> macroSteps(size_t buttonIndex) const {
+        if (buttonIndex >= MAX_BUTTONS) return {};
+        const ButtonTiming& timing = m_timing[buttonIndex];
+        return { m_macroSteps.data() + timing.macroOffset, timing.macroCount };
+    }
+    std::span<const WORD> stepKeys(const MacroStep& step) const { return view(step.keys); }
+    std::span<const WORD> holdKeys(size_t buttonIndex) const {
+        return buttonIndex < MAX_BUTTONS ? view(m_timing[buttonIndex].holdKeys) : std::span<const WORD>{};
+    }
+
+    // Multi-button chords, largest first (a chord wins over any smaller one sharing its buttons)
+    struct Chord {
+        ButtonMask buttons;
+        Slot keys;
+        uint16_t orderOffset = 0; // Ordered chords: button indices in required press order
+        uint16_t orderCount = 0;  // 0: any press order
+    };
+    std::span<const Chord> chords() const { return m_chords; }
+    std::span<const WORD> chordKeys(const Chord& chord) const { return view(chord.keys); }
+    std::span<const uint8_t> chordOrder(const Chord& chord) const {
+        return { m_chordOrder.data() + chord.orderOffset, chord.orderCount };
+    }
+
+    // Building (done once by ConfigManager::compileKeyMappings)
+    void clear() {
+        m_buttons.fill({});
+        m_mappedButtons = {};
+        m_dpad.fill({});
+        m_analog.fill({});
+        m_pool.clear();
+        m_timing.fill({});
+        m_timedButtons = {};
+        m_macroSteps.clear();
+        m_chords.clear();
+        m_chordOrder.clear();
+        m_chordButtons = {};
+        m_overflowed = false;
+    }
+    // A table outgrew MAX_TABLE_ENTRIES while building; the map must not be used
+    bool overflowed() const { return m_overflowed; }
+    void setButtonKeys(size_t buttonIndex, const std::vector<WORD>& keys) {
+        if (buttonIndex >= MAX_BUTTONS) return;
+        m_buttons[buttonIndex] = append(keys);
+        updateMasks(buttonIndex);
+    }
+    void setDpadKeys(size_t direction, const std::vector<WORD>& keys) {
+        if (direction < AXIS_DIRECTIONS) m_dpad[direction] = append(keys);
+    }
+    void setAnalogKeys(size_t source, const std::vector<WORD>& keys) {
+        if (source < ANALOG_SOURCES) m_analog[source] = append(keys);
+    }
+    void setButtonRepeat(size_t buttonIndex, uint16_t turboMs, uint16_t repeatDelayMs, uint16_t repeatIntervalMs) {
+        if (buttonIndex >= MAX_BUTTONS) return;
+        ButtonTiming& timing = m_timing[buttonIndex];
+        timing.turboMs = turboMs;
+        timing.repeatDelayMs = repeatDelayMs;
+        timing.repeatIntervalMs = repeatIntervalMs;
+        updateMasks(buttonIndex);
+    }
+    void setButtonHold(size_t buttonIndex, const std::vector<WORD>& keys, uint16_t holdMs) {
+        if (buttonIndex >= MAX_BUTTONS) return;
+        m_timing[buttonIndex].holdKeys = append(keys);
+        m_timing[buttonIndex].holdMs = keys.empty() ? 0 : (std::max<uint16_t>)(holdMs, 1);
+        updateMasks(buttonIndex);
+    }
+    // Chords need at least two distinct buttons; beyond MAX_CHORDS they are ignored.
+    // An ordered chord may not repeat a button (a button has one press time, so it could never match).
+    // Call sortChords() once all have been added.
+    bool addChord(const std::vector<size_t>& buttons, const std::vector<WORD>& keys, bool ordered) {
+        if (m_chords.size() >= MAX_CHORDS || keys.empty()) return false;
+        Chord chord;
+        for (size_t b : buttons) {
+            if (b >= MAX_BUTTONS || (ordered && chord.buttons.Test(b))) return false;
+            chord.buttons.Set(b);
+        }
+        if (std::popcount(chord.buttons.lo) + std::popcount(chord.buttons.hi) < 2) return false;
+        if (ordered && buttons.size() > MAX_TABLE_ENTRIES - m_chordOrder.size()) {
+            m_overflowed = true;
+            return false;
+        }
+        chord.keys = append(keys);
+        if (ordered) {
+            chord.orderOffset = static_cast<uint16_t>(m_chordOrder.size());
+            chord.orderCount = static_cast<uint16_t>(buttons.size());
+            for (size_t b : buttons) m_chordOrder.push_back(static_cast<uint8_t>(b));
+        }
+        m_chords.push_back(chord);
+        m_chordButtons = m_chordButtons | chord.buttons;
+        chord.buttons.ForEachSetBit([this](size_t b) { updateMasks(b); });
+        return true;
+    }
+    void sortChords() {
+        std::stable_sort(m_chords.begin(), m_chords.end(), [](const Chord& a, const Chord& b) {
+            return buttonCount(a.buttons) > buttonCount(b.buttons);
+        });
+    }
+
+    // A button's steps must be added back to back (they form one contiguous run);
+    // false when the step does not continue that run, or the tables are full
+    bool addMacroStep(size_t buttonIndex, const std::vector<WORD>& keys, uint16_t holdMs, uint16_t waitMs) {
+        if (buttonIndex >= MAX_BUTTONS) return false;
+        if (m_macroSteps.size() >= MAX_TABLE_ENTRIES) {
+            m_overflowed = true;
+            return false;
+        }
+        ButtonTiming& timing = m_timing[buttonIndex];
+        if (timing.macroCount == 0) {
+            timing.macroOffset = static_cast<uint16_t>(m_macroSteps.size());
+        } else if (timing.macroOffset + timing.macroCount != m_macroSteps.size()) {
+            return false;
+        }
+        m_macroSteps.push_back({ append(keys), holdMs, waitMs });
+        timing.macroCount++;
+        updateMasks(buttonIndex);
+        return true;
+    }
+
+    // Binary image for MappingCache: counts, the slot and timing tables, the key pool, then the
+    // macro steps. Native layout; the cache header's format version guards against layout changes.
+    void serialize(std::vector<uint8_t>& out) const {
+        const uint32_t counts[COUNT_FIELDS] = {
+            static_cast<uint32_t>(m_pool.size()), static_cast<uint32_t>(m_macroSteps.size()),
+            static_cast<uint32_t>(m_chords.size()), static_cast<uint32_t>(m_chordOrder.size()),
+        };
+        out.resize(imageSize(counts));
+        uint8_t* p = out.data();
+        p = put(p, counts, sizeof(counts));
+        p = put(p, m_buttons.data(), sizeof(m_buttons));
+        p = put(p, m_dpad.data(), sizeof(m_dpad));
+        p = put(p, m_analog.data(), sizeof(m_analog));
+        p = put(p, m_timing.data(), sizeof(m_timing));
+        p = put(p, m_pool.data(), m_pool.size() * sizeof(WORD));
+        p = put(p, m_macroSteps.data(), m_macroSteps.size() * sizeof(MacroStep));
+        p = put(p, m_chords.data(), m_chords.size() * sizeof(Chord));
+        put(p, m_chordOrder.data(), m_chordOrder.size());
+    }
+
+    // Rejects (and leaves the map cleared) any image whose slots point outside its tables
+    bool deserialize(std::span<const uint8_t> image) {
+        clear();
+        uint32_t counts[COUNT_FIELDS] = {};
+        if (image.size() < sizeof(counts)) return false;
+        const uint8_t* p = get(image.data(), counts, sizeof(counts));
+        if (counts[0] > MAX_TABLE_ENTRIES || counts[1] > MAX_TABLE_ENTRIES || counts[2] > MAX_CHORDS ||
+            counts[3] > MAX_TABLE_ENTRIES || image.size() != imageSize(counts)) return false;
+
+        p = get(p, m_buttons.data(), sizeof(m_buttons));
+        p = get(p, m_dpad.data(), sizeof(m_dpad));
+        p = get(p, m_analog.data(), sizeof(m_analog));
+        p = get(p, m_timing.data(), sizeof(m_timing));
+        m_pool.resize(counts[0]);
+        p = get(p, m_pool.data(), m_pool.size() * sizeof(WORD));
+        m_macroSteps.resize(counts[1]);
+        p = get(p, m_macroSteps.data(), m_macroSteps.size() * sizeof(MacroStep));
+        m_chords.resize(counts[2]);
+        p = get(p, m_chords.data(), m_chords.size() * sizeof(Chord));
+        m_chordOrder.resize(counts[3]);
+        get(p, m_chordOrder.data(), m_chordOrder.size());
+        for (const Chord& chord : m_chords) {
+            m_chordButtons = m_chordButtons | chord.buttons;
+        }
+
+        const size_t poolSize = m_pool.size();
+        auto valid = [poolSize](const Slot& slot) { return size_t{slot.offset} + slot.count <= poolSize; };
+        bool ok = true;
+        for (size_t i = 0; i < MAX_BUTTONS; ++i) {
+            ok = ok && valid(m_buttons[i]) && valid(m_timing[i].holdKeys) &&
+                 size_t{m_timing[i].macroOffset} + m_timing[i].macroCount <= m_macroSteps.size();
+            updateMasks(i);
+        }
+        for (size_t d = 0; d < AXIS_DIRECTIONS; ++d) {
+            ok = ok && valid(m_dpad[d]);
+        }
+        for (size_t a = 0; a < ANALOG_SOURCES; ++a) {
+            ok = ok && valid(m_analog[a]);
+        }
+        for (const MacroStep& step : m_macroSteps) {
+            ok = ok && valid(step.keys);
+        }
+        for (const Chord& chord : m_chords) {
+            ok = ok && valid(chord.keys) && size_t{chord.orderOffset} + chord.orderCount <= m_chordOrder.size();
+        }
+        for (uint8_t b : m_chordOrder) {
+            ok = ok && b < MAX_BUTTONS;
+        }
+        if (!ok) clear();
+        return ok;
+    }
+
+private:
+    static constexpr size_t TABLE_BYTES =
+        sizeof(Slot) * (MAX_BUTTONS + AXIS_DIRECTIONS + ANALOG_SOURCES) + sizeof(ButtonTiming) * MAX_BUTTONS;
+
+    static constexpr size_t COUNT_FIELDS = 4; // Pool, macro steps, chords, chord order bytes
+
+    static size_t imageSize(const uint32_t (&counts)[COUNT_FIELDS]) {
+        return sizeof(counts) + TABLE_BYTES + size_t{counts[0]} * sizeof(WORD) + size_t{counts[1]} * sizeof(MacroStep) +
+               size_t{counts[2]} * sizeof(Chord) + counts[3];
+    }
+
+    static int buttonCount(const ButtonMask& mask) {
+        return std::popcount(mask.lo) + std::popcount(mask.hi);
+    }
+
+    void updateMasks(size_t buttonIndex) {
+        const ButtonTiming& timing = m_timing[buttonIndex];
+        const bool timed = timing.turboMs != 0 || timing.repeatIntervalMs != 0 || timing.macroCount != 0 ||
+                           timing.holdMs != 0;
+        const bool mapped = timed || m_buttons[buttonIndex].count != 0 || m_chordButtons.Test(buttonIndex);
+        if (timed) m_timedButtons.Set(buttonIndex); else m_timedButtons.Reset(buttonIndex);
+        if (mapped) m_mappedButtons.Set(buttonIndex); else m_mappedButtons.Reset(buttonIndex);
+    }
+
+    static uint8_t* put(uint8_t* dst, const void* src, size_t bytes) {
+        if (bytes) std::memcpy(dst, src, bytes);
+        return dst + bytes;
+    }
+    static const uint8_t* get(const uint8_t* src, void* dst, size_t bytes) {
+        if (bytes) std::memcpy(dst, src, bytes);
+        return src + bytes;
+    }
+
+    std::span<const WORD> view(const Slot& slot) const {
+        return { m_pool.data() + slot.offset, slot.count };
+    }
+
+    Slot append(const std::vector<WORD>& keys) {
+        if (keys.size() > MAX_TABLE_ENTRIES - m_pool.size()) {
+            m_overflowed = true; // The offset would wrap and point at other keys
+            return {};
+        }
+        Slot slot{ static_cast<uint16_t>(m_pool.size()), static_cast<uint16_t>(keys.size()) };
+        m_pool.insert(m_pool.end(), keys.begin(), keys.end());
+        return slot;
+    }
+
+    std::array<Slot, MAX_BUTTONS> m_buttons{};
+    ButtonMask m_mappedButtons;
+    std::array<Slot, AXIS_DIRECTIONS> m_dpad{};   // Indexed by AxisDirection
+    std::array<Slot, ANALOG_SOURCES> m_analog{};  // Indexed by AnalogSource
+    std::vector<WORD> m_pool;
+    std::array<ButtonTiming, MAX_BUTTONS> m_timing{};
+    ButtonMask m_timedButtons;
+    std::vector<MacroStep> m_macroSteps;
+    std::vector<Chord> m_chords;
+    std::vector<uint8_t> m_chordOrder;
+    ButtonMask m_chordButtons; // Union of all chord buttons
+    bool m_overflowed = false;
+};
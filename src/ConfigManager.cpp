@@ -1,54 +1,90 @@
 #include "ConfigManager.h"
 #include "KeyResolver.h"
+#include "KeyScheduler.h"
+#include "MappingCache.h"
+#include "TextConversion.h"
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <nlohmann/json.hpp>
 #include <utility>
 
 using json = nlohmann::json;
 
 ConfigManager::ConfigManager(std::string configPath) 
-    : m_configPath(std::move(configPath)), m_loaded(false) {
+    : m_configPath(std::move(configPath)), m_configPathW(Text::Utf8ToWide(m_configPath)), m_loaded(false) {
 }
 
-bool ConfigManager::load() {
-    std::ifstream configFile(m_configPath);
+ConfigManager::LoadResult ConfigManager::load() {
+    // JSON 本体は一度だけ読み込み、キャッシュ検証と解析の両方に使う
+    std::ifstream configFile(m_configPath, std::ios::binary);
     if (!configFile.is_open()) {
         // ログに詳細な情報を出力
         std::string msg = "Config file cannot be opened: " + m_configPath;
         OutputDebugStringA(msg.c_str());
-        return false; // File doesn't exist or cannot be opened
+        std::error_code error;
+        return std::filesystem::exists(m_configPath, error) ? LoadResult::Invalid : LoadResult::NotFound;
     }
+    std::string text{ std::istreambuf_iterator<char>(configFile), std::istreambuf_iterator<char>() };
+    configFile.close();
 
-    try {
-        json j;
-        configFile >> j;
+    // キャッシュが JSON と一致すれば解析とキー名解決を丸ごと省略する
+    const MappingCache::SourceStamp stamp = MappingCache::MakeStamp(m_configPath, text);
+    std::string systemJson;
+    if (MappingCache::Load(m_configPath, stamp, systemJson, m_keyMap)) {
+        try {
+            m_system = json::parse(systemJson).get<SystemConfig>();
+            compileAnalogSettings();
+            m_gamepad = {};
+            m_fromCache = true;
+            m_loaded = true;
+            std::string cacheMsg = "Config loaded from cache: " + m_configPath;
+            OutputDebugStringA(cacheMsg.c_str());
+            return LoadResult::Loaded;
+        } catch (const json::exception&) {
+            // 壊れたキャッシュは無視して JSON から作り直す
+        }
+    }
 
-        // JSON構造をログに出力
-        std::string jsonStr = j.dump();
-        std::string logMsg = "JSON loaded: " + jsonStr.substr(0, 200) + "...";
-        OutputDebugStringA(logMsg.c_str());
+    try {
+        json j = json::parse(text);
 
         m_gamepad = j.at("gamepad").get<GamepadConfig>();
-        m_system = j.at("config").get<SystemConfig>();
+        const json& systemSection = j.at("config");
+        m_system = systemSection.get<SystemConfig>();
+        systemJson = systemSection.dump();
 
         // 読み込んだ設定をログに出力
         std::string configMsg = "Config loaded - Buttons: " + std::to_string(m_gamepad.buttons.size()) + 
                                ", Threshold: " + std::to_string(m_system.stick_threshold);
         OutputDebugStringA(configMsg.c_str());
 
-        compileKeyMappings();
+        if (!compileKeyMappings()) {
+            return LoadResult::Invalid;
+        }
+        compileAnalogSettings();
+        m_fromCache = false;
         m_loaded = true;
     } catch (const json::exception& e) {
         // Failed to parse JSON - 詳細なエラー情報をログに出力
         std::string errorMsg = "JSON parse error: " + std::string(e.what()) + " (file: " + m_configPath + ")";
         OutputDebugStringA(errorMsg.c_str());
-        return false;
+        return LoadResult::Invalid;
     }
 
-    return true;
+    // キャッシュの書き込み失敗は次回 JSON から読むだけなので無視する
+    MappingCache::Store(m_configPath, stamp, systemJson, m_keyMap);
+    return LoadResult::Loaded;
 }
 
 bool ConfigManager::save() const {
+    // キャッシュから読み込んだ場合はボタン設定の元データを持たないため書き戻せない
+    if (m_fromCache) {
+        OutputDebugStringA(("Config save skipped (loaded from cache): " + m_configPath).c_str());
+        return false;
+    }
+
     std::ofstream configFile(m_configPath);
     if (!configFile.is_open()) {
         return false;
@@ -65,8 +101,9 @@ bool ConfigManager::save() const {
 void ConfigManager::setConfig(const GamepadConfig& gamepad, const SystemConfig& system) {
     m_gamepad = gamepad;
     m_system = system;
-    compileKeyMappings();
-    m_loaded = true;
+    m_loaded = compileKeyMappings();
+    compileAnalogSettings();
+    m_fromCache = false;
 }
 
 std::pair<GamepadConfig, SystemConfig> ConfigManager::createDefaultConfig() {
@@ -92,57 +129,163 @@ std::pair<GamepadConfig, SystemConfig> ConfigManager::createDefaultConfig() {
     // Default System Config
     system.stick_threshold = 400;
     system.log_level = "info";
+    system.input_mode = "event";
+    system.display_mode = "window";
+    system.device_workers = 0;
+    system.poll_rate = 250;
+    system.idle_poll_rate = 20;
+    system.idle_timeout_ms = 5000;
+    system.config_hot_reload = true;
+    system.xinput = true;
+    system.hid_input = false;
+    system.record_directory = "";
+    system.replay_file = "";
+    system.replay_realtime = true;
+    system.profiles.clear();
+    system.metrics_shared_memory = "";
+    system.stick_deadzone = 0;
+    system.stick_deadzone_mode = "radial";
+    system.stick_hysteresis = 50;
+    system.trigger_threshold = 600;
+    system.trigger_hysteresis = -1;
+    system.analog_layout = "dinput";
 
     return {gamepad, system};
 }
 
-void ConfigManager::compileKeyMappings() {
-    m_buttonCache.clear();
-    m_dpadCache.clear();
-    m_stickCache.clear();
+SystemConfig ConfigManager::loadSystemConfig(const std::string& path) {
+    SystemConfig system;
+
+    std::ifstream configFile(path);
+    if (!configFile.is_open()) {
+        return system; // Optional file: defaults apply
+    }
+
+    try {
+        json j;
+        configFile >> j;
+        if (j.contains("config")) {
+            system = j.at("config").get<SystemConfig>();
+        }
+    } catch (const json::exception& e) {
+        // Logger is not up yet when this runs
+        std::string errorMsg = "System config parse error: " + std::string(e.what()) + " (file: " + path + ")";
+        OutputDebugStringA(errorMsg.c_str());
+    }
+
+    return system;
+}
+
+bool ConfigManager::compileKeyMappings() {
+    m_keyMap.clear();
 
-    // Compile buttons
+    // Compile buttons (indices outside [0, MAX_BUTTONS) can never fire and are dropped)
+    // ミリ秒は 0-65535 に丸める
+    auto toMs = [](int ms) { return static_cast<uint16_t>(std::clamp(ms, 0, 0xFFFF)); };
+    // タイマーで離すキー列は 1 イベントに収まる長さまでに切り詰める（超えた分は押したまま離せなくなる）
+    auto timedSequence = [this](const std::vector<std::string>& keys, size_t index) {
+        std::vector<WORD> vks = compileKeySequence(keys);
+        if (vks.size() > KeyScheduler::MAX_KEYS) {
+            std::string msg = "Timed key sequence on button " + std::to_string(index) + " cut to " +
+                              std::to_string(KeyScheduler::MAX_KEYS) + " keys: " + m_configPath;
+            OutputDebugStringA(msg.c_str());
+            vks.resize(KeyScheduler::MAX_KEYS);
+        }
+        return vks;
+    };
     for (const auto& button : m_gamepad.buttons) {
-        m_buttonCache[button.index] = compileKeySequence(button.keys);
+        if (button.index >= 0) {
+            const size_t index = static_cast<size_t>(button.index);
+            const bool timed = button.turbo_ms > 0 || button.repeat_interval_ms > 0 || !button.macro.empty() ||
+                               !button.hold.empty();
+            m_keyMap.setButtonKeys(index, timed ? timedSequence(button.keys, index) : compileKeySequence(button.keys));
+            m_keyMap.setButtonRepeat(index, toMs(button.turbo_ms), toMs(button.repeat_delay_ms),
+                                     toMs(button.repeat_interval_ms));
+            // 同じボタンが重複した場合、2 つ目のマクロは最初のものに混ざらないよう丸ごと捨てる
+            if (!button.macro.empty() && !m_keyMap.macroSteps(index).empty()) {
+                std::string msg = "Macro ignored (button " + std::to_string(index) +
+                                  " already has a macro): " + m_configPath;
+                OutputDebugStringA(msg.c_str());
+            } else {
+                for (const auto& step : button.macro) {
+                    if (!m_keyMap.addMacroStep(index, timedSequence(step.keys, index), toMs(step.hold_ms), toMs(step.wait_ms))) {
+                        break;
+                    }
+                }
+            }
+            if (!button.hold.empty()) {
+                m_keyMap.setButtonHold(index, timedSequence(button.hold, index), toMs(button.hold_ms));
+            }
+        }
     }
 
+    // Compile chords (invalid ones are skipped with a note in the debug output)
+    for (const auto& chord : m_gamepad.chords) {
+        std::vector<size_t> buttons;
+        bool validButtons = true;
+        for (int b : chord.buttons) {
+            validButtons = validButtons && b >= 0;
+            buttons.push_back(static_cast<size_t>((std::max)(b, 0)));
+        }
+        if (!validButtons || !m_keyMap.addChord(buttons, compileKeySequence(chord.keys), chord.ordered)) {
+            std::string msg = "Chord ignored (needs 2+ valid buttons, no repeats if ordered, and keys, max " +
+                              std::to_string(CompiledKeyMap::MAX_CHORDS) + "): " + m_configPath;
+            OutputDebugStringA(msg.c_str());
+        }
+    }
+    m_keyMap.sortChords();
+
     // Compile DPad
-    m_dpadCache["up"] = compileKeySequence(m_gamepad.dpad.up);
-    m_dpadCache["down"] = compileKeySequence(m_gamepad.dpad.down);
-    m_dpadCache["left"] = compileKeySequence(m_gamepad.dpad.left);
-    m_dpadCache["right"] = compileKeySequence(m_gamepad.dpad.right);
+    m_keyMap.setDpadKeys(AX_UP, compileKeySequence(m_gamepad.dpad.up));
+    m_keyMap.setDpadKeys(AX_DOWN, compileKeySequence(m_gamepad.dpad.down));
+    m_keyMap.setDpadKeys(AX_LEFT, compileKeySequence(m_gamepad.dpad.left));
+    m_keyMap.setDpadKeys(AX_RIGHT, compileKeySequence(m_gamepad.dpad.right));
 
     // Compile Left Stick
-    m_stickCache["up"] = compileKeySequence(m_gamepad.left_stick.up);
-    m_stickCache["down"] = compileKeySequence(m_gamepad.left_stick.down);
-    m_stickCache["left"] = compileKeySequence(m_gamepad.left_stick.left);
-    m_stickCache["right"] = compileKeySequence(m_gamepad.left_stick.right);
-}
+    m_keyMap.setAnalogKeys(AN_LSTICK_UP, compileKeySequence(m_gamepad.left_stick.up));
+    m_keyMap.setAnalogKeys(AN_LSTICK_DOWN, compileKeySequence(m_gamepad.left_stick.down));
+    m_keyMap.setAnalogKeys(AN_LSTICK_LEFT, compileKeySequence(m_gamepad.left_stick.left));
+    m_keyMap.setAnalogKeys(AN_LSTICK_RIGHT, compileKeySequence(m_gamepad.left_stick.right));
 
-std::vector<WORD> ConfigManager::compileKeySequence(const std::vector<std::string>& keys) const {
-    return KeyResolver::resolveSequence(keys);
-}
+    // Compile Right Stick / Triggers
+    m_keyMap.setAnalogKeys(AN_RSTICK_UP, compileKeySequence(m_gamepad.right_stick.up));
+    m_keyMap.setAnalogKeys(AN_RSTICK_DOWN, compileKeySequence(m_gamepad.right_stick.down));
+    m_keyMap.setAnalogKeys(AN_RSTICK_LEFT, compileKeySequence(m_gamepad.right_stick.left));
+    m_keyMap.setAnalogKeys(AN_RSTICK_RIGHT, compileKeySequence(m_gamepad.right_stick.right));
+    m_keyMap.setAnalogKeys(AN_LTRIGGER, compileKeySequence(m_gamepad.triggers.left));
+    m_keyMap.setAnalogKeys(AN_RTRIGGER, compileKeySequence(m_gamepad.triggers.right));
 
-std::vector<WORD> ConfigManager::getButtonKeys(int buttonIndex) const {
-    auto it = m_buttonCache.find(buttonIndex);
-    if (it != m_buttonCache.end()) {
-        return it->second;
+    // 16 ビットのオフセットが折り返すと別のキーを指すため、部分的な割り当ては使わない
+    if (m_keyMap.overflowed()) {
+        std::string errorMsg = "Mapping too large: more than " + std::to_string(CompiledKeyMap::MAX_TABLE_ENTRIES) +
+                               " keys, macro steps or chord entries (file: " + m_configPath + ")";
+        OutputDebugStringA(errorMsg.c_str());
+        m_keyMap.clear();
+        return false;
     }
-    return {}; // Return empty vector if not found
+    return true;
 }
 
-std::vector<WORD> ConfigManager::getDpadKeys(const std::string& direction) const {
-    auto it = m_dpadCache.find(direction);
-    if (it != m_dpadCache.end()) {
-        return it->second;
-    }
-    return {};
+void ConfigManager::compileAnalogSettings() {
+    // キャッシュ読み込み時も m_system から作り直す（キャッシュには含めない）
+    m_analog = {};
+    m_analog.deadzone = m_system.stick_deadzone;
+    m_analog.radialDeadzone = m_system.stick_deadzone_mode != "axial";
+    m_analog.stickPress = m_system.stick_threshold;
+    m_analog.stickRelease = m_system.stick_threshold - m_system.stick_hysteresis;
+    m_analog.triggerPress = m_system.trigger_threshold;
+    const int triggerHysteresis = m_system.trigger_hysteresis < 0 ? m_system.stick_hysteresis : m_system.trigger_hysteresis;
+    m_analog.triggerRelease = m_system.trigger_threshold - triggerHysteresis;
+    m_analog.layout = m_system.analog_layout == "xinput" ? AnalogLayout::XInput : AnalogLayout::DirectInput;
 }
 
-std::vector<WORD> ConfigManager::getStickKeys(const std::string& direction) const {
-    auto it = m_stickCache.find(direction);
-    if (it != m_stickCache.end()) {
-        return it->second;
+std::vector<WORD> ConfigManager::compileKeySequence(const std::vector<std::string>& keys) const {
+    return KeyResolver::resolveSequence(keys);
+}
+
+std::span<const WORD> ConfigManager::getButtonKeys(int buttonIndex) const {
+    if (buttonIndex < 0) {
+        return {};
     }
-    return {};
-}
\ No newline at end of file
+    return m_keyMap.buttonKeys(static_cast<size_t>(buttonIndex));
+}
@@ -4,20 +4,48 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <map>
 #include <optional>
 #include <span>
 #include <utility>
+#include "CompiledKeyMap.h"
+#include "AnalogEngine.h"
 
 using json = nlohmann::json;
 
 // ゲームパッド設定データ
 struct GamepadConfig {
+    // マクロの 1 ステップ: keys を押して hold_ms 後に離し、wait_ms 待って次へ
+    struct MacroStep {
+        std::vector<std::string> keys;
+        int hold_ms = 16;
+        int wait_ms = 0;
+        
+        NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(MacroStep, keys, hold_ms, wait_ms)
+    };
+    
     struct Button {
-        int index;
+        int index = -1;
         std::vector<std::string> keys;
+        int turbo_ms = 0;              // > 0: 押している間 keys をこの周期で連打
+        int repeat_delay_ms = 0;       // repeat_interval_ms > 0: この時間押し続けると keys を繰り返し押下
+        int repeat_interval_ms = 0;
+        std::vector<MacroStep> macro;  // 空でなければ押下時にこの手順を実行（keys より優先）
+        std::vector<std::string> hold; // 空でなければ hold_ms 以上の長押しで hold、それより短ければ keys をタップ
+        int hold_ms = 200;
         
-        // JSON自動変換サポート
-        NLOHMANN_DEFINE_TYPE_INTRUSIVE(Button, index, keys)
+        // JSON自動変換サポート（追加項目は省略可）
+        NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(Button, index, keys, turbo_ms, repeat_delay_ms,
+                                                    repeat_interval_ms, macro, hold, hold_ms)
+    };
+    
+    // 同時押し（例: LB+A）。成立中は構成ボタン単体の割り当ては出力しない
+    struct Chord {
+        std::vector<int> buttons;
+        std::vector<std::string> keys;
+        bool ordered = false; // true: buttons の順に押したときだけ成立
+        
+        NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(Chord, buttons, keys, ordered)
     };
     
     struct Stick {
@@ -32,19 +60,71 @@ struct GamepadConfig {
         NLOHMANN_DEFINE_TYPE_INTRUSIVE(DPad, up, down, left, right)
     };
     
+    // アナログトリガー（押し込み量が trigger_threshold を超えるとオン）
+    struct Triggers {
+        std::vector<std::string> left, right;
+        
+        NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(Triggers, left, right)
+    };
+    
     std::vector<Button> buttons;
     DPad dpad;
     Stick left_stick;
+    Stick right_stick; // 省略可（使う軸は analog_layout で決まる）
+    Triggers triggers; // 省略可
+    std::vector<Chord> chords; // 省略可
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(GamepadConfig, buttons, dpad, left_stick)
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(GamepadConfig, buttons, dpad, left_stick, right_stick, triggers, chords)
 };
 
 // システム設定
+// 既存の設定ファイルとの互換性のため、欠けている項目はデフォルト値で補う
 struct SystemConfig {
     int stick_threshold = 400;
     std::string log_level = "info";
+    std::string input_mode = "event"; // "event": バッファ入力+イベント通知, "poll": 毎フレーム GetDeviceState
+    std::string display_mode = "window"; // "window": 起動時に表示, "tray": 通知領域アイコンのみ（表示は要求時）
+    int device_workers = 0; // 0: 全デバイスを入力スレッドで順次処理, N: N 本のワーカーで並列処理
+    int poll_rate = 250; // イベント通知できないデバイスのポーリング周期 (Hz)。125/250/500/1000 など、上限 1000
+    int idle_poll_rate = 20; // 入力が途絶えている間のポーリング周期 (Hz)
+    int idle_timeout_ms = 5000; // この時間状態が変わらなければ idle_poll_rate に落とす。0: 落とさない
+    bool config_hot_reload = true; // gamepad_config_*.json の変更を検知して再起動なしで反映
+    bool xinput = true; // XInput 対応パッドは XInput で読む（同じパッドの DirectInput 側は使わない）
+    bool hid_input = false; // その他のパッドを HID から直接（オーバーラップ読み取りで）読む。高ポーリングレートのスティック向け
+    
+    // 入力の記録と再生（.gmrec）
+    std::string record_directory = ""; // 空でなければ、各デバイスの入力をこのフォルダに記録する
+    std::string replay_file = "";      // 空でなければ、この記録を再生する仮想デバイスを追加する
+    bool replay_realtime = true;       // true: 記録時の間隔で再生, false: できるだけ速く再生
+    
+    // アプリごとのプロファイル（前面ウィンドウの実行ファイル名 → プロファイル名、大文字小文字は区別しない）
+    // 例: {"game.exe": "fps"} なら game.exe が前面にある間 gamepad_config_<デバイス>@fps.json の割り当てを使う
+    std::map<std::string, std::string> profiles;
     
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(SystemConfig, stick_threshold, log_level)
+    // 外部ツール向けのメトリクス公開（名前付き共有メモリ、MetricsExport.h のレイアウト）
+    std::string metrics_shared_memory = ""; // 空でなければこの名前で公開する（例: "Local\\GamepadMapperMetrics"）
+    
+    // アナログ入力（値はすべて 0-1000 の軸スケール）
+    int stick_deadzone = 0;                     // 内側デッドゾーン。残りの範囲を 0-1000 に再スケール
+    std::string stick_deadzone_mode = "radial"; // "radial": スティックの傾き量で判定, "axial": 軸ごとに判定
+    int stick_hysteresis = 50;                  // 押下後は (しきい値 - この値) 以下になるまで離さない
+    int trigger_threshold = 600;                // "dinput" 配置では最低 500（Rx/Ry の無いパッドは中央値 = 500 を返すため）
+    int trigger_hysteresis = -1;                // トリガー用のヒステリシス。負なら stick_hysteresis と同じ
+    std::string analog_layout = "dinput";       // "dinput": 右スティック Z/Rz・トリガー Rx/Ry, "xinput": 右スティック Rx/Ry・トリガー Z 共有（XInput 経由のパッドでは無視）
+    
+    // ロガー設定（アプリ全体の gamepad_mapper.json から読み込む）
+    bool log_async = true;
+    int log_queue_size = 8192;
+    std::string log_overflow_policy = "discard_oldest"; // "discard_oldest" または "block"
+    int log_flush_interval_ms = 1000;                   // 0 で無効。spdlog は秒単位なので最も近い秒（最低 1 秒）に丸める
+    
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(SystemConfig, stick_threshold, log_level, input_mode,
+                                                display_mode, device_workers, poll_rate, idle_poll_rate, idle_timeout_ms,
+                                                config_hot_reload, xinput, hid_input,
+                                                record_directory, replay_file, replay_realtime, profiles, metrics_shared_memory,
+                                                stick_deadzone, stick_deadzone_mode, stick_hysteresis,
+                                                trigger_threshold, trigger_hysteresis, analog_layout,
+                                                log_async, log_queue_size, log_overflow_policy, log_flush_interval_ms)
 };
 
 // メイン設定クラス
@@ -60,51 +140,57 @@ public:
     ConfigManager& operator=(ConfigManager&&) = default;
     
     // メイン API
-    bool load();
+    // load は有効な MappingCache があればそれを使い、無ければ JSON を解析してキャッシュを書き出す
+    enum class LoadResult {
+        Loaded,
+        NotFound, // ファイルが存在しない（既定値で作成してよい）
+        Invalid,  // 読めない・解析できない・大きすぎる（ユーザーのファイルなので上書きしない）
+    };
+    LoadResult load();
     bool save() const;
     
     // クエリAPI（モダンで使いやすい）
-    std::vector<WORD> getButtonKeys(int buttonIndex) const;
-    std::vector<WORD> getDpadKeys(const std::string& direction) const;
-    std::vector<WORD> getStickKeys(const std::string& direction) const;
+    // 方向は AxisDirection（AX_LEFT/AX_RIGHT/AX_UP/AX_DOWN）
+    std::span<const WORD> getButtonKeys(int buttonIndex) const;
+    std::span<const WORD> getDpadKeys(size_t direction) const { return m_keyMap.dpadKeys(direction); }
+    std::span<const WORD> getStickKeys(size_t direction) const { return m_keyMap.stickKeys(direction); }
+    const CompiledKeyMap& getKeyMap() const { return m_keyMap; }
+    const AnalogSettings& getAnalogSettings() const { return m_analog; }
     
     int getStickThreshold() const { return m_system.stick_threshold; }
     std::string getLogLevel() const { return m_system.log_level; }
+    bool isEventDriven() const { return m_system.input_mode != "poll"; }
     
     // ユーティリティ
     bool isLoaded() const { return m_loaded; }
-    std::string getConfigPath() const { return m_configPath; }
-    std::wstring getConfigFilePath() const { 
-        int size = MultiByteToWideChar(CP_UTF8, 0, m_configPath.c_str(), -1, nullptr, 0);
-        if (size > 0) {
-            std::wstring wpath(size - 1, L'\0');
-            MultiByteToWideChar(CP_UTF8, 0, m_configPath.c_str(), -1, &wpath[0], size);
-            return wpath;
-        }
-        return L"";
-    }
+    const std::string& getConfigPath() const { return m_configPath; }
+    const std::wstring& getConfigFilePath() const { return m_configPathW; } // 構築時に一度だけ変換
 
     // 設定のセッター
     void setConfig(const GamepadConfig& gamepad, const SystemConfig& system);
 
     // 静的メソッド
     static std::pair<GamepadConfig, SystemConfig> createDefaultConfig();
+    // アプリ全体の設定（{"config": {...}}）。ファイルが無い・壊れている場合はデフォルト値
+    static SystemConfig loadSystemConfig(const std::string& path);
 
 private:
     // 内部処理
-    void compileKeyMappings();
+    bool compileKeyMappings(); // false: the mapping does not fit the compiled tables
+    void compileAnalogSettings();
     std::vector<WORD> compileKeySequence(const std::vector<std::string>& keys) const;
     
     // データ
     GamepadConfig m_gamepad;
     SystemConfig m_system;
     
-    // コンパイル済みキャッシュ（パフォーマンス向上）
-    std::unordered_map<int, std::vector<WORD>> m_buttonCache;
-    std::unordered_map<std::string, std::vector<WORD>> m_dpadCache;
-    std::unordered_map<std::string, std::vector<WORD>> m_stickCache;
+    // コンパイル済みテーブル（ホットパスはハッシュ・アロケーションなし）
+    CompiledKeyMap m_keyMap;
+    AnalogSettings m_analog;
     
     // 状態
     std::string m_configPath;
+    std::wstring m_configPathW;
     bool m_loaded = false;
+    bool m_fromCache = false; // MappingCache から復元（m_gamepad は空）
 };
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "ConfigWatcher.h"
+#include "ConfigManager.h"
+#include "Logger.h"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+// =====================================
+// ConfigUpdate
+// =====================================
+
+ConfigUpdate::ConfigUpdate(std::string configPath)
+    : m_configPath(std::move(configPath))
+    , m_fileName(std::filesystem::path(m_configPath).filename().wstring())
+{
+}
+
+ConfigUpdate::~ConfigUpdate()
+{
+    delete m_pending.exchange(nullptr, std::memory_order_acquire);
+}
+
+void ConfigUpdate::Publish(std::unique_ptr<ConfigManager> config)
+{
+    // A superseded update was never seen by the owner and can go right away
+    delete m_pending.exchange(config.release(), std::memory_order_acq_rel);
+}
+
+std::unique_ptr<ConfigManager> ConfigUpdate::Take()
+{
+    if (!m_pending.load(std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return std::unique_ptr<ConfigManager>(m_pending.exchange(nullptr, std::memory_order_acquire));
+}
+
+// =====================================
+// ConfigWatcher
+// =====================================
+
+ConfigWatcher::~ConfigWatcher()
+{
+    Stop();
+}
+
+bool ConfigWatcher::Start(const std::wstring& directory)
+{
+    if (IsRunning()) {
+        return true;
+    }
+
+    m_directory.reset(CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                  OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr));
+    if (m_directory.get() == INVALID_HANDLE_VALUE) {
+        m_directory.release();
+        LOG_WARN("Config hot-reload disabled: cannot open config directory (error {}).", GetLastError());
+        return false;
+    }
+
+    m_changeEvent.reset(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    m_stopEvent.reset(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    if (!m_changeEvent || !m_stopEvent || !IssueRead()) {
+        LOG_WARN("Config hot-reload disabled: cannot watch config directory (error {}).", GetLastError());
+        Stop();
+        return false;
+    }
+
+    try {
+        m_thread = std::thread(&ConfigWatcher::ThreadMain, this);
+    } catch (const std::system_error& e) {
+        LOG_ERROR("Failed to start config watcher thread: {}", e.what());
+        Stop();
+        return false;
+    }
+
+    LOG_INFO_W(L"Watching for configuration changes in: " + directory);
+    return true;
+}
+
+void ConfigWatcher::Stop()
+{
+    if (m_stopEvent) {
+        SetEvent(m_stopEvent.get());
+    }
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    if (m_directory && m_readPending) {
+        // The pending read references m_changeBuffer: cancel it and wait before releasing anything
+        CancelIoEx(m_directory.get(), &m_overlapped);
+        DWORD ignored = 0;
+        GetOverlappedResult(m_directory.get(), &m_overlapped, &ignored, TRUE);
+        m_readPending = false;
+    }
+    m_directory.reset();
+    m_changeEvent.reset();
+    m_stopEvent.reset();
+}
+
+std::shared_ptr<ConfigUpdate> ConfigWatcher::Register(const std::string& configPath)
+{
+    auto update = std::make_shared<ConfigUpdate>(configPath);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::erase_if(m_targets, [](const std::weak_ptr<ConfigUpdate>& target) { return target.expired(); });
+    m_targets.push_back(update);
+    return update;
+}
+
+bool ConfigWatcher::IssueRead()
+{
+    ResetEvent(m_changeEvent.get());
+    m_overlapped = OVERLAPPED{};
+    m_overlapped.hEvent = m_changeEvent.get();
+
+    m_readPending = ReadDirectoryChangesW(m_directory.get(), m_changeBuffer, CHANGE_BUFFER_SIZE, FALSE,
+                                          FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                          nullptr, &m_overlapped, nullptr) != FALSE;
+    return m_readPending;
+}
+
+void ConfigWatcher::CollectChangedFiles(std::vector<std::wstring>& names) const
+{
+    const BYTE* cursor = m_changeBuffer;
+    for (;;) {
+        const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(cursor);
+        if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED ||
+            info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+            if (std::find(names.begin(), names.end(), name) == names.end()) {
+                names.push_back(std::move(name));
+            }
+        }
+        if (info->NextEntryOffset == 0) {
+            break;
+        }
+        cursor += info->NextEntryOffset;
+    }
+}
+
+void ConfigWatcher::ThreadMain()
+{
+    HANDLE handles[] = { m_stopEvent.get(), m_changeEvent.get() };
+    std::vector<std::wstring> changed;
+
+    for (;;) {
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, changed.empty() ? INFINITE : SETTLE_MS);
+        if (result == WAIT_OBJECT_0 || result == WAIT_FAILED) {
+            break;
+        }
+
+        if (result == WAIT_TIMEOUT) {
+            // No further writes within the settle time: the files should be complete now
+            ReloadChangedFiles(changed);
+            changed.clear();
+            continue;
+        }
+
+        DWORD bytes = 0;
+        const BOOL completed = GetOverlappedResult(m_directory.get(), &m_overlapped, &bytes, FALSE);
+        const DWORD error = completed ? ERROR_SUCCESS : GetLastError();
+        m_readPending = false;
+        if (!completed && error != ERROR_NOTIFY_ENUM_DIR) {
+            // A failed read says nothing about the files; report it and watch again
+            LOG_WARN("Config change notification failed (error {}).", error);
+        } else if (completed && bytes > 0) {
+            CollectChangedFiles(changed);
+        } else {
+            // Buffer overflowed (no entries, or ERROR_NOTIFY_ENUM_DIR): changes were lost, so reload everything registered
+            LOG_DEBUG("Config change buffer overflow; reloading all watched files.");
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (const auto& target : m_targets) {
+                if (auto update = target.lock()) {
+                    changed.push_back(update->GetFileName());
+                }
+            }
+        }
+
+        if (!IssueRead()) {
+            LOG_ERROR("ReadDirectoryChangesW failed (error {}); config hot-reload stopped.", GetLastError());
+            break;
+        }
+    }
+}
+
+void ConfigWatcher::ReloadChangedFiles(const std::vector<std::wstring>& names)
+{
+    std::vector<std::shared_ptr<ConfigUpdate>> targets;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& target : m_targets) {
+            auto update = target.lock();
+            if (!update) continue;
+            const bool matches = std::any_of(names.begin(), names.end(), [&](const std::wstring& name) {
+                return _wcsicmp(name.c_str(), update->GetFileName().c_str()) == 0;
+            });
+            if (matches) {
+                targets.push_back(std::move(update));
+            }
+        }
+    }
+
+    // Parse and compile here, off the input path; the device only swaps a pointer
+    for (const auto& update : targets) {
+        auto config = std::make_unique<ConfigManager>(update->GetConfigPath());
+        if (config->load() != ConfigManager::LoadResult::Loaded) {
+            LOG_WARN("Reload of {} failed; keeping the current mapping.", update->GetConfigPath());
+            continue;
+        }
+        update->Publish(std::move(config));
+        LOG_INFO("Configuration reloaded from {}", update->GetConfigPath());
+    }
+}
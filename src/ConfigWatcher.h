@@ -0,0 +1,87 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Win32Handle.h"
+
+class ConfigManager;
+
+/**
+ * @brief Single-slot mailbox for a reloaded configuration
+ *
+ * The watcher thread publishes a fully loaded and compiled ConfigManager with
+ * one atomic pointer exchange; the owning device takes it between frames with
+ * another. The owner is the only reader of its live configuration, so the old
+ * one can be destroyed as soon as it has been swapped out (no locks on the
+ * input path, no grace period to wait for).
+ */
+class ConfigUpdate {
+public:
+    explicit ConfigUpdate(std::string configPath);
+    ~ConfigUpdate();
+
+    ConfigUpdate(const ConfigUpdate&) = delete;
+    ConfigUpdate& operator=(const ConfigUpdate&) = delete;
+
+    const std::string& GetConfigPath() const { return m_configPath; }
+    const std::wstring& GetFileName() const { return m_fileName; }
+
+    // Watcher thread: replaces any update the owner has not picked up yet
+    void Publish(std::unique_ptr<ConfigManager> config);
+    // Owner thread: nullptr when nothing new was published (one relaxed load in that case)
+    std::unique_ptr<ConfigManager> Take();
+
+private:
+    std::string m_configPath;
+    std::wstring m_fileName; // File name part, as reported by ReadDirectoryChangesW
+    std::atomic<ConfigManager*> m_pending{ nullptr };
+};
+
+/**
+ * @brief Watches the configuration directory and reloads changed device configs
+ *
+ * A background thread waits on ReadDirectoryChangesW. When a registered file
+ * is written, it is re-parsed and compiled there (ConfigManager::load) and
+ * published to the file's ConfigUpdate. Files that fail to load keep the
+ * previous configuration.
+ */
+class ConfigWatcher {
+public:
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    bool Start(const std::wstring& directory);
+    void Stop();
+    bool IsRunning() const { return m_thread.joinable(); }
+
+    // Returns the mailbox for configPath; the watcher only keeps a weak reference,
+    // so dropping the returned pointer unregisters the file
+    std::shared_ptr<ConfigUpdate> Register(const std::string& configPath);
+
+private:
+    void ThreadMain();
+    bool IssueRead();
+    void CollectChangedFiles(std::vector<std::wstring>& names) const;
+    void ReloadChangedFiles(const std::vector<std::wstring>& names);
+
+    static constexpr DWORD CHANGE_BUFFER_SIZE = 16 * 1024;
+    static constexpr DWORD SETTLE_MS = 200; // Editors write a file in several steps
+
+    UniqueHandle m_directory;
+    UniqueHandle m_changeEvent;
+    UniqueHandle m_stopEvent;
+    OVERLAPPED m_overlapped{};
+    bool m_readPending = false;
+    alignas(DWORD) BYTE m_changeBuffer[CHANGE_BUFFER_SIZE];
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::vector<std::weak_ptr<ConfigUpdate>> m_targets;
+};
@@ -6,18 +6,41 @@ namespace AppConstants {
     // Window settings
     constexpr int WINDOW_WIDTH = 800;
     constexpr int WINDOW_HEIGHT = 600;
-    constexpr DWORD FRAME_SLEEP_MS = 10;
+    constexpr DWORD EVENT_WAIT_TIMEOUT_MS = 100; // Upper bound on blocking so hot-plug results/reconnects still run
+    
+    // Input thread settings
+    constexpr const wchar_t* INPUT_THREAD_MMCSS_TASK = L"Games";
+    constexpr DWORD_PTR INPUT_THREAD_AFFINITY_MASK = 0; // 0 = let the scheduler pick a core
     
     // Input configuration
     constexpr size_t MAX_BUTTONS = 128;
     constexpr size_t AXIS_DIRECTIONS = 4;
     constexpr LONG AXIS_THRESHOLD_DEFAULT = 400;
+    constexpr LONG AXIS_HYSTERESIS_DEFAULT = 50;   // Release band below the press threshold
+    constexpr LONG TRIGGER_THRESHOLD_DEFAULT = 600; // Analog triggers, 0 (rest) .. 1000 (full)
+    constexpr DWORD TAP_KEY_DURATION_MS = 16;       // Down time of the keys a tap-vs-hold button taps
+    constexpr LONG AXIS_ACTIVITY_DELTA = 30;        // Axis movement that counts as activity (adaptive poll rate)
     
     // DirectInput settings
     constexpr LONG AXIS_RANGE_MIN = -1000;
     constexpr LONG AXIS_RANGE_MAX = 1000;
+    constexpr DWORD INPUT_BUFFER_SIZE = 64; // DIPROP_BUFFERSIZE for event-driven devices
+    constexpr ULONG HID_INPUT_BUFFER_COUNT = 128; // Input reports the HID driver queues per reader (2..512)
+    
+    // Device hot-plug settings
+    constexpr DWORD DEVICE_CHANGE_SETTLE_MS = 250;   // Coalesce the burst of notifications one plug-in produces
+    constexpr DWORD DEVICE_RESCAN_FALLBACK_MS = 5000; // Periodic background scan if notifications are unavailable
+    constexpr DWORD RECONNECT_INITIAL_DELAY_MS = 250;
+    constexpr DWORD RECONNECT_MAX_DELAY_MS = 30000;
+    
+    // Input recording settings
+    constexpr size_t RECORDING_CHUNK_BYTES = 64 * 1024;   // A chunk is sealed once it reaches this size...
+    constexpr DWORD RECORDING_CHUNK_MAX_AGE_MS = 1000;    // ...or spans this long (bounds what a crash loses)
+    constexpr size_t REPLAY_FAST_STATES_PER_FRAME = 64;   // As-fast-as-possible replay, per frame
     
     // Logging settings
+    constexpr DWORD LATENCY_LOG_INTERVAL_MS = 60000; // Periodic latency histogram dump
+    constexpr DWORD METRICS_PUBLISH_INTERVAL_MS = 250; // Shared-memory metrics snapshot
     constexpr size_t LOG_BUFFER_SIZE = 1024;
     constexpr size_t FRAME_LOG_MAX_LINES = 50;
 }
@@ -28,4 +51,19 @@ enum AxisDirection {
     AX_RIGHT = 1, 
     AX_UP = 2, 
     AX_DOWN = 3 
-};
\ No newline at end of file
+};
+
+// Analog half-axis sources (AnalogEngine). The left stick block matches AxisDirection.
+enum AnalogSource {
+    AN_LSTICK_LEFT = 0,
+    AN_LSTICK_RIGHT = 1,
+    AN_LSTICK_UP = 2,
+    AN_LSTICK_DOWN = 3,
+    AN_RSTICK_LEFT = 4,
+    AN_RSTICK_RIGHT = 5,
+    AN_RSTICK_UP = 6,
+    AN_RSTICK_DOWN = 7,
+    AN_LTRIGGER = 8,
+    AN_RTRIGGER = 9,
+    ANALOG_SOURCE_COUNT = 10
+};
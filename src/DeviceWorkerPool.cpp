@@ -0,0 +1,113 @@
+#include "DeviceWorkerPool.h"
+#include "Constants.h"
+#include "Logger.h"
+#include <avrt.h>
+#include <algorithm>
+#include <exception>
+#include <system_error>
+
+DeviceWorkerPool::DeviceWorkerPool(size_t workerCount)
+{
+    m_workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        try {
+            m_workers.emplace_back(&DeviceWorkerPool::WorkerMain, this);
+        } catch (const std::system_error& e) {
+            LOG_ERROR("Failed to start device worker {}: {}", i, e.what());
+            break;
+        }
+    }
+    LOG_INFO("Device worker pool started with {} workers.", m_workers.size());
+}
+
+DeviceWorkerPool::~DeviceWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workReady.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void DeviceWorkerPool::RunErased(size_t count, void* context, Invoker invoke)
+{
+    if (count == 0) {
+        return;
+    }
+    count = (std::min)(count, MAX_ITEMS);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_context = context;
+        m_invoke = invoke;
+        m_remaining.store(count, std::memory_order_relaxed);
+        m_jobGeneration++;
+        // Publishes the job, including to workers still spinning in Drain from the last one
+        m_cursor.store((m_jobGeneration << 32) | (static_cast<uint64_t>(count) << 16), std::memory_order_release);
+    }
+    m_workReady.notify_all();
+
+    // The calling thread works too, so a pool of N serves N + 1 devices at once
+    Drain();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_workDone.wait(lock, [this] { return m_remaining.load(std::memory_order_acquire) == 0; });
+}
+
+void DeviceWorkerPool::Drain()
+{
+    uint64_t cursor = m_cursor.load(std::memory_order_acquire);
+    for (;;) {
+        const size_t count = static_cast<size_t>((cursor >> 16) & 0xFFFF);
+        const size_t index = static_cast<size_t>(cursor & 0xFFFF);
+        if (index >= count) {
+            return;
+        }
+        if (!m_cursor.compare_exchange_weak(cursor, cursor + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            continue; // Lost the race (or a new job was published): retry with the fresh cursor
+        }
+
+        try {
+            m_invoke(m_context, index);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Device worker task failed: {}", e.what());
+        }
+
+        if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_workDone.notify_one();
+        }
+        cursor = m_cursor.load(std::memory_order_acquire);
+    }
+}
+
+void DeviceWorkerPool::WorkerMain()
+{
+    DWORD taskIndex = 0;
+    HANDLE mmcssHandle = AvSetMmThreadCharacteristicsW(AppConstants::INPUT_THREAD_MMCSS_TASK, &taskIndex);
+    if (!mmcssHandle) {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+    }
+
+    uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workReady.wait(lock, [&] { return m_stopping || m_jobGeneration != seenGeneration; });
+            if (m_stopping) {
+                break;
+            }
+            seenGeneration = m_jobGeneration;
+        }
+        Drain();
+    }
+
+    if (mmcssHandle) {
+        AvRevertMmThreadCharacteristics(mmcssHandle);
+    }
+}
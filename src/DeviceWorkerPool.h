@@ -0,0 +1,57 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Small fork/join pool for per-device input processing
+ *
+ * Run() hands out item indices to the workers (and the calling thread)
+ * through an atomic counter and returns once every item has been processed,
+ * so a slow device only holds up the thread that picked it. Workers run with
+ * the same MMCSS class as the input thread.
+ */
+class DeviceWorkerPool {
+public:
+    explicit DeviceWorkerPool(size_t workerCount);
+    ~DeviceWorkerPool();
+
+    DeviceWorkerPool(const DeviceWorkerPool&) = delete;
+    DeviceWorkerPool& operator=(const DeviceWorkerPool&) = delete;
+
+    size_t GetWorkerCount() const { return m_workers.size(); }
+
+    static constexpr size_t MAX_ITEMS = 0xFFFF;
+
+    // Calls fn(i) once for every i in [0, count); blocks until all calls returned.
+    // fn is borrowed for the duration of the call (no allocation per frame).
+    template<typename Fn>
+    void Run(size_t count, Fn& fn) {
+        RunErased(count, &fn, [](void* context, size_t index) { (*static_cast<Fn*>(context))(index); });
+    }
+
+private:
+    using Invoker = void (*)(void* context, size_t index);
+
+    void RunErased(size_t count, void* context, Invoker invoke);
+    void WorkerMain();
+    void Drain();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_workReady;
+    std::condition_variable m_workDone;
+    uint64_t m_jobGeneration = 0; // Bumped per Run; workers wake on change
+    bool m_stopping = false;
+
+    // Current job. The cursor packs [generation:32][count:16][next:16] so a
+    // worker can never claim an index of one job against another job's count.
+    void* m_context = nullptr;
+    Invoker m_invoke = nullptr;
+    std::atomic<uint64_t> m_cursor{ 0 };
+    std::atomic<size_t> m_remaining{ 0 };
+};
@@ -0,0 +1,362 @@
+#include "DirectInputDevice.h"
+#include "ConfigManager.h"
+#include "InputProcessor.h"
+#include "Logger.h"
+#include <cstddef>
+#include <cstring>
+
+DirectInputDevice::~DirectInputDevice()
+{
+    Shutdown();
+}
+
+bool DirectInputDevice::Initialize(IDirectInput8* pDirectInput, const DIDEVICEINSTANCE* deviceInstance, HWND hWnd)
+{
+    if (m_initialized) {
+        return true;
+    }
+    
+    m_directInput = pDirectInput;
+    
+    // Store device information
+    m_deviceName = deviceInstance->tszProductName;
+    m_deviceInstanceName = deviceInstance->tszInstanceName;
+    m_deviceGUID = deviceInstance->guidInstance;
+    
+    // Create device
+    HRESULT hr = pDirectInput->CreateDevice(deviceInstance->guidInstance, m_device.GetAddressOf(), nullptr);
+    if (FAILED(hr)) {
+        LOG_ERROR_W(L"Failed to create device: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
+        return false;
+    }
+    
+    // Load configuration (the input mode decides how the device is configured)
+    if (!LoadConfiguration()) {
+        LOG_ERROR_W(L"Failed to load configuration for device: " + m_deviceName);
+        return false;
+    }
+    
+    // Configure device
+    if (!ConfigureDevice(hWnd)) {
+        LOG_ERROR_W(L"Failed to configure device: " + m_deviceName);
+        return false;
+    }
+    
+    // Initialize input processor
+    CreateInputProcessor();
+    
+    // Try to acquire device
+    if (!AcquireDevice()) {
+        LOG_WARN_W(L"Initial device acquisition failed for: " + m_deviceName + L" (may work in background)");
+    }
+    
+    m_initialized = true;
+    m_connected = true;
+    
+    LOG_INFO_W(L"GamepadDevice initialized successfully: " + m_deviceName + L" (" + m_deviceInstanceName + L")" +
+               (m_eventDriven ? L" [event-driven]" : L" [polling]"));
+    
+    return true;
+}
+
+void DirectInputDevice::CloseDevice()
+{
+    UnacquireDevice();
+    m_device.Reset();
+    m_inputEvent.reset();
+}
+
+bool DirectInputDevice::ConfigureDevice(HWND hWnd)
+{
+    if (!m_device) {
+        return false;
+    }
+    
+    // Set data format to joystick (DIJOYSTATE2)
+    HRESULT hr = m_device->SetDataFormat(&c_dfDIJoystick2);
+    if (FAILED(hr)) {
+        LOG_ERROR("SetDataFormat failed. HRESULT: 0x{:08X}", hr);
+        return false;
+    }
+    
+    // Set cooperative level
+    hr = m_device->SetCooperativeLevel(hWnd, DISCL_BACKGROUND | DISCL_NONEXCLUSIVE);
+    if (FAILED(hr)) {
+        LOG_ERROR("SetCooperativeLevel failed. HRESULT: 0x{:08X}", hr);
+        return false;
+    }
+    
+    // Set axis ranges
+    SetAxisRanges();
+    
+    // Buffered input and event notification must be configured before Acquire
+    m_eventDriven = m_configManager && m_configManager->isEventDriven() && EnableEventNotification();
+    m_needsResync = true;
+    
+    return true;
+}
+
+bool DirectInputDevice::EnableEventNotification()
+{
+    DIPROPDWORD bufferSize;
+    bufferSize.diph.dwSize = sizeof(DIPROPDWORD);
+    bufferSize.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+    bufferSize.diph.dwObj = 0;
+    bufferSize.diph.dwHow = DIPH_DEVICE;
+    bufferSize.dwData = AppConstants::INPUT_BUFFER_SIZE;
+    
+    HRESULT hr = m_device->SetProperty(DIPROP_BUFFERSIZE, &bufferSize.diph);
+    if (FAILED(hr)) {
+        LOG_WARN("DIPROP_BUFFERSIZE failed, falling back to polling. HRESULT: 0x{:08X}", hr);
+        return false;
+    }
+    
+    if (!m_inputEvent) {
+        // Auto-reset: one wake-up per batch of new records
+        m_inputEvent.reset(CreateEventW(nullptr, FALSE, FALSE, nullptr));
+        if (!m_inputEvent) {
+            LOG_WARN("CreateEvent failed, falling back to polling. Error: {}", GetLastError());
+            return false;
+        }
+    }
+    
+    hr = m_device->SetEventNotification(m_inputEvent.get());
+    if (FAILED(hr) || hr == DI_POLLEDDEVICE) {
+        // Polled devices never signal the event on their own
+        m_device->SetEventNotification(nullptr);
+        LOG_WARN_W(L"Event notification not supported, falling back to polling: " + m_deviceName);
+        return false;
+    }
+    
+    return true;
+}
+
+void DirectInputDevice::SetAxisRanges()
+{
+    if (!m_device) return;
+    
+    DIPROPRANGE range;
+    range.diph.dwSize = sizeof(DIPROPRANGE);
+    range.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+    range.diph.dwHow = DIPH_BYOFFSET;
+    range.lMin = -1000;
+    range.lMax = 1000;
+    
+    // Set ranges for all axes
+    const DWORD axes[] = { DIJOFS_X, DIJOFS_Y, DIJOFS_Z, DIJOFS_RX, DIJOFS_RY, DIJOFS_RZ };
+    
+    for (DWORD axis : axes) {
+        range.diph.dwObj = axis;
+        m_device->SetProperty(DIPROP_RANGE, &range.diph);
+    }
+    
+    LOG_DEBUG_W(L"Axis ranges set to [-1000, 1000] for device: " + m_deviceName);
+}
+
+bool DirectInputDevice::AcquireDevice()
+{
+    if (!m_device) {
+        return false;
+    }
+    
+    HRESULT hr = m_device->Acquire();
+    if (SUCCEEDED(hr)) {
+        m_acquired = true;
+        m_needsResync = true;
+        LOG_DEBUG_W(L"Device acquired successfully: " + m_deviceName);
+        return true;
+    } else {
+        m_acquired = false;
+        LOG_WARN_W(L"Device acquisition failed: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
+        return false;
+    }
+}
+
+void DirectInputDevice::UnacquireDevice()
+{
+    if (m_device && m_acquired) {
+        m_device->Unacquire();
+        m_acquired = false;
+        LOG_DEBUG_W(L"Device unacquired: " + m_deviceName);
+    }
+}
+
+bool DirectInputDevice::PollDevice()
+{
+    if (!m_device || !m_initialized) {
+        m_connected = false;
+        return false;
+    }
+    
+    HRESULT hr = m_device->Poll();
+    if (FAILED(hr)) {
+        hr = m_device->Acquire();
+        if (FAILED(hr)) {
+            if (hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED) {
+                LOG_WARN_W(L"Device lost or not acquired: " + m_deviceName + L". Trying to reconnect.");
+                m_connected = false;
+            }
+            return false;
+        }
+        // Anything buffered before the loss is gone
+        m_needsResync = true;
+    }
+    
+    return true;
+}
+
+bool DirectInputDevice::PollAndGetState()
+{
+    if (!PollDevice()) {
+        return false;
+    }
+    
+    HRESULT hr = m_device->GetDeviceState(sizeof(DIJOYSTATE2), &m_currentState);
+    m_latency.OnRead(Qpc::Now());
+    m_latency.OnEventTimestamp(0); // Snapshots carry no hardware timestamp
+    if (FAILED(hr)) {
+        LOG_ERROR_W(L"GetDeviceState failed for device: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
+        if (hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED || hr == DIERR_UNPLUGGED) {
+            LOG_WARN_W(L"Device is unplugged or lost: " + m_deviceName);
+            m_connected = false;
+            UnacquireDevice();
+        }
+        return false;
+    }
+    
+    return true;
+}
+
+bool DirectInputDevice::TryToReconnect(HWND hWnd)
+{
+    if (!m_directInput || m_connected) {
+        return m_connected;
+    }
+    
+    LOG_INFO_W(L"Attempting to reconnect device: " + m_deviceName);
+    
+    // Try to recreate the device
+    HRESULT hr = m_directInput->CreateDevice(m_deviceGUID, m_device.GetAddressOf(), nullptr);
+    if (FAILED(hr)) {
+        LOG_ERROR_W(L"Failed to recreate device: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
+        return false;
+    }
+    
+    // Reconfigure device
+    if (!ConfigureDevice(hWnd)) {
+        LOG_ERROR_W(L"Failed to reconfigure device: " + m_deviceName);
+        m_device.Reset();
+        return false;
+    }
+    
+    // Try to acquire
+    if (AcquireDevice()) {
+        m_connected = true;
+        ResetReconnectBackoff();
+        LOG_INFO_W(L"Device reconnected successfully: " + m_deviceName);
+        return true;
+    } else {
+        LOG_WARN_W(L"Failed to acquire reconnected device: " + m_deviceName);
+        return false;
+    }
+}
+
+bool DirectInputDevice::ReadInput()
+{
+    if (m_eventDriven) {
+        // Every buffered transition is fed to the processor in order while draining
+        return ReadBufferedInput();
+    }
+    
+    if (!PollAndGetState()) {
+        return false;
+    }
+    MapCurrentState();
+    return true;
+}
+
+bool DirectInputDevice::ReadBufferedInput()
+{
+    if (m_needsResync) {
+        return ResyncBufferedState();
+    }
+    
+    if (!PollDevice()) {
+        return false;
+    }
+    if (m_needsResync) {
+        // Poll had to re-acquire the device
+        return ResyncBufferedState();
+    }
+    
+    for (;;) {
+        DWORD count = static_cast<DWORD>(m_inputRecords.size());
+        HRESULT hr = m_device->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), m_inputRecords.data(), &count, 0);
+        m_latency.OnRead(Qpc::Now());
+        if (FAILED(hr)) {
+            if (hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED || hr == DIERR_UNPLUGGED) {
+                LOG_WARN_W(L"Device is unplugged or lost: " + m_deviceName);
+                m_connected = false;
+                UnacquireDevice();
+            } else {
+                LOG_ERROR_W(L"GetDeviceData failed for device: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
+            }
+            m_needsResync = true;
+            return false;
+        }
+        
+        // Records sharing a sequence number happened simultaneously; apply them as one transition
+        for (DWORD i = 0; i < count; ) {
+            const DWORD sequence = m_inputRecords[i].dwSequence;
+            for (; i < count && m_inputRecords[i].dwSequence == sequence; ++i) {
+                ApplyBufferedRecord(m_inputRecords[i]);
+            }
+            m_lastInputTimestamp = m_inputRecords[i - 1].dwTimeStamp;
+            m_latency.OnEventTimestamp(m_lastInputTimestamp);
+            MapCurrentState();
+        }
+        
+        if (hr == DI_BUFFEROVERFLOW) {
+            LOG_WARN_W(L"Input buffer overflow, resynchronizing: " + m_deviceName);
+            return ResyncBufferedState();
+        }
+        
+        if (count < m_inputRecords.size()) {
+            break;
+        }
+    }
+    
+    return true;
+}
+
+bool DirectInputDevice::ResyncBufferedState()
+{
+    // Discard stale records, then take a full snapshot so held buttons are not missed
+    DWORD discarded = INFINITE;
+    m_device->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), nullptr, &discarded, 0);
+    
+    if (!PollAndGetState()) {
+        return false;
+    }
+    
+    m_needsResync = false;
+    MapCurrentState();
+    return true;
+}
+
+void DirectInputDevice::ApplyBufferedRecord(const DIDEVICEOBJECTDATA& record)
+{
+    // With c_dfDIJoystick2, dwOfs is the byte offset of the object inside DIJOYSTATE2
+    constexpr DWORD buttonsBegin = offsetof(DIJOYSTATE2, rgbButtons);
+    constexpr DWORD buttonsEnd = buttonsBegin + sizeof(DIJOYSTATE2::rgbButtons);
+    
+    auto* base = reinterpret_cast<BYTE*>(&m_currentState);
+    const DWORD ofs = record.dwOfs;
+    
+    if (ofs >= buttonsBegin && ofs < buttonsEnd) {
+        base[ofs] = static_cast<BYTE>(record.dwData);
+    } else if (ofs + sizeof(DWORD) <= sizeof(DIJOYSTATE2)) {
+        // Axes, sliders and POVs are all 32-bit fields
+        std::memcpy(base + ofs, &record.dwData, sizeof(DWORD));
+    }
+}
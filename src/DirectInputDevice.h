@@ -0,0 +1,52 @@
+#pragma once
+#include "GamepadDevice.h"
+
+/**
+ * @brief DirectInput 8 backend (c_dfDIJoystick2)
+ *
+ * Works with any game controller. In event input mode the device is read
+ * buffered: DirectInput signals an auto-reset event on new records and
+ * ReadInput drains them in order; otherwise it polls GetDeviceState every
+ * frame.
+ */
+class DirectInputDevice final : public GamepadDevice {
+public:
+    DirectInputDevice() = default;
+    ~DirectInputDevice() override;
+
+    // Initialization
+    bool Initialize(IDirectInput8* pDirectInput, const DIDEVICEINSTANCE* deviceInstance, HWND hWnd);
+
+    const wchar_t* GetBackendName() const override { return L"DirectInput"; }
+    HANDLE GetInputEvent() const override { return m_eventDriven ? m_inputEvent.get() : nullptr; }
+    bool IsAcquired() const { return m_acquired; }
+
+    // Device operations
+    bool AcquireDevice();
+    void UnacquireDevice();
+    bool TryToReconnect(HWND hWnd) override;
+
+protected:
+    bool ReadInput() override;
+    void CloseDevice() override;
+
+private:
+    // Internal initialization helpers
+    bool ConfigureDevice(HWND hWnd);
+    void SetAxisRanges();
+    bool EnableEventNotification();
+    bool PollDevice();
+    bool PollAndGetState();
+    bool ReadBufferedInput();
+    bool ResyncBufferedState();
+    void ApplyBufferedRecord(const DIDEVICEOBJECTDATA& record);
+
+    ComPtr<IDirectInput8> m_directInput; // For reconnecting
+    ComPtr<IDirectInputDevice8> m_device;
+    bool m_acquired = false;
+
+    // Event-driven (buffered) input
+    bool m_needsResync = true; // Take a full GetDeviceState snapshot before trusting buffered deltas
+    UniqueHandle m_inputEvent;
+    std::array<DIDEVICEOBJECTDATA, AppConstants::INPUT_BUFFER_SIZE> m_inputRecords{};
+};
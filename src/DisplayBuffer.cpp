@@ -2,197 +2,303 @@
 #include <windows.h>
 #include <cstdio>
 #include <cstdarg>
-#include <iomanip>
-#include <sstream>
+#include <cwchar>
 #include <algorithm>
 
 DisplayBuffer::DisplayBuffer(size_t maxLines)
     : m_maxLines(std::clamp(maxLines, MIN_MAX_LINES, MAX_MAX_LINES))
     , m_totalLinesAdded(0)
+    , m_droppedLines(0)
 {
-    m_lines.reserve(m_maxLines + 10); // Reserve some extra space
+    // Both arenas are sized up front; building a frame never allocates
+    ResizeFrame(m_frames[0], m_maxLines);
+    ResizeFrame(m_frames[1], m_maxLines);
 }
 
 void DisplayBuffer::Clear() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_lines.clear();
+    std::lock_guard<std::mutex> lock(m_buildMutex);
+    BackFrame().count = 0;
 }
 
 void DisplayBuffer::SetMaxLines(size_t maxLines) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::scoped_lock lock(m_buildMutex, m_frontMutex);
     m_maxLines = std::clamp(maxLines, MIN_MAX_LINES, MAX_MAX_LINES);
-    TrimToMaxLines();
+    for (Frame& frame : m_frames) {
+        ResizeFrame(frame, m_maxLines);
+    }
+    m_frames[m_front].generation++; // Force readers to pick up the truncated frame
 }
 
 size_t DisplayBuffer::GetMaxLines() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_buildMutex);
     return m_maxLines;
 }
 
-void DisplayBuffer::AddLine(const std::wstring& line) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    AddLineInternal(line);
+void DisplayBuffer::AddLine(std::wstring_view line) {
+    std::lock_guard<std::mutex> lock(m_buildMutex);
+    AddLineLocked(line);
 }
 
 void DisplayBuffer::AddFormattedLine(const wchar_t* fmt, ...) {
-    wchar_t buffer[512];
+    std::lock_guard<std::mutex> lock(m_buildMutex);
     va_list args;
     va_start(args, fmt);
-    vswprintf_s(buffer, _countof(buffer), fmt, args);
+    AddFormattedLineLockedV(fmt, args);
     va_end(args);
-    
-    AddLine(buffer);
 }
 
 void DisplayBuffer::AddGamepadHeader(const std::wstring& deviceName) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_buildMutex);
     
-    if (!m_lines.empty()) {
-        AddLineInternal(L"");
+    if (BackFrame().count != 0) {
+        AddLineLocked(L"");
     }
     
-    AddLineInternal(L"=== gamepad ===");
-    AddLineInternal(L"name: " + deviceName);
+    AddLineLocked(L"=== gamepad ===");
+    AddFormattedLineLocked(L"name: %s", deviceName.c_str());
 }
 
 void DisplayBuffer::AddGamepadInfo(bool connected, 
                                   const std::wstring& productName, 
                                   const std::wstring& instanceName) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_buildMutex);
     
-    if (!m_lines.empty()) {
-        AddLineInternal(L"");
+    if (BackFrame().count != 0) {
+        AddLineLocked(L"");
     }
     
-    AddLineInternal(L"=== gamepad ===");
+    AddLineLocked(L"=== gamepad ===");
     
     if (connected) {
-        AddLineInternal(L"name: " + (productName.empty() ? L"Unknown" : productName));
-        AddLineInternal(L"instance name: " + (instanceName.empty() ? L"Unknown" : instanceName));
-        AddLineInternal(L"status: connected");
+        AddFormattedLineLocked(L"name: %s", productName.empty() ? L"Unknown" : productName.c_str());
+        AddFormattedLineLocked(L"instance name: %s", instanceName.empty() ? L"Unknown" : instanceName.c_str());
+        AddLineLocked(L"status: connected");
     } else {
-        AddLineInternal(L"status: not connected");
+        AddLineLocked(L"status: not connected");
     }
     
 }
 
 void DisplayBuffer::AddGamepadState(const std::wstring& deviceName, 
                                    const DIJOYSTATE2& state) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_buildMutex);
     
     // Add device name prefix
-    AddLineInternal(L"[" + deviceName + L"]");
+    AddFormattedLineLocked(L"[%s]", deviceName.c_str());
     
     // Add axes information
-    wchar_t buffer[256];
-    swprintf_s(buffer, L"Axes: X=%ld Y=%ld Z=%ld RX=%ld RY=%ld RZ=%ld", 
-               state.lX, state.lY, state.lZ, state.lRx, state.lRy, state.lRz);
-    AddLineInternal(buffer);
+    AddFormattedLineLocked(L"Axes: X=%ld Y=%ld Z=%ld RX=%ld RY=%ld RZ=%ld", 
+                           state.lX, state.lY, state.lZ, state.lRx, state.lRy, state.lRz);
     
     // Add slider information
-    swprintf_s(buffer, L"Sliders: S0=%ld S1=%ld", state.rglSlider[0], state.rglSlider[1]);
-    AddLineInternal(buffer);
+    AddFormattedLineLocked(L"Sliders: S0=%ld S1=%ld", state.rglSlider[0], state.rglSlider[1]);
     
     // Add POV information
     for (int i = 0; i < 4; ++i) {
         DWORD pov = state.rgdwPOV[i];
         if (pov == 0xFFFFFFFF) {
-            swprintf_s(buffer, L"POV%d: -", i);
+            AddFormattedLineLocked(L"POV%d: -", i);
         } else {
-            swprintf_s(buffer, L"POV%d: %lu", i, pov);
+            AddFormattedLineLocked(L"POV%d: %lu", i, pov);
         }
-        AddLineInternal(buffer);
     }
     
-    // Add button information (most important for debugging)
-    std::wstring buttonStr = L"Btns:";
+    // Add button information (most important for debugging), written straight into the arena
+    Line* line = BeginLineLocked();
+    if (!line) {
+        return;
+    }
+    
+    size_t length = 0;
+    for (const wchar_t c : std::wstring_view(L"Btns:")) {
+        line->text[length++] = c;
+    }
     for (int i = 0; i < 32; ++i) {
-        buttonStr.push_back((state.rgbButtons[i] & 0x80) ? L'1' : L'0');
-        if ((i + 1) % 8 == 0 && i + 1 < 32) buttonStr.push_back(L' ');
+        line->text[length++] = (state.rgbButtons[i] & 0x80) ? L'1' : L'0';
+        if ((i + 1) % 8 == 0 && i + 1 < 32) line->text[length++] = L' ';
     }
-    AddLineInternal(buttonStr);
+    line->text[length] = L'\0';
+    line->length = static_cast<uint32_t>(length);
+    CommitLineLocked(*line);
+}
+
+void DisplayBuffer::AddLatencySummary(const wchar_t* label, const LatencySummary& summary) {
+    if (summary.count == 0) {
+        AddFormattedLine(L"%s: no samples", label);
+        return;
+    }
+    
+    AddFormattedLine(L"%s: p50=%lluus p95=%lluus p99=%lluus max=%lluus (n=%llu)", label,
+                     static_cast<unsigned long long>(summary.p50),
+                     static_cast<unsigned long long>(summary.p95),
+                     static_cast<unsigned long long>(summary.p99),
+                     static_cast<unsigned long long>(summary.max),
+                     static_cast<unsigned long long>(summary.count));
 }
 
 void DisplayBuffer::AddStatusLine(const std::wstring& status) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    AddLineInternal(L"Status: " + status);
+    std::lock_guard<std::mutex> lock(m_buildMutex);
+    AddFormattedLineLocked(L"Status: %s", status.c_str());
 }
 
 void DisplayBuffer::AddSeparator() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    AddLineInternal(L"");
+    std::lock_guard<std::mutex> lock(m_buildMutex);
+    AddLineLocked(L"");
 }
 
-const std::vector<std::wstring>& DisplayBuffer::GetLines() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_lines;
+bool DisplayBuffer::PublishFrame(DirtyRows* dirtyRows) {
+    std::lock_guard<std::mutex> buildLock(m_buildMutex);
+    Frame& back = BackFrame();
+    
+    // The front frame is only read here, and only the window thread reads it concurrently
+    const Frame& front = m_frames[m_front];
+    const size_t rows = (std::max)(back.count, front.count);
+    
+    bool changed = back.count != front.count;
+    if (dirtyRows) {
+        dirtyRows->reset();
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        if (i < back.count && i < front.count && SameLine(back.lines[i], front.lines[i])) {
+            continue;
+        }
+        changed = true;
+        if (dirtyRows) {
+            dirtyRows->set(i);
+        } else {
+            break;
+        }
+    }
+    
+    if (!changed) {
+        return false; // Nothing to repaint; the back frame is simply rebuilt next time
+    }
+    
+    std::lock_guard<std::mutex> frontLock(m_frontMutex);
+    back.generation = front.generation + 1;
+    m_front = 1 - m_front;
+    return true;
+}
+
+bool DisplayBuffer::GetSnapshot(Frame& snapshot) const {
+    std::lock_guard<std::mutex> lock(m_frontMutex);
+    const Frame& front = m_frames[m_front];
+    if (snapshot.generation == front.generation && !snapshot.lines.empty()) {
+        return false;
+    }
+    
+    if (snapshot.lines.size() < front.count) {
+        snapshot.lines.resize(front.lines.size()); // First use (or SetMaxLines) only
+    }
+    
+    // Copy only the used part of each line
+    for (size_t i = 0; i < front.count; ++i) {
+        const Line& src = front.lines[i];
+        Line& dst = snapshot.lines[i];
+        dst.length = src.length;
+        dst.hash = src.hash;
+        wmemcpy(dst.text, src.text, src.length + 1);
+    }
+    snapshot.count = front.count;
+    snapshot.generation = front.generation;
+    return true;
+}
+
+uint64_t DisplayBuffer::GetGeneration() const {
+    std::lock_guard<std::mutex> lock(m_frontMutex);
+    return m_frames[m_front].generation;
 }
 
 size_t DisplayBuffer::GetLineCount() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_lines.size();
+    std::lock_guard<std::mutex> lock(m_buildMutex);
+    return m_frames[1 - m_front].count;
 }
 
 bool DisplayBuffer::IsEmpty() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_lines.empty();
+    return GetLineCount() == 0;
 }
 
 size_t DisplayBuffer::GetTotalLinesAdded() const {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_buildMutex);
     return m_totalLinesAdded;
 }
 
+size_t DisplayBuffer::GetDroppedLineCount() const {
+    std::lock_guard<std::mutex> lock(m_buildMutex);
+    return m_droppedLines;
+}
+
 void DisplayBuffer::ResetStatistics() {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_buildMutex);
     m_totalLinesAdded = 0;
+    m_droppedLines = 0;
 }
 
 // Private helper methods
-void DisplayBuffer::AddLineInternal(const std::wstring& line) {
-    std::wstring finalLine = line;
-    
-    m_lines.push_back(finalLine);
+DisplayBuffer::Line* DisplayBuffer::BeginLineLocked() {
     m_totalLinesAdded++;
     
-    TrimToMaxLines();
+    // Frame is full: keep the lines already placed (status header first) and drop the rest
+    Frame& back = BackFrame();
+    if (back.count >= m_maxLines) {
+        m_droppedLines++;
+        return nullptr;
+    }
+    return &back.lines[back.count];
 }
 
-void DisplayBuffer::TrimToMaxLines() {
-    if (m_lines.size() > m_maxLines) {
-        size_t excessLines = m_lines.size() - m_maxLines;
-        m_lines.erase(m_lines.begin(), m_lines.begin() + excessLines);
-    }
+void DisplayBuffer::CommitLineLocked(Line& line) {
+    line.hash = HashLine(line.text, line.length);
+    BackFrame().count++;
 }
 
-std::wstring DisplayBuffer::FormatGamepadState(const DIJOYSTATE2& state) {
-    std::wostringstream oss;
-    oss << L"X:" << state.lX 
-        << L" Y:" << state.lY 
-        << L" Btns:";
-    
-    for (int i = 0; i < 8; ++i) {
-        oss << ((state.rgbButtons[i] & 0x80) ? L'1' : L'0');
+void DisplayBuffer::AddLineLocked(std::wstring_view text) {
+    Line* line = BeginLineLocked();
+    if (!line) {
+        return;
     }
     
-    return oss.str();
+    const size_t length = (std::min)(text.size(), MAX_LINE_LENGTH - 1);
+    wmemcpy(line->text, text.data(), length);
+    line->text[length] = L'\0';
+    line->length = static_cast<uint32_t>(length);
+    CommitLineLocked(*line);
 }
 
-std::wstring DisplayBuffer::FormatButtonState(const DIJOYSTATE2& state) {
-    std::wstring result = L"Buttons: ";
-    bool hasPressed = false;
-    
-    for (int i = 0; i < 32; ++i) {
-        if (state.rgbButtons[i] & 0x80) {
-            if (hasPressed) result += L", ";
-            result += L"B" + std::to_wstring(i);
-            hasPressed = true;
-        }
+void DisplayBuffer::AddFormattedLineLocked(const wchar_t* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    AddFormattedLineLockedV(fmt, args);
+    va_end(args);
+}
+
+void DisplayBuffer::AddFormattedLineLockedV(const wchar_t* fmt, va_list args) {
+    Line* line = BeginLineLocked();
+    if (!line) {
+        return;
     }
     
-    if (!hasPressed) {
-        result += L"None";
+    // _TRUNCATE: over-long lines are cut instead of invoking the invalid parameter handler
+    int written = _vsnwprintf_s(line->text, MAX_LINE_LENGTH, _TRUNCATE, fmt, args);
+    line->length = static_cast<uint32_t>(written >= 0 ? written : wcsnlen(line->text, MAX_LINE_LENGTH));
+    CommitLineLocked(*line);
+}
+
+uint32_t DisplayBuffer::HashLine(const wchar_t* text, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ static_cast<uint32_t>(text[i])) * 16777619u;
     }
-    
-    return result;
+    return hash;
+}
+
+bool DisplayBuffer::SameLine(const Line& a, const Line& b) {
+    // Hash rejects almost every changed line; the compare rules out collisions
+    return a.hash == b.hash && a.length == b.length && wmemcmp(a.text, b.text, a.length) == 0;
+}
+
+void DisplayBuffer::ResizeFrame(Frame& frame, size_t maxLines) {
+    frame.lines.resize(maxLines);
+    frame.lines.shrink_to_fit();
+    frame.count = (std::min)(frame.count, maxLines);
 }
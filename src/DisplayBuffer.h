@@ -2,25 +2,61 @@
 #include <windows.h>
 #include <dinput.h>
 #include <mutex>
-#include <chrono>
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LatencyStats.h"
 
 /**
  * @brief スクリーン表示専用のバッファ実装
  * 
- * スレッドセーフなスクリーン表示バッファ。メモリ制限機能付きで、
- * 古い行を自動的に削除して無制限な蓄積を防ぐ。
+ * スレッドセーフなスクリーン表示バッファ。行は事前確保した固定長の
+ * アリーナに直接書き込まれるため、フレーム構築中にヒープ確保は発生しない。
+ * 入力スレッドが裏フレームを構築し、PublishFrame() で表フレームと入れ替える。
+ * 描画スレッドは表フレームの安定したコピーを取得して描画する。
  */
 class DisplayBuffer {
 public:
+    static constexpr size_t MAX_LINE_LENGTH = 256; // Including terminator; longer lines are truncated
+    static constexpr size_t MIN_MAX_LINES = 10;
+    static constexpr size_t MAX_MAX_LINES = 1000;
+
+    // One fixed-capacity line; hash is FNV-1a over the text for cheap frame diffs
+    struct Line {
+        uint32_t length = 0;
+        uint32_t hash = 0;
+        wchar_t text[MAX_LINE_LENGTH] = {};
+
+        std::wstring_view View() const { return { text, length }; }
+    };
+
+    // A complete frame; generation increases every time a changed frame is published
+    struct Frame {
+        std::vector<Line> lines; // Preallocated, only the first count entries are valid
+        size_t count = 0;
+        uint64_t generation = 0;
+    };
+
+    // Bit i set <=> row i differs from the previously published frame
+    using DirtyRows = std::bitset<MAX_MAX_LINES>;
+
     // コンストラクタ/デストラクタ
     DisplayBuffer(size_t maxLines = 100);
 
+    // Disabled while nothing is shown (tray mode): callers check IsEnabled()
+    // before formatting so the frame path does no display work at all
+    void SetEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
     // DisplayBuffer interface implementation
     void Clear();
     void SetMaxLines(size_t maxLines);
     size_t GetMaxLines() const;
 
-    void AddLine(const std::wstring& line);
+    void AddLine(std::wstring_view line);
     void AddFormattedLine(const wchar_t* fmt, ...);
 
     void AddGamepadHeader(const std::wstring& deviceName);
@@ -30,14 +66,25 @@ public:
     void AddGamepadState(const std::wstring& deviceName, 
                         const DIJOYSTATE2& state);
 
+    void AddLatencySummary(const wchar_t* label, const LatencySummary& summary);
+
     void AddStatusLine(const std::wstring& status);
     void AddSeparator();
 
-    const std::vector<std::wstring>& GetLines() const;
+    // Frame handoff: the input thread builds lines and publishes them,
+    // the window thread copies the last published frame for painting.
+    // PublishFrame returns false (and publishes nothing) when the frame is
+    // identical to the one already published; otherwise dirtyRows marks the changed rows.
+    bool PublishFrame(DirtyRows* dirtyRows = nullptr);
+    // Returns false if snapshot already holds the current generation
+    bool GetSnapshot(Frame& snapshot) const;
+    uint64_t GetGeneration() const;
+
     size_t GetLineCount() const;
     bool IsEmpty() const;
 
     size_t GetTotalLinesAdded() const;
+    size_t GetDroppedLineCount() const;
     void ResetStatistics();
 
 private:
@@ -45,20 +92,28 @@ private:
     DisplayBuffer(const DisplayBuffer&) = delete;
     DisplayBuffer& operator=(const DisplayBuffer&) = delete;
 
-    // Internal helper methods
-    void AddLineInternal(const std::wstring& line);
-    void TrimToMaxLines();
-    std::wstring FormatGamepadState(const DIJOYSTATE2& state);
-    std::wstring FormatButtonState(const DIJOYSTATE2& state);
+    // Internal helper methods (m_buildMutex held)
+    Frame& BackFrame() { return m_frames[1 - m_front]; }
+    Line* BeginLineLocked();
+    void CommitLineLocked(Line& line);
+    void AddLineLocked(std::wstring_view text);
+    void AddFormattedLineLocked(const wchar_t* fmt, ...);
+    void AddFormattedLineLockedV(const wchar_t* fmt, va_list args);
+
+    static uint32_t HashLine(const wchar_t* text, size_t length);
+    static bool SameLine(const Line& a, const Line& b);
+    static void ResizeFrame(Frame& frame, size_t maxLines);
 
     // Member variables
-    std::vector<std::wstring> m_lines;
+    Frame m_frames[2];
+    size_t m_front = 0;         // Index of the published frame; changed only under both mutexes
     size_t m_maxLines;
     size_t m_totalLinesAdded;
-    mutable std::mutex m_mutex;
+    size_t m_droppedLines;
+    std::atomic<bool> m_enabled{ true };
+    mutable std::mutex m_buildMutex; // Back frame and statistics (input thread)
+    mutable std::mutex m_frontMutex; // Front frame and m_front (shared with the window thread)
 
     // Constants for formatting
     static constexpr size_t DEFAULT_MAX_LINES = 100;
-    static constexpr size_t MIN_MAX_LINES = 10;
-    static constexpr size_t MAX_MAX_LINES = 1000;
-};
\ No newline at end of file
+};
@@ -0,0 +1,58 @@
+#include "EtwTrace.h"
+
+#if GAMEPAD_MAPPER_ETW
+#include <evntprov.h>
+#include <atomic>
+
+namespace {
+
+// {8F3C1E52-6A4D-4B7E-9C21-5D0E7A3B64F1}
+constexpr GUID PROVIDER_ID = { 0x8F3C1E52, 0x6A4D, 0x4B7E, { 0x9C, 0x21, 0x5D, 0x0E, 0x7A, 0x3B, 0x64, 0xF1 } };
+
+REGHANDLE g_provider = 0;
+std::atomic<bool> g_enabled{ false };
+
+void NTAPI OnEnableChanged(LPCGUID, ULONG isEnabled, UCHAR, ULONGLONG, ULONGLONG, PEVENT_FILTER_DESCRIPTOR, PVOID)
+{
+    // EVENT_CONTROL_CODE_ENABLE_PROVIDER (1) / DISABLE (0); capture-state requests keep the current state
+    if (isEnabled <= 1) {
+        g_enabled.store(isEnabled == 1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+namespace EtwTrace {
+
+void Register()
+{
+    if (g_provider == 0) {
+        EventRegister(&PROVIDER_ID, OnEnableChanged, nullptr, &g_provider);
+    }
+}
+
+void Unregister()
+{
+    if (g_provider != 0) {
+        g_enabled.store(false, std::memory_order_relaxed);
+        EventUnregister(g_provider);
+        g_provider = 0;
+    }
+}
+
+bool IsEnabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void WriteZone(Zone zone, bool start)
+{
+    EVENT_DESCRIPTOR descriptor;
+    EventDescCreate(&descriptor, static_cast<USHORT>(zone), 0, 0, 4 /* TRACE_LEVEL_INFORMATION */,
+                    static_cast<USHORT>(zone), start ? 1 /* start */ : 2 /* stop */, 0);
+    EventWrite(g_provider, &descriptor, 0, nullptr);
+}
+
+} // namespace EtwTrace
+
+#endif // GAMEPAD_MAPPER_ETW
@@ -0,0 +1,53 @@
+#pragma once
+#include <windows.h>
+
+/**
+ * @brief Optional ETW tracing zones (build with GAMEPAD_MAPPER_ETW=ON)
+ *
+ * Manifest-free provider {8F3C1E52-6A4D-4B7E-9C21-5D0E7A3B64F1}: each zone
+ * writes a start and a stop event (opcode 1/2) whose task is the zone, so
+ * WPA/xperf can pair them into durations. While no session has the
+ * provider enabled a zone costs one relaxed load; without the build flag
+ * ETW_ZONE compiles to nothing.
+ */
+namespace EtwTrace {
+    enum class Zone : USHORT {
+        Poll = 1,       // Device read (polls/drains, including the mapping it triggers)
+        Map = 2,        // InputProcessor::ProcessGamepadInput
+        SendInput = 3,  // Frame flush
+    };
+
+#if GAMEPAD_MAPPER_ETW
+    void Register();
+    void Unregister();
+    bool IsEnabled();
+    void WriteZone(Zone zone, bool start);
+
+    class ScopedZone {
+    public:
+        explicit ScopedZone(Zone zone) : m_zone(zone), m_active(IsEnabled()) {
+            if (m_active) WriteZone(m_zone, true);
+        }
+        ~ScopedZone() {
+            if (m_active) WriteZone(m_zone, false);
+        }
+        ScopedZone(const ScopedZone&) = delete;
+        ScopedZone& operator=(const ScopedZone&) = delete;
+
+    private:
+        Zone m_zone;
+        bool m_active;
+    };
+#else
+    inline void Register() {}
+    inline void Unregister() {}
+#endif
+}
+
+#if GAMEPAD_MAPPER_ETW
+#define ETW_ZONE_CONCAT2(a, b) a##b
+#define ETW_ZONE_CONCAT(a, b) ETW_ZONE_CONCAT2(a, b)
+#define ETW_ZONE(zone) EtwTrace::ScopedZone ETW_ZONE_CONCAT(etwZone, __LINE__)(EtwTrace::Zone::zone)
+#else
+#define ETW_ZONE(zone) ((void)0)
+#endif
@@ -0,0 +1,120 @@
+#include "FrameScheduler.h"
+#include "LatencyStats.h"
+#include "Logger.h"
+#include <algorithm>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+bool FrameScheduler::Initialize(const Options& options)
+{
+    m_options = options;
+    m_options.pollRateHz = std::clamp<DWORD>(m_options.pollRateHz, 1, 1000);
+    m_options.idleRateHz = std::clamp<DWORD>(m_options.idleRateHz, 1, m_options.pollRateHz);
+
+    m_frequency = Qpc::Frequency();
+    m_idleTimeout = static_cast<int64_t>(m_options.idleTimeoutMs) * m_frequency / 1000;
+    m_lastActivity = Qpc::Now();
+    m_nextDeadline = 0;
+    m_idle = false;
+    SetRate(m_options.pollRateHz);
+
+    m_timer.reset(CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS));
+    m_highResolution = static_cast<bool>(m_timer);
+    if (!m_timer) {
+        // Before Windows 10 1803: waits round up to the system timer resolution
+        m_timer.reset(CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS));
+        LOG_WARN("High resolution waitable timer unavailable (Error: {}), frame timing follows the system timer.", GetLastError());
+    }
+    if (!m_timer) {
+        LOG_ERROR("Failed to create frame timer. Error: {}", GetLastError());
+        return false;
+    }
+
+    LOG_INFO("Frame scheduler: {} Hz, idle {} Hz after {} ms without input.",
+             m_options.pollRateHz, m_options.idleRateHz, m_options.idleTimeoutMs);
+    return true;
+}
+
+void FrameScheduler::SetRate(DWORD rateHz)
+{
+    m_period = (std::max)(m_frequency / static_cast<int64_t>(rateHz), int64_t{ 1 });
+}
+
+void FrameScheduler::OnFrame(bool activity)
+{
+    if (m_idleTimeout == 0) {
+        return;
+    }
+
+    const int64_t now = Qpc::Now();
+    if (activity) {
+        m_lastActivity = now;
+        if (m_idle) {
+            // Snap back: the next frame is one full-rate period away, not the rest of an idle one
+            m_idle = false;
+            SetRate(m_options.pollRateHz);
+            m_nextDeadline = now + m_period;
+            LOG_DEBUG("Input activity, polling at {} Hz.", m_options.pollRateHz);
+        }
+    } else if (!m_idle && now - m_lastActivity >= m_idleTimeout) {
+        // Stretch the pending frame to the idle period
+        const int64_t previousPeriod = m_period;
+        m_idle = true;
+        SetRate(m_options.idleRateHz);
+        if (m_nextDeadline != 0) {
+            m_nextDeadline += m_period - previousPeriod;
+        }
+        LOG_DEBUG("No input for {} ms, polling at {} Hz.", m_options.idleTimeoutMs, m_options.idleRateHz);
+    }
+}
+
+bool FrameScheduler::WaitForNextFrame(HANDLE stopEvent, DWORD maxDelayMs)
+{
+    const int64_t now = Qpc::Now();
+    if (m_nextDeadline == 0) {
+        m_nextDeadline = now + m_period;
+    }
+
+    // An earlier key scheduler event wakes the frame without moving the cadence
+    int64_t wakeAt = m_nextDeadline;
+    if (maxDelayMs != INFINITE) {
+        wakeAt = (std::min)(wakeAt, now + static_cast<int64_t>(maxDelayMs) * m_frequency / 1000);
+    }
+    if (!WaitTicks(stopEvent, wakeAt - now)) {
+        return false;
+    }
+
+    const int64_t woke = Qpc::Now();
+    if (woke >= m_nextDeadline) {
+        m_nextDeadline += m_period;
+        if (m_nextDeadline <= woke) {
+            // Missed a whole period (stalled frame, suspend): re-anchor, don't burst
+            ++m_lateFrames;
+            m_nextDeadline = woke + m_period;
+        }
+    }
+    return true;
+}
+
+bool FrameScheduler::WaitTicks(HANDLE stopEvent, int64_t ticks)
+{
+    if (ticks <= 0 || !m_timer) {
+        // Already due (or no timer): only check for shutdown
+        const DWORD waitMs = m_timer ? 0 : static_cast<DWORD>((std::max)(ticks, int64_t{ 0 }) * 1000 / m_frequency);
+        return WaitForSingleObject(stopEvent, waitMs) == WAIT_TIMEOUT;
+    }
+
+    // Relative due time in 100 ns units, computed from the absolute QPC deadline
+    LARGE_INTEGER dueTime;
+    dueTime.QuadPart = -(std::max)(ticks * 10000000 / m_frequency, int64_t{ 1 });
+    if (!SetWaitableTimer(m_timer.get(), &dueTime, 0, nullptr, nullptr, FALSE)) {
+        LOG_WARN("SetWaitableTimer failed. Error: {}", GetLastError());
+        return WaitForSingleObject(stopEvent, static_cast<DWORD>(ticks * 1000 / m_frequency)) == WAIT_TIMEOUT;
+    }
+
+    HANDLE handles[] = { m_timer.get(), stopEvent };
+    const DWORD result = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+    return result == WAIT_OBJECT_0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include "Win32Handle.h"
+
+/**
+ * @brief Fixed-rate frame cadence for polled devices (input thread only)
+ *
+ * Frames are due at absolute deadlines (last deadline + period, in QPC
+ * ticks), so the time a wake-up runs late is taken out of the next wait
+ * instead of accumulating. A frame that misses its deadline by more than
+ * one period re-anchors the cadence rather than firing a burst of catch-up
+ * frames. Waits use a CREATE_WAITABLE_TIMER_HIGH_RESOLUTION timer, which
+ * does not depend on the system timer resolution; older systems fall back
+ * to a normal waitable timer.
+ *
+ * Adaptive mode: after idleTimeoutMs without device activity the cadence
+ * drops to the idle rate; the first frame with activity restores the full
+ * rate at once.
+ */
+class FrameScheduler {
+public:
+    struct Options {
+        DWORD pollRateHz = 250;
+        DWORD idleRateHz = 20;
+        DWORD idleTimeoutMs = 5000; // 0: never idle
+    };
+
+    FrameScheduler() = default;
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Creates the timer; call on the thread that waits
+    bool Initialize(const Options& options);
+
+    // Called after each frame; activity keeps (or restores) the full rate
+    void OnFrame(bool activity);
+
+    // Blocks until the next frame is due or maxDelayMs elapses, whichever is first;
+    // false once stopEvent is signalled
+    bool WaitForNextFrame(HANDLE stopEvent, DWORD maxDelayMs);
+
+    // Statistics
+    bool IsHighResolution() const { return m_highResolution; }
+    bool IsIdle() const { return m_idle; }
+    DWORD GetCurrentRateHz() const { return m_idle ? m_options.idleRateHz : m_options.pollRateHz; }
+    uint64_t GetLateFrameCount() const { return m_lateFrames; } // Re-anchored after missing a whole period
+
+private:
+    bool WaitTicks(HANDLE stopEvent, int64_t ticks);
+    void SetRate(DWORD rateHz);
+
+    Options m_options;
+    UniqueHandle m_timer;
+    bool m_highResolution = false;
+
+    int64_t m_frequency = 0;
+    int64_t m_period = 0;         // QPC ticks per frame at the current rate
+    int64_t m_nextDeadline = 0;   // 0: anchor on the next wait
+    int64_t m_lastActivity = 0;
+    int64_t m_idleTimeout = 0;    // QPC ticks; 0: adaptive mode off
+    bool m_idle = false;
+    uint64_t m_lateFrames = 0;
+};
@@ -3,67 +3,59 @@
 #include "InputProcessor.h"
 #include "Logger.h"
 #include "DisplayBuffer.h"
+#include "InputQueue.h"
+#include "ConfigWatcher.h"
+#include "InputRecording.h"
+#include "EtwTrace.h"
+#include "TextConversion.h"
 #include <algorithm>
+#include <cstring>
 #include <filesystem>
+#include <iterator>
+
+namespace {
+
+// Replaces characters Windows does not allow in file names, and spaces
+void MakeFileNameSafe(std::string& name)
+{
+    const std::string invalidChars = "\\/:*?\"<>|";
+    for (char& c : name) {
+        if (invalidChars.find(c) != std::string::npos) {
+            c = '_';
+        }
+    }
+    std::replace(name.begin(), name.end(), ' ', '_');
+}
+
+} // namespace
 
 GamepadDevice::GamepadDevice()
-    : m_connected(false)
-    , m_acquired(false)
+    : m_deviceGUID{}
+    , m_connected(false)
     , m_initialized(false)
     , m_currentState{}
-    , m_deviceGUID{}
 {
 }
 
+// Out of line: InputRecorder is incomplete in the header
 GamepadDevice::~GamepadDevice()
 {
-    Shutdown();
+    // The processor releases into m_privateQueue, which is declared after it and so destroyed first
+    m_inputProcessor.reset();
 }
 
-bool GamepadDevice::Initialize(IDirectInput8* pDirectInput, const DIDEVICEINSTANCE* deviceInstance, HWND hWnd)
+void GamepadDevice::UsePrivateInputQueue(IInputSink& overflowSink)
+{
+    m_privateQueue = std::make_unique<InputQueue>(overflowSink);
+    m_inputQueue = m_privateQueue.get();
+}
+
+void GamepadDevice::CreateInputProcessor()
 {
-    if (m_initialized) {
-        return true;
-    }
-    
-    // Store device information
-    m_deviceName = deviceInstance->tszProductName;
-    m_deviceInstanceName = deviceInstance->tszInstanceName;
-    m_deviceGUID = deviceInstance->guidInstance;
-    
-    // Create device
-    HRESULT hr = pDirectInput->CreateDevice(deviceInstance->guidInstance, m_device.GetAddressOf(), nullptr);
-    if (FAILED(hr)) {
-        LOG_ERROR_W(L"Failed to create device: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
-        return false;
-    }
-    
-    // Configure device
-    if (!ConfigureDevice(hWnd)) {
-        LOG_ERROR_W(L"Failed to configure device: " + m_deviceName);
-        return false;
-    }
-    
-    // Load configuration
-    if (!LoadConfiguration()) {
-        LOG_ERROR_W(L"Failed to load configuration for device: " + m_deviceName);
-        return false;
-    }
-    
-    // Initialize input processor
     m_inputProcessor = std::make_unique<InputProcessor>(*m_configManager);
-    
-    // Try to acquire device
-    if (!AcquireDevice()) {
-        LOG_WARN_W(L"Initial device acquisition failed for: " + m_deviceName + L" (may work in background)");
-    }
-    
-    m_initialized = true;
-    m_connected = true;
-    
-    LOG_INFO_W(L"GamepadDevice initialized successfully: " + m_deviceName + L" (" + m_deviceInstanceName + L")");
-    
-    return true;
+    m_inputProcessor->SetInputQueue(m_inputQueue);
+    m_inputProcessor->SetLatencyStats(&m_latency);
+    m_inputProcessor->SetKeyScheduler(m_keyScheduler);
 }
 
 void GamepadDevice::Shutdown()
@@ -74,125 +66,65 @@ void GamepadDevice::Shutdown()
     
     LOG_INFO_W(L"Shutting down GamepadDevice: " + m_deviceName);
     
-    UnacquireDevice();
+    CloseDevice();
     
-    // Reset components
+    // Flush the recording before the device goes away
+    m_recorder.reset();
+    
+    // Reset components, letting go of held keys while the queue is still there
+    if (m_inputProcessor) {
+        m_inputProcessor->ReleaseAllKeys();
+    }
     m_inputProcessor.reset();
     m_configManager.reset();
-    m_device.Reset();
+    m_profiles.clear();
+    m_activeProfile = 0;
     
     // Reset state
     m_connected = false;
-    m_acquired = false;
     m_initialized = false;
+    m_eventDriven = false;
     
     LOG_INFO_W(L"GamepadDevice shutdown complete: " + m_deviceName);
 }
 
-bool GamepadDevice::ConfigureDevice(HWND hWnd)
+void GamepadDevice::CacheNames()
 {
-    if (!m_device) {
-        return false;
-    }
-    
-    // Set data format to joystick (DIJOYSTATE2)
-    HRESULT hr = m_device->SetDataFormat(&c_dfDIJoystick2);
-    if (FAILED(hr)) {
-        LOG_ERROR("SetDataFormat failed. HRESULT: 0x{:08X}", hr);
-        return false;
-    }
-    
-    // Set cooperative level
-    hr = m_device->SetCooperativeLevel(hWnd, DISCL_BACKGROUND | DISCL_NONEXCLUSIVE);
-    if (FAILED(hr)) {
-        LOG_ERROR("SetCooperativeLevel failed. HRESULT: 0x{:08X}", hr);
-        return false;
-    }
-    
-    // Set axis ranges
-    SetAxisRanges();
-    
-    return true;
-}
-
-void GamepadDevice::SetAxisRanges()
-{
-    if (!m_device) return;
-    
-    DIPROPRANGE range;
-    range.diph.dwSize = sizeof(DIPROPRANGE);
-    range.diph.dwHeaderSize = sizeof(DIPROPHEADER);
-    range.diph.dwHow = DIPH_BYOFFSET;
-    range.lMin = -1000;
-    range.lMax = 1000;
-    
-    // Set ranges for all axes
-    const DWORD axes[] = { DIJOFS_X, DIJOFS_Y, DIJOFS_Z, DIJOFS_RX, DIJOFS_RY, DIJOFS_RZ };
-    
-    for (DWORD axis : axes) {
-        range.diph.dwObj = axis;
-        m_device->SetProperty(DIPROP_RANGE, &range.diph);
-    }
-    
-    LOG_DEBUG_W(L"Axis ranges set to [-1000, 1000] for device: " + m_deviceName);
-}
-
-std::string GamepadDevice::GetSafeFileName() const
-{
-    std::string safeName;
-    
-    // Convert wide string to narrow string
-    int size = WideCharToMultiByte(CP_UTF8, 0, m_deviceName.c_str(), -1, nullptr, 0, nullptr, nullptr);
-    if (size > 0) {
-        std::vector<char> buffer(size);
-        WideCharToMultiByte(CP_UTF8, 0, m_deviceName.c_str(), -1, buffer.data(), size, nullptr, nullptr);
-        safeName = buffer.data();
-    }
-    
-    // Replace invalid filename characters
-    std::string invalidChars = "\\/:*?\"<>|";
-    for (char& c : safeName) {
-        if (invalidChars.find(c) != std::string::npos) {
-            c = '_';
-        }
-    }
-    
-    // Remove spaces and make it filesystem-safe
-    std::replace(safeName.begin(), safeName.end(), ' ', '_');
-    
-    return safeName;
+    // Everything derived from the name is converted here once, never per frame
+    m_deviceNameUtf8 = Text::WideToUtf8(m_deviceName);
+    m_safeFileName = m_deviceNameUtf8;
+    MakeFileNameSafe(m_safeFileName);
+    m_safeFileNameW = Text::Utf8ToWide(m_safeFileName);
 }
 
 bool GamepadDevice::LoadConfiguration()
 {
+    // Backends call this from Initialize once the device name is known
+    CacheNames();
+    
     // Generate config file path based on device name
-    std::string safeDeviceName = GetSafeFileName();
-    m_configFilePath = "gamepad_config_" + safeDeviceName + ".json";
+    m_configFilePath = "gamepad_config_" + m_safeFileName + ".json";
     
     LOG_DEBUG_W(L"Loading configuration for device: " + m_deviceName);
     
-    // Convert config file path to wide string safely for logging
-    std::wstring configFilePathW;
-    int pathSize = MultiByteToWideChar(CP_UTF8, 0, m_configFilePath.c_str(), -1, nullptr, 0);
-    if (pathSize > 0) {
-        configFilePathW.resize(pathSize - 1);
-        MultiByteToWideChar(CP_UTF8, 0, m_configFilePath.c_str(), -1, &configFilePathW[0], pathSize);
-    } else {
-        configFilePathW = L"[path conversion failed]";
-    }
+    // Create configuration manager with the device-specific path (it keeps the wide form too)
+    m_configManager = std::make_unique<ConfigManager>(m_configFilePath);
     
-    LOG_DEBUG_W(L"Config file path: " + configFilePathW);
+    LOG_DEBUG_W(L"Config file path: " + m_configManager->getConfigFilePath());
     LOG_DEBUG_W(L"Config file exists: " + std::wstring(std::filesystem::exists(m_configFilePath) ? L"YES" : L"NO"));
     
-    // Create configuration manager with the device-specific path
-    m_configManager = std::make_unique<ConfigManager>(m_configFilePath);
-    
     // Try to load existing config
-    bool loadResult = m_configManager->load();
-    LOG_DEBUG_W(L"Config load result: " + std::wstring(loadResult ? L"SUCCESS" : L"FAILED"));
-    
-    if (!loadResult) {
-        // If loading fails, create a new default configuration file
+    const ConfigManager::LoadResult loadResult = m_configManager->load();
+    LOG_DEBUG_W(L"Config load result: " + std::wstring(loadResult == ConfigManager::LoadResult::Loaded ? L"SUCCESS" : L"FAILED"));
+    
+    if (loadResult == ConfigManager::LoadResult::Invalid) {
+        // The file is the user's: map with the defaults for now, but never overwrite it
+        LOG_ERROR_W(L"Configuration file is invalid, using the default mapping until it is fixed: " +
+                    m_configManager->getConfigFilePath());
+        auto [gamepadConfig, systemConfig] = ConfigManager::createDefaultConfig();
+        m_configManager->setConfig(gamepadConfig, systemConfig);
+    } else if (loadResult == ConfigManager::LoadResult::NotFound) {
+        // No file yet: create a new default configuration file
         LOG_INFO_W(L"Creating default configuration for device: " + m_deviceName);
         if (!CreateConfigurationFile()) {
             LOG_ERROR_W(L"Failed to create new configuration for device: " + m_deviceName);
@@ -214,19 +146,84 @@ bool GamepadDevice::LoadConfiguration()
         LOG_DEBUG_W(L"Button0 mapping: [" + std::wstring(button0Seq.begin(), button0Seq.end()) + L"] (threshold: " + std::to_wstring(m_configManager->getStickThreshold()) + L")");
     }
     
-    // Convert config file path to wide string safely
-    std::wstring finalConfigFilePathW;
-    int finalSize = MultiByteToWideChar(CP_UTF8, 0, m_configFilePath.c_str(), -1, nullptr, 0);
-    if (finalSize > 0) {
-        finalConfigFilePathW.resize(finalSize - 1);
-        MultiByteToWideChar(CP_UTF8, 0, m_configFilePath.c_str(), -1, &finalConfigFilePathW[0], finalSize);
-    } else {
-        finalConfigFilePathW = L"[conversion failed]";
+    LOG_INFO_W(L"Configuration loaded for device: " + m_deviceName + L" (file: " + m_configManager->getConfigFilePath() + L")");
+    
+    LoadProfiles();
+    return true;
+}
+
+void GamepadDevice::LoadProfiles()
+{
+    m_profiles.clear();
+    m_activeProfile = 0;
+    if (!m_profileNames) {
+        return;
+    }
+    
+    // Compiled now so a switch never parses or allocates; a profile without its own
+    // file is not created (it simply maps like the default)
+    for (size_t p = 1; p < m_profileNames->size(); ++p) {
+        std::string profileName = (*m_profileNames)[p];
+        MakeFileNameSafe(profileName);
+        
+        Profile profile;
+        profile.configPath = "gamepad_config_" + m_safeFileName + "@" + profileName + ".json";
+        if (std::filesystem::exists(profile.configPath)) {
+            auto config = std::make_unique<ConfigManager>(profile.configPath);
+            if (config->load() == ConfigManager::LoadResult::Loaded) {
+                LOG_INFO("Profile \"{}\" loaded: {}", (*m_profileNames)[p], profile.configPath);
+                profile.config = std::move(config);
+            } else {
+                LOG_ERROR("Failed to load profile \"{}\" ({}); using the default mapping.", (*m_profileNames)[p], profile.configPath);
+            }
+        }
+        m_profiles.push_back(std::move(profile));
+    }
+}
+
+const std::string& GamepadDevice::GetProfileConfigPath(size_t profile) const
+{
+    return profile == 0 || profile > m_profiles.size() ? m_configFilePath : m_profiles[profile - 1].configPath;
+}
+
+const ConfigManager& GamepadDevice::GetProfileConfig(uint32_t profile) const
+{
+    if (profile > 0 && profile <= m_profiles.size() && m_profiles[profile - 1].config) {
+        return *m_profiles[profile - 1].config;
+    }
+    return *m_configManager;
+}
+
+void GamepadDevice::SetConfigUpdate(size_t profile, std::shared_ptr<ConfigUpdate> update)
+{
+    if (profile == 0) {
+        m_configUpdate = std::move(update);
+    } else if (profile <= m_profiles.size()) {
+        m_profiles[profile - 1].update = std::move(update);
+    }
+}
+
+void GamepadDevice::SelectProfile(uint32_t profile)
+{
+    if (!m_inputProcessor || profile == m_activeProfile) {
+        return;
+    }
+    if (profile >= GetProfileCount()) {
+        profile = 0;
     }
+    m_activeProfile = profile;
     
-    LOG_INFO_W(L"Configuration loaded for device: " + m_deviceName + L" (file: " + finalConfigFilePathW + L")");
+    const ConfigManager& config = GetProfileConfig(profile);
+    if (&config == m_inputProcessor->GetConfig()) {
+        return; // Both map like the default
+    }
     
-    return true;
+    // Same hand-over as a hot reload: nothing held under the old table stays down
+    m_inputProcessor->ReleaseAllKeys();
+    m_inputProcessor->SetConfig(config);
+    if (m_connected) {
+        m_inputProcessor->ProcessGamepadInput(m_currentState);
+    }
 }
 
 bool GamepadDevice::CreateConfigurationFile()
@@ -241,112 +238,135 @@ bool GamepadDevice::CreateConfigurationFile()
     return m_configManager->save();
 }
 
-bool GamepadDevice::AcquireDevice()
+void GamepadDevice::ScheduleReconnect(ULONGLONG now)
 {
-    if (!m_device) {
-        return false;
-    }
-    
-    HRESULT hr = m_device->Acquire();
-    if (SUCCEEDED(hr)) {
-        m_acquired = true;
-        LOG_DEBUG_W(L"Device acquired successfully: " + m_deviceName);
-        return true;
-    } else {
-        m_acquired = false;
-        LOG_WARN_W(L"Device acquisition failed: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
-        return false;
+    m_reconnectDelayMs = m_reconnectDelayMs == 0
+        ? AppConstants::RECONNECT_INITIAL_DELAY_MS
+        : (std::min)(m_reconnectDelayMs * 2, AppConstants::RECONNECT_MAX_DELAY_MS);
+    m_nextReconnectTime = now + m_reconnectDelayMs;
+}
+
+void GamepadDevice::ApplyPendingConfiguration()
+{
+    for (size_t p = 0; p < GetProfileCount(); ++p) {
+        ConfigUpdate* update = p == 0 ? m_configUpdate.get() : m_profiles[p - 1].update.get();
+        std::unique_ptr<ConfigManager> config = update ? update->Take() : nullptr;
+        if (!config) {
+            continue;
+        }
+        
+        // The active profile's table, or the default one it falls back to
+        std::unique_ptr<ConfigManager>& slot = p == 0 ? m_configManager : m_profiles[p - 1].config;
+        const bool inUse = p == m_activeProfile || slot.get() == m_inputProcessor->GetConfig();
+        
+        // Release everything held under the old mapping so no key gets stuck down,
+        // then swap; this thread is the only reader, so the old tables can go immediately
+        if (inUse) {
+            m_inputProcessor->ReleaseAllKeys();
+            m_inputProcessor->SetConfig(*config);
+        }
+        slot = std::move(config);
+        
+        LOG_INFO_W(L"Configuration hot-reloaded for device: " + m_deviceName);
+        
+        // Buttons still held are pressed again under the new mapping
+        if (inUse) {
+            m_inputProcessor->ProcessGamepadInput(m_currentState);
+        }
     }
 }
 
-void GamepadDevice::UnacquireDevice()
+void GamepadDevice::MapCurrentState()
 {
-    if (m_device && m_acquired) {
-        m_device->Unacquire();
-        m_acquired = false;
-        LOG_DEBUG_W(L"Device unacquired: " + m_deviceName);
+    if (m_recorder) {
+        m_recorder->Record(Qpc::Now(), m_currentState);
     }
+    ++m_counters.states;
+    ETW_ZONE(Map);
+    m_inputProcessor->ProcessGamepadInput(m_currentState);
 }
 
-bool GamepadDevice::PollAndGetState()
+bool GamepadDevice::StartRecording(const std::wstring& directory)
 {
-    if (!m_device || !m_initialized) {
-        m_connected = false;
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        LOG_ERROR_W(L"Failed to create recording directory: " + directory);
         return false;
     }
     
-    HRESULT hr = m_device->Poll();
-    if (FAILED(hr)) {
-        hr = m_device->Acquire();
-        if (FAILED(hr)) {
-            if (hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED) {
-                LOG_WARN_W(L"Device lost or not acquired: " + m_deviceName + L". Trying to reconnect.");
-                m_connected = false;
-            }
-            return false;
-        }
-    }
-    
-    hr = m_device->GetDeviceState(sizeof(DIJOYSTATE2), &m_currentState);
-    if (FAILED(hr)) {
-        LOG_ERROR_W(L"GetDeviceState failed for device: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
-        if (hr == DIERR_INPUTLOST || hr == DIERR_NOTACQUIRED || hr == DIERR_UNPLUGGED) {
-            LOG_WARN_W(L"Device is unplugged or lost: " + m_deviceName);
-            m_connected = false;
-            UnacquireDevice();
-        }
+    // <device>_<yyyymmdd_hhmmss>.gmrec
+    std::wstring fileName = m_safeFileNameW;
+    SYSTEMTIME localTime;
+    GetLocalTime(&localTime);
+    wchar_t suffix[32];
+    swprintf_s(suffix, L"_%04u%02u%02u_%02u%02u%02u.gmrec", localTime.wYear, localTime.wMonth, localTime.wDay,
+               localTime.wHour, localTime.wMinute, localTime.wSecond);
+    fileName += suffix;
+    
+    auto recorder = std::make_unique<InputRecorder>();
+    if (!recorder->Open((std::filesystem::path(directory) / fileName).wstring(), m_deviceName, m_deviceGUID)) {
         return false;
     }
-    
+    m_recorder = std::move(recorder);
     return true;
 }
 
-bool GamepadDevice::TryToReconnect(IDirectInput8* pDirectInput, HWND hWnd)
+void GamepadDevice::ProcessInput()
 {
-    if (!pDirectInput || m_connected) {
-        return m_connected;
+    if (!m_inputProcessor || !m_connected) {
+        return;
     }
     
-    LOG_INFO_W(L"Attempting to reconnect device: " + m_deviceName);
-    
-    // Try to recreate the device
-    HRESULT hr = pDirectInput->CreateDevice(m_deviceGUID, m_device.GetAddressOf(), nullptr);
-    if (FAILED(hr)) {
-        LOG_ERROR_W(L"Failed to recreate device: " + m_deviceName + L". HRESULT: 0x" + std::to_wstring(hr));
-        return false;
+    if (m_configUpdate || !m_profiles.empty()) {
+        ApplyPendingConfiguration();
     }
     
-    // Reconfigure device
-    if (!ConfigureDevice(hWnd)) {
-        LOG_ERROR_W(L"Failed to reconfigure device: " + m_deviceName);
-        m_device.Reset();
-        return false;
+    // The backend feeds every new state to the processor while reading
+    bool read;
+    {
+        ETW_ZONE(Poll);
+        read = ReadInput();
+    }
+    if (read) {
+        ++m_counters.reads;
+    }
+    if (m_recorder) {
+        m_recorder->Tick(Qpc::Now());
+    }
+    m_hadActivity = read && UpdateActivity();
+    if (read && m_displayBuffer && m_displayBuffer->IsEnabled()) {
+        m_displayBuffer->AddGamepadState(m_deviceName, m_currentState);
+        m_displayBuffer->AddLatencySummary(L"Latency read->SendInput", m_latency.readToSent.Summarize());
+        if (m_eventDriven) {
+            m_displayBuffer->AddLatencySummary(L"Latency event age", m_latency.eventAge.Summarize());
+        }
     }
     
-    // Try to acquire
-    if (AcquireDevice()) {
-        m_connected = true;
-        LOG_INFO_W(L"Device reconnected successfully: " + m_deviceName);
-        return true;
-    } else {
-        LOG_WARN_W(L"Failed to acquire reconnected device: " + m_deviceName);
-        return false;
+    if (!m_connected) {
+        // Lost during this read: let go of everything, or its keys would stay counted as held
+        // in the shared key state and pin the same keys of every other device
+        m_inputProcessor->ReleaseAllKeys();
     }
 }
 
-void GamepadDevice::ProcessInput()
+bool GamepadDevice::UpdateActivity()
 {
-    if (!m_inputProcessor || !m_connected) {
-        return;
+    static constexpr LONG DIJOYSTATE2::* AXES[] = {
+        &DIJOYSTATE2::lX, &DIJOYSTATE2::lY, &DIJOYSTATE2::lZ,
+        &DIJOYSTATE2::lRx, &DIJOYSTATE2::lRy, &DIJOYSTATE2::lRz,
+    };
+    
+    // Any button or hat change counts; axes only beyond the noise band
+    bool changed = std::memcmp(m_currentState.rgbButtons, m_activityState.rgbButtons, sizeof(m_currentState.rgbButtons)) != 0 ||
+                   std::memcmp(m_currentState.rgdwPOV, m_activityState.rgdwPOV, sizeof(m_currentState.rgdwPOV)) != 0;
+    for (size_t i = 0; !changed && i < std::size(AXES); ++i) {
+        const LONG delta = m_currentState.*AXES[i] - m_activityState.*AXES[i];
+        changed = delta > AppConstants::AXIS_ACTIVITY_DELTA || delta < -AppConstants::AXIS_ACTIVITY_DELTA;
     }
     
-    if (PollAndGetState()) {
-        // Add device state to display buffer
-        if (m_displayBuffer) {
-            m_displayBuffer->AddGamepadState(m_deviceName, m_currentState);
-        }
-        
-        // Process the input with device context
-        m_inputProcessor->ProcessGamepadInput(m_currentState);
+    if (changed) {
+        m_activityState = m_currentState;
     }
-}
\ No newline at end of file
+    return changed;
+}
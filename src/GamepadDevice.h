@@ -4,11 +4,21 @@
 #include <wrl/client.h>
 #include <string>
 #include <memory>
+#include <array>
+#include <vector>
+#include "Constants.h"
+#include "Win32Handle.h"
+#include "LatencyStats.h"
 
 // Forward declarations
 class ConfigManager;
 class InputProcessor;
 class DisplayBuffer;
+class InputQueue;
+class IInputSink;
+class ConfigUpdate;
+class KeyScheduler;
+class InputRecorder;
 
 // ComPtr alias for convenience
 template<typename T>
@@ -16,41 +26,60 @@ using ComPtr = Microsoft::WRL::ComPtr<T>;
 
 /**
  * @brief Individual gamepad device management class
- * 
+ *
  * This class encapsulates a single gamepad device with its own configuration,
- * input processor, and state management.
+ * input processor, and state management. It is backend-neutral: a backend
+ * (DirectInputDevice, XInputDevice) opens the hardware and fills the
+ * DIJOYSTATE2 snapshot that every backend shares, so the mapping pipeline
+ * and GamepadManager never see which API a pad came through.
+ *
+ * Backends call Shutdown from their own destructor (CloseDevice is virtual).
  */
 class GamepadDevice {
 public:
-    // Constructor/Destructor (RAII)
-    GamepadDevice();
-    ~GamepadDevice();
+    virtual ~GamepadDevice();
     
-    // Non-copyable but movable
+    // Non-copyable, non-movable (owned through unique_ptr)
     GamepadDevice(const GamepadDevice&) = delete;
     GamepadDevice& operator=(const GamepadDevice&) = delete;
-    GamepadDevice(GamepadDevice&&) = default;
-    GamepadDevice& operator=(GamepadDevice&&) = default;
     
-    // Initialization
-    bool Initialize(IDirectInput8* pDirectInput, const DIDEVICEINSTANCE* deviceInstance, HWND hWnd);
     void Shutdown();
     
     // Device information
     const std::wstring& GetName() const { return m_deviceName; }
     const std::wstring& GetInstanceName() const { return m_deviceInstanceName; }
     const GUID& GetGUID() const { return m_deviceGUID; }
-    std::string GetSafeFileName() const;
+    const std::string& GetNameUtf8() const { return m_deviceNameUtf8; }
+    const std::string& GetSafeFileName() const { return m_safeFileName; } // UTF-8, usable in file names
+    virtual const wchar_t* GetBackendName() const = 0;
     
     // Device state
     bool IsConnected() const { return m_connected; }
-    bool IsAcquired() const { return m_acquired; }
+    bool IsEventDriven() const { return m_eventDriven; }
+    virtual HANDLE GetInputEvent() const { return nullptr; } // Signalled on new input; nullptr: poll every frame
+    DWORD GetLastInputTimestamp() const { return m_lastInputTimestamp; }
+    bool HadActivity() const { return m_hadActivity; } // State moved during the last ProcessInput
+    
+    // Latency instrumentation
+    DeviceLatencyStats& GetLatencyStats() { return m_latency; }
+    const DeviceLatencyStats& GetLatencyStats() const { return m_latency; }
+    
+    // Activity counters (totals since creation, input thread; exported by GamepadManager)
+    struct Counters {
+        uint64_t reads = 0;             // ReadInput calls that delivered state
+        uint64_t states = 0;            // States fed to the input processor
+        uint64_t reconnectAttempts = 0;
+    };
+    const Counters& GetCounters() const { return m_counters; }
+    void OnReconnectAttempt() { ++m_counters.reconnectAttempts; }
+    
+    // Reopens a lost device; true once it delivers input again
+    virtual bool TryToReconnect(HWND hWnd) = 0;
     
-    // Device operations
-    bool AcquireDevice();
-    void UnacquireDevice();
-    bool PollAndGetState();
-    bool TryToReconnect(IDirectInput8* pDirectInput, HWND hWnd);
+    // Reconnect backoff: each failed attempt doubles the wait, up to RECONNECT_MAX_DELAY_MS
+    bool IsReconnectDue(ULONGLONG now) const { return now >= m_nextReconnectTime; }
+    void ScheduleReconnect(ULONGLONG now);
+    void ResetReconnectBackoff() { m_reconnectDelayMs = 0; m_nextReconnectTime = 0; }
     
     // Input processing
     void ProcessInput();
@@ -58,18 +87,59 @@ public:
     // Display buffer injection
     void SetDisplayBuffer(DisplayBuffer* displayBuffer) { m_displayBuffer = displayBuffer; }
     
+    // Input queue injection (must be set before Initialize)
+    void SetInputQueue(InputQueue* inputQueue) { m_inputQueue = inputQueue; }
+    
+    // Timed key events for turbo/repeat/macro buttons (must be set before Initialize)
+    void SetKeyScheduler(KeyScheduler* scheduler) { m_keyScheduler = scheduler; }
+    
+    // Parallel processing: the device queues into its own buffer, which GamepadManager
+    // merges into the shared queue after all workers finish (must be set before Initialize).
+    // overflowSink receives the buffer if it fills up within one frame (GamepadManager passes a
+    // SharedQueueSink, so the events are still arbitrated by the shared key state).
+    void UsePrivateInputQueue(IInputSink& overflowSink);
+    InputQueue* GetPrivateInputQueue() const { return m_privateQueue.get(); }
+    
     // Configuration management
     bool LoadConfiguration();
     const ConfigManager* GetConfig() const { return m_configManager.get(); }
-
-private:
-    // Internal initialization helpers
-    bool ConfigureDevice(HWND hWnd);
-    void SetAxisRanges();
-    bool CreateConfigurationFile();
+    const std::string& GetConfigFilePath() const { return m_configFilePath; }
+    
+    // Application profiles: names[0] is the default (the config above); profile p > 0 maps with
+    // gamepad_config_<device>@<names[p]>.json, or like the default when there is no such file.
+    // Every profile is loaded and compiled by LoadConfiguration (must be set before Initialize)
+    void SetProfileNames(const std::vector<std::string>* names) { m_profileNames = names; }
+    size_t GetProfileCount() const { return m_profiles.size() + 1; }
+    const std::string& GetProfileConfigPath(size_t profile) const;
+    uint32_t GetActiveProfile() const { return m_activeProfile; }
+    // Input thread: releases what is held under the current mapping, then swaps the table pointer
+    void SelectProfile(uint32_t profile);
+    
+    // Hot-reload: configurations published here are swapped in between frames
+    void SetConfigUpdate(size_t profile, std::shared_ptr<ConfigUpdate> update);
+    
+    // Input recording: every state fed to the processor goes to <directory>/<device>_<time>.gmrec
+    // (after Initialize, before the device is processed)
+    bool StartRecording(const std::wstring& directory);
+    bool IsRecording() const { return m_recorder != nullptr; }
+    
+protected:
+    GamepadDevice();
     
-    // Device components
-    ComPtr<IDirectInputDevice8> m_device;
+    // Backend hooks
+    // Reads the device and feeds every new state to the input processor; false when no
+    // state is available this frame (read failed, device lost: clear m_connected)
+    virtual bool ReadInput() = 0;
+    // Releases the backend's handles (Shutdown)
+    virtual void CloseDevice() = 0;
+    
+    // Called by the backend once the configuration is loaded
+    void CreateInputProcessor();
+    
+    // Called by the backend for every new m_currentState (records it, then maps it)
+    void MapCurrentState();
+    
+    // Shared by every backend
     std::unique_ptr<ConfigManager> m_configManager;
     std::unique_ptr<InputProcessor> m_inputProcessor;
     
@@ -80,13 +150,57 @@ private:
     
     // Device state
     bool m_connected;
-    bool m_acquired;
     bool m_initialized;
+    bool m_eventDriven = false;
     DIJOYSTATE2 m_currentState;
+    DWORD m_lastInputTimestamp = 0; // Hardware timestamp of the most recent event (event-driven backends)
+    
+    // Latency instrumentation (read -> mapped -> SendInput)
+    DeviceLatencyStats m_latency;
     
     // Dependencies
     DisplayBuffer* m_displayBuffer = nullptr;
     
+private:
+    bool CreateConfigurationFile();
+    void CacheNames();
+    void LoadProfiles();
+    const ConfigManager& GetProfileConfig(uint32_t profile) const;
+    void ApplyPendingConfiguration();
+    bool UpdateActivity();
+    
+    // Activity tracking (adaptive poll rate)
+    DIJOYSTATE2 m_activityState{}; // State at the last activity
+    bool m_hadActivity = false;
+    
+    Counters m_counters;
+    
+    // Reconnect backoff
+    DWORD m_reconnectDelayMs = 0;
+    ULONGLONG m_nextReconnectTime = 0;
+    
+    // Dependencies
+    KeyScheduler* m_keyScheduler = nullptr;
+    InputQueue* m_inputQueue = nullptr;
+    std::unique_ptr<InputQueue> m_privateQueue;
+    std::unique_ptr<InputRecorder> m_recorder;
+    
+    // Derived from m_deviceName once (LoadConfiguration)
+    std::string m_deviceNameUtf8;
+    std::string m_safeFileName;
+    std::wstring m_safeFileNameW;
+    
     // Configuration
     std::string m_configFilePath;
-};
\ No newline at end of file
+    std::shared_ptr<ConfigUpdate> m_configUpdate;
+    
+    // Application profiles beyond the default: m_profiles[p - 1] is profile p
+    struct Profile {
+        std::string configPath;
+        std::unique_ptr<ConfigManager> config; // nullptr: no file, maps like the default
+        std::shared_ptr<ConfigUpdate> update;
+    };
+    const std::vector<std::string>* m_profileNames = nullptr;
+    std::vector<Profile> m_profiles;
+    uint32_t m_activeProfile = 0;
+};
@@ -1,15 +1,24 @@
 #include "GamepadManager.h"
-#include "GamepadDevice.h"
+#include "DirectInputDevice.h"
+#include "XInputDevice.h"
+#include "HidDevice.h"
+#include "ReplayDevice.h"
 #include "Logger.h"
+#include "LatencyStats.h"
+#include "EtwTrace.h"
+#include <array>
+#include <cwchar>
+#include <dbt.h>
 #include <algorithm>
-#include <sstream>
-#include <iomanip>
+#include <system_error>
+#include <filesystem>
 
 GamepadManager::GamepadManager()
     : m_initialized(false)
     , m_hWnd(nullptr)
     , m_lastScanTime(0)
 {
+    m_inputQueue.SetKeyState(&m_keyState);
 }
 
 GamepadManager::~GamepadManager()
@@ -26,16 +35,48 @@ bool GamepadManager::Initialize(HINSTANCE hInst, HWND hWnd)
     
     LOG_INFO("Initializing GamepadManager...");
     m_hWnd = hWnd;
+    EtwTrace::Register();
+    if (!m_metricsName.empty()) {
+        m_metrics.Open(m_metricsName); // Optional: runs without it on failure
+        m_lastMetricsQpc = Qpc::Now();
+    }
     
     if (!CreateDirectInput(hInst)) {
         return false;
     }
     
-    // Initial device scan
+    // Device configs are relative to the working directory; watch it before devices register
+    if (m_configHotReload) {
+        std::error_code ec;
+        std::filesystem::path configDirectory = std::filesystem::current_path(ec);
+        if (!ec) {
+            m_configWatcher.Start(configDirectory.wstring());
+        }
+    }
+    
+    // Called on the window thread, whose message loop delivers the foreground hook
+    if (m_profileSwitcher.HasRules()) {
+        m_profileSwitcher.Start();
+        m_activeProfile = m_profileSwitcher.GetActiveProfile();
+    }
+    
+    // Initial device scan (synchronous: nothing is running yet)
     ScanForDevices();
+    AddReplayDevice();
+    
+    if (m_deviceWorkerCount > 0) {
+        m_workerPool = std::make_unique<DeviceWorkerPool>(m_deviceWorkerCount);
+    }
+    
+    // From here on, enumeration only happens in the background on device changes
+    RegisterHotplugNotification();
+    if (!StartEnumerationThread()) {
+        UnregisterHotplugNotification();
+        LOG_WARN("Hot-plug detection disabled; only devices present at startup are used.");
+    }
     
     m_initialized = true;
-    LOG_INFO("GamepadManager initialization completed. Found {} devices.", m_devices.size());
+    LOG_INFO("GamepadManager initialization completed. Found {} devices.", m_deviceCount);
     
     return true;
 }
@@ -48,6 +89,13 @@ void GamepadManager::Shutdown()
     
     LOG_INFO("Shutting down GamepadManager...");
     
+    // The enumeration thread creates devices, so stop it before tearing them down
+    StopEnumerationThread();
+    UnregisterHotplugNotification();
+    m_profileSwitcher.Stop();
+    m_workerPool.reset();
+    m_configWatcher.Stop();
+    
     // Shutdown all devices
     for (auto& device : m_devices) {
         if (device) {
@@ -55,9 +103,24 @@ void GamepadManager::Shutdown()
         }
     }
     
+    // Shutdown released every held key (and cancelled the timed events); inject those key-ups
+    // before the queues go, or the keys would stay down in the OS after exit
+    MergeDeviceQueues();
+    m_inputQueue.FlushTo(m_inputSink);
+    
     // Clear containers
     m_devices.clear();
-    m_deviceIndexByGUID.clear();
+    m_slotByGuid.clear();
+    m_freeSlots.clear();
+    m_deviceCount = 0;
+    m_deviceGeneration.fetch_add(1, std::memory_order_release);
+    m_pendingDevices.clear();
+    m_attachedGuids.clear();
+    m_managedGuids.clear();
+    m_scanResultReady = false;
+    m_keyState.Reset();
+    m_metrics.Close();
+    EtwTrace::Unregister();
     
     // Release DirectInput
     m_directInput.Reset();
@@ -81,6 +144,12 @@ bool GamepadManager::CreateDirectInput(HINSTANCE hInst)
 }
 
 void GamepadManager::ScanForDevices()
+{
+    EnumerateAttachedDevices();
+    AdoptScanResults();
+}
+
+void GamepadManager::EnumerateAttachedDevices()
 {
     if (!m_directInput) {
         return;
@@ -88,65 +157,367 @@ void GamepadManager::ScanForDevices()
     
     LOG_INFO("Scanning for gamepad devices...");
     
-    // Clear the index map for rebuilding
-    m_deviceIndexByGUID.clear();
-    
+    std::vector<DIDEVICEINSTANCE> instances;
+    const int64_t enumStart = Qpc::Now();
     HRESULT hr = m_directInput->EnumDevices(DI8DEVCLASS_GAMECTRL, EnumDevicesCallback,
-                                           this, DIEDFL_ATTACHEDONLY);
+                                           &instances, DIEDFL_ATTACHEDONLY);
+    
+    // Only this thread (or Initialize, before it starts) writes these
+    const uint64_t enumUs = Qpc::ToMicroseconds(Qpc::Now() - enumStart);
+    m_lastEnumerationUs.store(enumUs, std::memory_order_relaxed);
+    if (enumUs > m_maxEnumerationUs.load(std::memory_order_relaxed)) {
+        m_maxEnumerationUs.store(enumUs, std::memory_order_relaxed);
+    }
+    m_enumerationCount.fetch_add(1, std::memory_order_relaxed);
     
     if (FAILED(hr)) {
         LOG_ERROR("EnumDevices failed. HRESULT: 0x{:08X}", hr);
         return;
     }
     
-    // Rebuild the index map
-    for (size_t i = 0; i < m_devices.size(); ++i) {
-        if (m_devices[i]) {
-            // Convert GUID to string for indexing
-            const GUID& guid = m_devices[i]->GetGUID();
-            std::ostringstream oss;
-            oss << std::hex << std::uppercase
-                << std::setfill('0') << std::setw(8) << guid.Data1 << "-"
-                << std::setfill('0') << std::setw(4) << guid.Data2 << "-"
-                << std::setfill('0') << std::setw(4) << guid.Data3 << "-";
-            
-            for (int j = 0; j < 8; ++j) {
-                oss << std::setfill('0') << std::setw(2) << static_cast<int>(guid.Data4[j]);
-                if (j == 1) oss << "-";
+    GuidSet attached;
+    std::vector<std::unique_ptr<GamepadDevice>> created;
+    
+    auto isManaged = [this](const GUID& guid) {
+        std::lock_guard<std::mutex> lock(m_scanMutex);
+        return IsDeviceAlreadyManaged(guid);
+    };
+    auto keep = [this, &created](std::unique_ptr<GamepadDevice> device) {
+        if (m_configWatcher.IsRunning()) {
+            for (size_t profile = 0; profile < device->GetProfileCount(); ++profile) {
+                device->SetConfigUpdate(profile, m_configWatcher.Register(device->GetProfileConfigPath(profile)));
             }
+        }
+        if (!m_recordingDirectory.empty()) {
+            device->StartRecording(m_recordingDirectory);
+        }
+        created.push_back(std::move(device));
+    };
+    
+    // One raw input walk serves both XInput deduplication and the HID backend
+    std::vector<HidDevice::ControllerInfo> hidControllers;
+    if (m_xinputEnabled || m_hidEnabled) {
+        hidControllers = HidDevice::ListControllers();
+    }
+    
+    // Products another backend reads; their DirectInput view is the same pad
+    std::vector<DWORD> claimedProducts;
+    for (const HidDevice::ControllerInfo& controller : hidControllers) {
+        if (controller.xinput) {
+            if (m_xinputEnabled) {
+                claimedProducts.push_back(controller.productId);
+            }
+            continue;
+        }
+        if (!m_hidEnabled) {
+            continue;
+        }
+        
+        const GUID guid = HidDevice::MakeGuid(controller.path);
+        if (!isManaged(guid)) {
+            auto newDevice = std::make_unique<HidDevice>();
+            PrepareDevice(*newDevice);
             
-            m_deviceIndexByGUID[oss.str()] = i;
+            if (!newDevice->Initialize(controller)) {
+                // Left to DirectInput (e.g. another process holds the interface exclusively)
+                LOG_ERROR_W(L"Failed to initialize HID controller: " + controller.path);
+                continue;
+            }
+            keep(std::move(newDevice));
+        }
+        attached.insert(guid);
+        claimedProducts.push_back(controller.productId);
+    }
+    
+    for (const DIDEVICEINSTANCE& instance : instances) {
+        if (std::find(claimedProducts.begin(), claimedProducts.end(), instance.guidProduct.Data1) != claimedProducts.end()) {
+            continue;
+        }
+        
+        attached.insert(instance.guidInstance);
+        if (isManaged(instance.guidInstance)) {
+            continue; // Already have this device
+        }
+        
+        // Create a new device (slow: CreateDevice, config file I/O, Acquire)
+        auto newDevice = std::make_unique<DirectInputDevice>();
+        PrepareDevice(*newDevice);
+        
+        if (newDevice->Initialize(m_directInput.Get(), &instance, m_hWnd)) {
+            keep(std::move(newDevice));
+        } else {
+            LOG_ERROR_W(L"Failed to initialize gamepad device: " + std::wstring(instance.tszProductName));
+        }
+    }
+    
+    for (DWORD user = 0; m_xinputEnabled && user < XInputDevice::MAX_USERS; ++user) {
+        const GUID guid = XInputDevice::MakeGuid(user);
+        if (!XInputDevice::IsUserConnected(user)) {
+            continue;
+        }
+        
+        attached.insert(guid);
+        if (isManaged(guid)) {
+            continue;
         }
+        
+        auto newDevice = std::make_unique<XInputDevice>();
+        PrepareDevice(*newDevice);
+        
+        if (newDevice->Initialize(user)) {
+            keep(std::move(newDevice));
+        } else {
+            LOG_ERROR("Failed to initialize XInput controller on user index {}", user);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(m_scanMutex);
+    for (auto& device : created) {
+        m_managedGuids.insert(device->GetGUID());
+        m_pendingDevices.push_back(std::move(device));
+    }
+    m_attachedGuids = std::move(attached);
+    m_scanResultReady.store(true, std::memory_order_release);
+}
+
+void GamepadManager::PrepareDevice(GamepadDevice& device)
+{
+    // Inject dependencies; the device is not used by the input thread until adopted
+    if (m_displayBuffer) {
+        device.SetDisplayBuffer(m_displayBuffer);
+    }
+    if (m_deviceWorkerCount > 0) {
+        device.UsePrivateInputQueue(m_overflowSink);
+    } else {
+        device.SetInputQueue(&m_inputQueue);
+    }
+    device.SetKeyScheduler(&m_keyScheduler);
+    device.SetProfileNames(&m_profileSwitcher.GetProfileNames());
+}
+
+void GamepadManager::AddReplayDevice()
+{
+    if (m_replayFile.empty()) {
+        return;
+    }
+    
+    // Not enumerated, so never in m_attachedGuids; it is never disconnected either, so it stays
+    auto replayDevice = std::make_unique<ReplayDevice>();
+    PrepareDevice(*replayDevice);
+    if (!replayDevice->Initialize(m_replayFile, m_replayRealTime)) {
+        LOG_ERROR_W(L"Failed to start replay: " + m_replayFile);
+        return;
     }
     
-    // Clean up any devices that are no longer connected
+    std::lock_guard<std::mutex> lock(m_scanMutex);
+    m_managedGuids.insert(replayDevice->GetGUID());
+    AddDevice(std::move(replayDevice));
+}
+
+void GamepadManager::AdoptScanResults()
+{
+    if (!m_scanResultReady.exchange(false, std::memory_order_acquire)) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(m_scanMutex);
+    
+    for (auto& device : m_pendingDevices) {
+        LOG_INFO_W(L"New gamepad device added: " + device->GetName() + L" (" + device->GetInstanceName() + L", " +
+                   device->GetBackendName() + L")");
+        AddDevice(std::move(device));
+    }
+    m_pendingDevices.clear();
+    
+    // Clean up any devices that are no longer attached; retry the others right away
     CleanupDisconnectedDevices();
     
-    LOG_INFO("Device scan completed. Managing {} devices.", m_devices.size());
+    LOG_INFO("Device scan completed. Managing {} devices.", m_deviceCount);
     m_lastScanTime = GetTickCount64();
 }
 
 void GamepadManager::CleanupDisconnectedDevices()
 {
-    // Remove devices that are no longer connected
-    auto it = std::remove_if(m_devices.begin(), m_devices.end(),
-        [](const std::unique_ptr<GamepadDevice>& device) {
-            return !device || !device->IsConnected();
-        });
+    // Remove devices that are disconnected and no longer enumerated; slots of the others stay put
+    size_t removedCount = 0;
+    for (size_t slot = 0; slot < m_devices.size(); ++slot) {
+        auto& device = m_devices[slot];
+        if (!device || device->IsConnected()) {
+            continue;
+        }
+        if (m_attachedGuids.contains(device->GetGUID())) {
+            device->ResetReconnectBackoff(); // Plugged back in: reconnect on the next frame
+            continue;
+        }
+        RemoveDeviceAt(slot);
+        ++removedCount;
+    }
     
-    if (it != m_devices.end()) {
-        size_t removedCount = std::distance(it, m_devices.end());
+    if (removedCount > 0) {
         LOG_INFO("Removing {} disconnected devices.", removedCount);
-        m_devices.erase(it, m_devices.end());
     }
 }
 
+size_t GamepadManager::AddDevice(std::unique_ptr<GamepadDevice> device)
+{
+    size_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_devices[slot] = std::move(device);
+    } else {
+        slot = m_devices.size();
+        m_devices.push_back(std::move(device));
+    }
+    
+    m_slotByGuid[m_devices[slot]->GetGUID()] = slot;
+    m_devices[slot]->SelectProfile(m_activeProfile);
+    ++m_deviceCount;
+    m_deviceGeneration.fetch_add(1, std::memory_order_release);
+    return slot;
+}
+
+void GamepadManager::RemoveDeviceAt(size_t slot)
+{
+    auto& device = m_devices[slot];
+    if (!device) {
+        return;
+    }
+    
+    const GUID guid = device->GetGUID();
+    m_slotByGuid.erase(guid);
+    m_managedGuids.erase(guid);
+    
+    // Its last key-ups (held keys, cancelled timed events) land in its private queue; send them on
+    device->Shutdown();
+    MergeDeviceQueue(*device);
+    device.reset();
+    m_freeSlots.push_back(slot);
+    --m_deviceCount;
+    m_deviceGeneration.fetch_add(1, std::memory_order_release);
+}
+
 bool GamepadManager::IsDeviceAlreadyManaged(const GUID& guid) const
 {
-    return std::any_of(m_devices.begin(), m_devices.end(),
-        [&guid](const std::unique_ptr<GamepadDevice>& device) {
-            return device && IsEqualGUID(device->GetGUID(), guid);
-        });
+    return m_managedGuids.contains(guid);
+}
+
+// =====================================
+// Hot-plug notification and background enumeration
+// =====================================
+
+namespace {
+// GUID_DEVINTERFACE_HID (hidclass.h), defined here to avoid pulling in the DDK headers
+constexpr GUID HID_DEVICE_INTERFACE_GUID = { 0x4D1E55B2, 0xF16F, 0x11CF, { 0x88, 0xCB, 0x00, 0x11, 0x11, 0x00, 0x00, 0x30 } };
+}
+
+bool GamepadManager::RegisterHotplugNotification()
+{
+    if (!m_hWnd) {
+        return false;
+    }
+    
+    DEV_BROADCAST_DEVICEINTERFACE_W filter{};
+    filter.dbcc_size = sizeof(filter);
+    filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
+    filter.dbcc_classguid = HID_DEVICE_INTERFACE_GUID;
+    
+    m_deviceNotify = RegisterDeviceNotificationW(m_hWnd, &filter, DEVICE_NOTIFY_WINDOW_HANDLE);
+    if (!m_deviceNotify) {
+        LOG_WARN("RegisterDeviceNotification failed (error {}); falling back to periodic background scans.", GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void GamepadManager::UnregisterHotplugNotification()
+{
+    if (m_deviceNotify) {
+        UnregisterDeviceNotification(m_deviceNotify);
+        m_deviceNotify = nullptr;
+    }
+}
+
+void GamepadManager::OnDeviceChange(WPARAM eventType)
+{
+    switch (eventType) {
+    case DBT_DEVICEARRIVAL:
+    case DBT_DEVICEREMOVECOMPLETE:
+    case DBT_DEVNODES_CHANGED:
+        RequestDeviceScan();
+        break;
+    default:
+        break;
+    }
+}
+
+void GamepadManager::RequestDeviceScan()
+{
+    if (m_scanRequestEvent) {
+        SetEvent(m_scanRequestEvent.get());
+    }
+}
+
+bool GamepadManager::StartEnumerationThread()
+{
+    m_scanRequestEvent.reset(CreateEventW(nullptr, FALSE, FALSE, nullptr));
+    m_stopEnumEvent.reset(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    if (!m_scanRequestEvent || !m_stopEnumEvent) {
+        LOG_ERROR("Failed to create device enumeration events. Error: {}", GetLastError());
+        m_scanRequestEvent.reset();
+        m_stopEnumEvent.reset();
+        return false;
+    }
+    
+    try {
+        m_enumThread = std::thread(&GamepadManager::EnumerationThreadMain, this);
+    } catch (const std::system_error& e) {
+        LOG_ERROR("Failed to start device enumeration thread: {}", e.what());
+        m_scanRequestEvent.reset();
+        m_stopEnumEvent.reset();
+        return false;
+    }
+    return true;
+}
+
+void GamepadManager::StopEnumerationThread()
+{
+    if (m_stopEnumEvent) {
+        SetEvent(m_stopEnumEvent.get());
+    }
+    if (m_enumThread.joinable()) {
+        m_enumThread.join();
+    }
+    m_scanRequestEvent.reset();
+    m_stopEnumEvent.reset();
+}
+
+void GamepadManager::EnumerationThreadMain()
+{
+    HANDLE stopEvent = m_stopEnumEvent.get();
+    HANDLE handles[] = { stopEvent, m_scanRequestEvent.get() };
+    const DWORD timeout = m_deviceNotify ? INFINITE : AppConstants::DEVICE_RESCAN_FALLBACK_MS;
+    
+    try {
+        for (;;) {
+            DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeout);
+            if (result == WAIT_OBJECT_0 || result == WAIT_FAILED) {
+                break;
+            }
+            
+            if (result == WAIT_OBJECT_0 + 1) {
+                // One plug-in raises several notifications and DirectInput lags behind them
+                if (WaitForSingleObject(stopEvent, AppConstants::DEVICE_CHANGE_SETTLE_MS) == WAIT_OBJECT_0) {
+                    break;
+                }
+                WaitForSingleObject(handles[1], 0); // Consume requests that arrived while settling
+            }
+            
+            EnumerateAttachedDevices();
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Device enumeration thread terminated by exception: {}", e.what());
+    }
 }
 
 void GamepadManager::ProcessAllDevices()
@@ -155,37 +526,220 @@ void GamepadManager::ProcessAllDevices()
         return;
     }
     
-    // Periodically scan for new devices
-    DWORD currentTime = GetTickCount64();
-    if (currentTime - m_lastScanTime > SCAN_INTERVAL_MS) {
-        ScanForDevices();
-    }
+    const int64_t frameStart = Qpc::Now();
+    
+    // Pick up devices found by the background enumeration (cheap flag check otherwise)
+    AdoptScanResults();
+    ApplyActiveProfile();
     
     // Process input from all connected devices
+    if (m_workerPool) {
+        ProcessDevicesParallel();
+    } else {
+        ProcessDevicesSequential();
+    }
+    
+    // Timed events that came due join the same batch, after this frame's device input
+    m_keyScheduler.Advance(Qpc::Now(), m_inputQueue);
+    
+    // Inject every transition produced this frame in a single SendInput call
+    bool sent;
+    {
+        ETW_ZONE(SendInput);
+        sent = m_inputQueue.FlushTo(m_inputSink) > 0;
+    }
+    const int64_t sentQpc = Qpc::Now();
+    if (sent) {
+        for (auto& device : m_devices) {
+            if (device) {
+                device->GetLatencyStats().OnSent(sentQpc);
+            }
+        }
+    }
+    
+    if (m_metrics.IsOpen()) {
+        ++m_frameCount;
+        m_frameTime.Record(Qpc::ToMicroseconds(sentQpc - frameStart));
+        if (Qpc::ToMicroseconds(sentQpc - m_lastMetricsQpc) >= AppConstants::METRICS_PUBLISH_INTERVAL_MS * 1000ull) {
+            PublishMetrics(sentQpc);
+        }
+    }
+    
+    ULONGLONG now = GetTickCount64();
+    if (now - m_lastLatencyLogTime >= AppConstants::LATENCY_LOG_INTERVAL_MS) {
+        m_lastLatencyLogTime = now;
+        LogLatencyStatistics();
+    }
+    
+    // Try to reconnect any disconnected devices
+    TryToReconnectDevices();
+}
+
+void GamepadManager::ApplyActiveProfile()
+{
+    // The foreground hook only publishes a number; the swap happens here, between
+    // frames, so it never races a device's mapping
+    const uint32_t profile = m_profileSwitcher.GetActiveProfile();
+    if (profile == m_activeProfile) {
+        return;
+    }
+    
+    m_activeProfile = profile;
+    for (auto& device : m_devices) {
+        if (device) {
+            device->SelectProfile(profile);
+        }
+    }
+}
+
+void GamepadManager::ProcessDevicesSequential()
+{
     for (size_t i = 0; i < m_devices.size(); ++i) {
         auto& device = m_devices[i];
         if (device && device->IsConnected()) {
             // Log which device is being processed (only occasionally to avoid spam)
             static int logCounter = 0;
             if (logCounter++ % 1000 == 0) {
-                LOG_DEBUG_W(L"Processing device " + std::to_wstring(i) + L": " + device->GetName());
+                LOG_DEBUG("Processing device {}: {}", i, device->GetNameUtf8());
             }
             device->ProcessInput();
         }
     }
+}
+
+void GamepadManager::ProcessDevicesParallel()
+{
+    m_frameDevices.clear();
+    for (auto& device : m_devices) {
+        if (device && device->IsConnected()) {
+            m_frameDevices.push_back(device.get());
+        }
+    }
     
-    // Try to reconnect any disconnected devices
-    TryToReconnectDevices();
+    // Each device reads and maps into its own queue; a stalled pad only holds up its own worker
+    auto processDevice = [this](size_t index) { m_frameDevices[index]->ProcessInput(); };
+    m_workerPool->Run(m_frameDevices.size(), processDevice);
+    
+    MergeDeviceQueues();
+}
+
+void GamepadManager::MergeDeviceQueues()
+{
+    // Each device's events stay contiguous and in order. The device that goes first
+    // rotates every frame so no player's keys are always injected ahead of the others.
+    const size_t slots = m_devices.size();
+    if (slots == 0) {
+        return;
+    }
+    
+    m_mergeStart = (m_mergeStart + 1) % slots;
+    for (size_t k = 0; k < slots; ++k) {
+        auto& device = m_devices[(m_mergeStart + k) % slots];
+        if (device) {
+            MergeDeviceQueue(*device);
+        }
+    }
+}
+
+void GamepadManager::MergeDeviceQueue(GamepadDevice& device)
+{
+    InputQueue* queue = device.GetPrivateInputQueue();
+    if (queue && !queue->IsEmpty()) {
+        m_inputQueue.AppendEvents(queue->GetPending());
+        queue->Clear();
+    }
+}
+
+void GamepadManager::LogLatencyStatistics() const
+{
+    auto logHistogram = [](size_t index, const char* stage, const LatencyHistogram& histogram) {
+        LatencySummary s = histogram.Summarize();
+        if (s.count > 0) {
+            LOG_INFO("Latency device {} {}: p50={}us p95={}us p99={}us max={}us (n={})",
+                     index, stage, s.p50, s.p95, s.p99, s.max, s.count);
+        }
+    };
+    
+    for (size_t i = 0; i < m_devices.size(); ++i) {
+        if (!m_devices[i]) continue;
+        const DeviceLatencyStats& stats = m_devices[i]->GetLatencyStats();
+        logHistogram(i, "read->mapped", stats.readToMapped);
+        logHistogram(i, "read->SendInput", stats.readToSent);
+        logHistogram(i, "event age", stats.eventAge);
+    }
+}
+
+void GamepadManager::PublishMetrics(int64_t now)
+{
+    Metrics::Snapshot& data = m_metrics.Data();
+    
+    // Previous snapshot's reads, for the per-device rate (matched by GUID: slots get reused)
+    std::array<std::pair<GUID, uint64_t>, Metrics::MAX_DEVICES> previous;
+    const uint32_t previousCount = data.deviceCount;
+    for (uint32_t i = 0; i < previousCount; ++i) {
+        previous[i] = { data.devices[i].guid, data.devices[i].reads };
+    }
+    const double seconds = static_cast<double>(now - m_lastMetricsQpc) / static_cast<double>(Qpc::Frequency());
+    m_lastMetricsQpc = now;
+    
+    data.qpcTimestamp = now;
+    data.frames = m_frameCount;
+    data.frameTime = m_frameTime.Summarize();
+    data.sendInputCalls = m_inputQueue.GetFlushCount();
+    data.sendInputEvents = m_inputQueue.GetTotalEventCount();
+    data.suppressedEvents = m_inputQueue.GetSuppressedEventCount();
+    data.enumerations = m_enumerationCount.load(std::memory_order_relaxed);
+    data.lastEnumerationUs = m_lastEnumerationUs.load(std::memory_order_relaxed);
+    data.maxEnumerationUs = m_maxEnumerationUs.load(std::memory_order_relaxed);
+    data.droppedLogMessages = Logger::GetInstance().GetDroppedMessageCount();
+    
+    uint32_t count = 0;
+    for (size_t slot = 0; slot < m_devices.size() && count < Metrics::MAX_DEVICES; ++slot) {
+        const GamepadDevice* device = m_devices[slot].get();
+        if (!device) continue;
+        
+        Metrics::Device& out = data.devices[count++];
+        wcsncpy_s(out.name, device->GetName().c_str(), _TRUNCATE);
+        wcsncpy_s(out.backend, device->GetBackendName(), _TRUNCATE);
+        out.guid = device->GetGUID();
+        out.slot = static_cast<uint32_t>(slot);
+        out.connected = device->IsConnected() ? 1 : 0;
+        
+        const GamepadDevice::Counters& counters = device->GetCounters();
+        uint64_t previousReads = counters.reads; // New device: no rate until the next snapshot
+        for (uint32_t i = 0; i < previousCount; ++i) {
+            if (IsEqualGUID(previous[i].first, out.guid)) {
+                previousReads = previous[i].second;
+                break;
+            }
+        }
+        out.reads = counters.reads;
+        out.states = counters.states;
+        out.reconnectAttempts = counters.reconnectAttempts;
+        out.readsPerSecond = seconds > 0.0 ? static_cast<double>(counters.reads - previousReads) / seconds : 0.0;
+        
+        const DeviceLatencyStats& stats = device->GetLatencyStats();
+        out.readToMapped = stats.readToMapped.Summarize();
+        out.readToSent = stats.readToSent.Summarize();
+        out.eventAge = stats.eventAge.Summarize();
+    }
+    data.deviceCount = count;
+    
+    m_metrics.Publish();
 }
 
 bool GamepadManager::TryToReconnectDevices()
 {
     bool anyReconnected = false;
+    ULONGLONG now = GetTickCount64();
     
     for (auto& device : m_devices) {
-        if (device && !device->IsConnected()) {
-            if (device->TryToReconnect(m_directInput.Get(), m_hWnd)) {
+        if (device && !device->IsConnected() && device->IsReconnectDue(now)) {
+            device->OnReconnectAttempt();
+            if (device->TryToReconnect(m_hWnd)) {
                 anyReconnected = true;
+            } else {
+                device->ScheduleReconnect(now);
             }
         }
     }
@@ -193,6 +747,32 @@ bool GamepadManager::TryToReconnectDevices()
     return anyReconnected;
 }
 
+bool GamepadManager::CollectInputEvents(std::vector<HANDLE>& events) const
+{
+    // Returns false when any connected device still needs to be polled every frame
+    bool allEventDriven = true;
+    
+    for (const auto& device : m_devices) {
+        if (!device || !device->IsConnected()) {
+            continue;
+        }
+        
+        HANDLE event = device->GetInputEvent();
+        if (event) {
+            events.push_back(event);
+        } else {
+            allEventDriven = false;
+        }
+    }
+    
+    return allEventDriven;
+}
+
+DWORD GamepadManager::GetNextTimerDelayMs() const
+{
+    return m_keyScheduler.GetNextDelayMs(Qpc::Now());
+}
+
 size_t GamepadManager::GetConnectedDeviceCount() const
 {
     return std::count_if(m_devices.begin(), m_devices.end(),
@@ -213,12 +793,8 @@ GamepadDevice* GamepadManager::FindDeviceByName(const std::wstring& name) const
 
 GamepadDevice* GamepadManager::FindDeviceByGUID(const GUID& guid) const
 {
-    auto it = std::find_if(m_devices.begin(), m_devices.end(),
-        [&guid](const std::unique_ptr<GamepadDevice>& device) {
-            return device && IsEqualGUID(device->GetGUID(), guid);
-        });
-    
-    return (it != m_devices.end()) ? it->get() : nullptr;
+    auto it = m_slotByGuid.find(guid);
+    return (it != m_slotByGuid.end()) ? m_devices[it->second].get() : nullptr;
 }
 
 std::vector<std::wstring> GamepadManager::GetConnectedDeviceNames() const
@@ -255,31 +831,18 @@ bool GamepadManager::HasAnyConnectedDevices() const
         });
 }
 
-// Static callback for device enumeration
+bool GamepadManager::HadInputActivity() const
+{
+    return std::any_of(m_devices.begin(), m_devices.end(),
+        [](const std::unique_ptr<GamepadDevice>& device) {
+            return device && device->IsConnected() && device->HadActivity();
+        });
+}
+
+// Static callback for device enumeration: only collects instances, devices are created afterwards
 BOOL CALLBACK GamepadManager::EnumDevicesCallback(const DIDEVICEINSTANCE* pdidInstance, VOID* pContext)
 {
-    GamepadManager* manager = reinterpret_cast<GamepadManager*>(pContext);
-    
-    // Check if this device is already managed
-    if (manager->IsDeviceAlreadyManaged(pdidInstance->guidInstance)) {
-        return DIENUM_CONTINUE; // Already have this device, continue enumeration
-    }
-    
-    // Create a new GamepadDevice
-    auto newDevice = std::make_unique<GamepadDevice>();
-    
-    // Inject display buffer dependency
-    if (manager->m_displayBuffer) {
-        newDevice->SetDisplayBuffer(manager->m_displayBuffer);
-    }
-    
-    if (newDevice->Initialize(manager->m_directInput.Get(), pdidInstance, manager->m_hWnd)) {
-        LOG_INFO_W(L"New gamepad device added: " + newDevice->GetName() + L" (" + newDevice->GetInstanceName() + L")");
-        
-        manager->m_devices.push_back(std::move(newDevice));
-    } else {
-        LOG_ERROR_W(L"Failed to initialize gamepad device: " + std::wstring(pdidInstance->tszProductName));
-    }
-    
+    auto* instances = reinterpret_cast<std::vector<DIDEVICEINSTANCE>*>(pContext);
+    instances->push_back(*pdidInstance);
     return DIENUM_CONTINUE; // Continue enumeration to find all devices
-}
\ No newline at end of file
+}
@@ -6,6 +6,20 @@
 #include <vector>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <cstring>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "InputQueue.h"
+#include "Win32Handle.h"
+#include "DeviceWorkerPool.h"
+#include "ConfigWatcher.h"
+#include "KeyScheduler.h"
+#include "KeyStateTable.h"
+#include "LatencyStats.h"
+#include "MetricsExport.h"
+#include "ProfileSwitcher.h"
 
 // Forward declarations
 class GamepadDevice;
@@ -15,12 +29,45 @@ class DisplayBuffer;
 template<typename T>
 using ComPtr = Microsoft::WRL::ComPtr<T>;
 
+// Binary GUID key for hash containers (no string formatting)
+struct GuidHash {
+    size_t operator()(const GUID& guid) const noexcept {
+        uint64_t words[2];
+        std::memcpy(words, &guid, sizeof(words));
+        uint64_t h = words[0] ^ (words[1] * 0x9E3779B97F4A7C15ull);
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+};
+
+struct GuidEqual {
+    bool operator()(const GUID& a, const GUID& b) const noexcept { return IsEqualGUID(a, b) != 0; }
+};
+
+using GuidSet = std::unordered_set<GUID, GuidHash, GuidEqual>;
+template<typename T>
+using GuidMap = std::unordered_map<GUID, T, GuidHash, GuidEqual>;
+
 /**
  * @brief Multiple gamepad device management class
  * 
  * This class manages multiple gamepad devices simultaneously,
  * handling device enumeration, connection/disconnection, and
  * coordinated input processing.
+ *
+ * Each scan enumerates DirectInput game controllers and, when enabled, the
+ * four XInput user slots and the HID game controllers. A pad XInput or the
+ * HID backend drives also shows up in DirectInput; its DirectInput
+ * instance is skipped so it is read (and mapped) once.
+ *
+ * Hot-plug: EnumDevices and device Initialize can stall for a long
+ * time, so after startup they only run on a background enumeration thread,
+ * woken by WM_DEVICECHANGE (HID interface arrival/removal). Finished devices
+ * are handed to the input thread, which adopts them at the start of a frame.
+ *
+ * Devices live in stable slots: removing one leaves a hole that a later
+ * device reuses, so a slot index stays valid for the device's lifetime
+ * (iterate with a null check). The device generation changes whenever a
+ * device is added or removed.
  */
 class GamepadManager {
 public:
@@ -37,12 +84,22 @@ public:
     void Shutdown();
     
     // Device management
-    void ScanForDevices();
+    void ScanForDevices();          // Synchronous: enumerate and adopt on the calling thread
     void ProcessAllDevices();
     bool TryToReconnectDevices();
     
+    // Hot-plug (window thread): forward WM_DEVICECHANGE here
+    void OnDeviceChange(WPARAM eventType);
+    void RequestDeviceScan();
+    
+    // Event-driven input support
+    bool CollectInputEvents(std::vector<HANDLE>& events) const;
+    // Upper bound for the input wait so timed key events fire on schedule (INFINITE when none)
+    DWORD GetNextTimerDelayMs() const;
+    
     // Device access
-    size_t GetDeviceCount() const { return m_devices.size(); }
+    size_t GetDeviceCount() const { return m_deviceCount; }
+    uint64_t GetDeviceGeneration() const { return m_deviceGeneration.load(std::memory_order_acquire); }
     size_t GetConnectedDeviceCount() const;
     GamepadDevice* FindDeviceByName(const std::wstring& name) const;
     GamepadDevice* FindDeviceByGUID(const GUID& guid) const;
@@ -51,25 +108,108 @@ public:
     std::vector<std::wstring> GetConnectedDeviceNames() const;
     std::vector<std::wstring> GetAllDeviceNames() const;
     
+    // Key injection diagnostics
+    const InputQueue& GetInputQueue() const { return m_inputQueue; }
+    const KeyScheduler& GetKeyScheduler() const { return m_keyScheduler; }
+    
     // Dependency injection
     void SetDisplayBuffer(DisplayBuffer* displayBuffer) { m_displayBuffer = displayBuffer; }
     
+    // Parallel device processing: 0 = sequential on the input thread (must be set before Initialize)
+    void SetDeviceWorkerCount(size_t workerCount) { m_deviceWorkerCount = workerCount; }
+    
+    // Reload device configs when their files change (must be set before Initialize)
+    void SetConfigHotReload(bool enabled) { m_configHotReload = enabled; }
+    
+    // Read XInput pads through XInput instead of DirectInput (must be set before Initialize)
+    void SetXInputEnabled(bool enabled) { m_xinputEnabled = enabled; }
+    
+    // Read other HID game controllers with overlapped ReadFile instead of DirectInput (must be set before Initialize)
+    void SetHidEnabled(bool enabled) { m_hidEnabled = enabled; }
+    
+    // Record every device's input into this directory (empty: off; must be set before Initialize)
+    void SetRecordingDirectory(std::wstring directory) { m_recordingDirectory = std::move(directory); }
+    
+    // Add a device replaying this recording (empty: none; must be set before Initialize)
+    void SetReplayFile(std::wstring path, bool realTime) { m_replayFile = std::move(path); m_replayRealTime = realTime; }
+    
+    // Per-application profiles: executable name -> profile name, followed through the
+    // foreground window (empty: always the default mapping; must be set before Initialize)
+    void SetProfileRules(const std::map<std::string, std::string>& rules) { m_profileSwitcher.SetRules(rules); }
+    uint32_t GetActiveProfile() const { return m_activeProfile; }
+    
+    // Publish counters and latency histograms to this named shared memory (empty: off; must be set before Initialize)
+    void SetMetricsExport(std::wstring name) { m_metricsName = std::move(name); }
+    
     // State queries
     bool IsInitialized() const { return m_initialized; }
     bool HasAnyConnectedDevices() const;
+    bool HadInputActivity() const; // Any device's state moved during the last ProcessAllDevices
 
 private:
     // Internal helpers
     bool CreateDirectInput(HINSTANCE hInst);
-    void CleanupDisconnectedDevices();
-    bool IsDeviceAlreadyManaged(const GUID& guid) const;
+    void CleanupDisconnectedDevices(); // m_scanMutex held
+    size_t AddDevice(std::unique_ptr<GamepadDevice> device);
+    void RemoveDeviceAt(size_t slot);
+    void LogLatencyStatistics() const;
+    void ProcessDevicesSequential();
+    void ProcessDevicesParallel();
+    void MergeDeviceQueues();
+    void MergeDeviceQueue(GamepadDevice& device);
+    bool IsDeviceAlreadyManaged(const GUID& guid) const; // m_scanMutex held
+    
+    // Background enumeration
+    bool RegisterHotplugNotification();
+    void UnregisterHotplugNotification();
+    bool StartEnumerationThread();
+    void StopEnumerationThread();
+    void EnumerationThreadMain();
+    void EnumerateAttachedDevices();
+    void PrepareDevice(GamepadDevice& device);
+    void AdoptScanResults();
+    void AddReplayDevice();
+    void PublishMetrics(int64_t now);
+    void ApplyActiveProfile();
     
     // Device enumeration callback
     static BOOL CALLBACK EnumDevicesCallback(const DIDEVICEINSTANCE* pdidInstance, VOID* pContext);
     
     // Member variables
     ComPtr<IDirectInput8> m_directInput;
-    std::vector<std::unique_ptr<GamepadDevice>> m_devices;
+    
+    // Turbo/repeat/macro events; declared before the devices, whose processors cancel into it on destruction
+    KeyScheduler m_keyScheduler;
+    
+    std::vector<std::unique_ptr<GamepadDevice>> m_devices; // Stable slots; nullptr = free
+    
+    // All devices queue their key events here; flushed with one SendInput per frame.
+    // The sink type is fixed at compile time so the flush is a direct call. Every transition
+    // entering the queue is arbitrated through the shared key state, so a VK held by several
+    // sources (buttons, pads, timed events) is pressed once and released by its last holder.
+    SendInputSink m_inputSink;
+    KeyStateTable m_keyState;
+    InputQueue m_inputQueue{ m_inputSink };
+    SharedQueueSink m_overflowSink{ m_inputQueue }; // Parallel mode: full private queues spill into m_inputQueue
+    
+    // Parallel processing: each device fills its own queue, merged in a rotating order
+    size_t m_deviceWorkerCount = 0;
+    std::unique_ptr<DeviceWorkerPool> m_workerPool;
+    std::vector<GamepadDevice*> m_frameDevices; // Connected devices of the current frame (reused)
+    size_t m_mergeStart = 0;
+    
+    // Backends
+    bool m_xinputEnabled = false;
+    bool m_hidEnabled = false;
+    
+    // Recording and replay
+    std::wstring m_recordingDirectory;
+    std::wstring m_replayFile;
+    bool m_replayRealTime = true;
+    
+    // Config hot-reload
+    bool m_configHotReload = false;
+    ConfigWatcher m_configWatcher;
     
     // Initialization state
     bool m_initialized;
@@ -78,10 +218,40 @@ private:
     // Dependencies
     DisplayBuffer* m_displayBuffer = nullptr;
     
-    // Device tracking
-    std::unordered_map<std::string, size_t> m_deviceIndexByGUID; // GUID string -> device index
+    // Device registry
+    GuidMap<size_t> m_slotByGuid;    // GUID -> slot in m_devices
+    std::vector<size_t> m_freeSlots; // Holes in m_devices, reused before growing
+    size_t m_deviceCount = 0;
+    std::atomic<uint64_t> m_deviceGeneration{ 0 };
+    
+    // Scan hand-off (enumeration thread -> input thread), guarded by m_scanMutex
+    std::mutex m_scanMutex;
+    std::vector<std::unique_ptr<GamepadDevice>> m_pendingDevices; // Initialized, not yet adopted
+    GuidSet m_attachedGuids;  // Result of the last enumeration
+    GuidSet m_managedGuids;   // Managed or pending devices (the enumeration thread's view)
+    std::atomic<bool> m_scanResultReady{ false };
+    
+    // Enumeration thread
+    std::thread m_enumThread;
+    UniqueHandle m_scanRequestEvent; // Auto-reset: one wake-up per burst of device changes
+    UniqueHandle m_stopEnumEvent;
+    HDEVNOTIFY m_deviceNotify = nullptr;
+    
+    // Application profiles (the hook runs on the window thread, the switch on the input thread)
+    ProfileSwitcher m_profileSwitcher;
+    uint32_t m_activeProfile = 0;
+    
+    // Metrics export (input thread, except the enumeration timings)
+    std::wstring m_metricsName;
+    MetricsExport m_metrics;
+    LatencyHistogram m_frameTime;
+    uint64_t m_frameCount = 0;
+    int64_t m_lastMetricsQpc = 0;
+    std::atomic<uint64_t> m_enumerationCount{ 0 };
+    std::atomic<uint64_t> m_lastEnumerationUs{ 0 };
+    std::atomic<uint64_t> m_maxEnumerationUs{ 0 };
     
     // Scan control
-    DWORD m_lastScanTime;
-    static constexpr DWORD SCAN_INTERVAL_MS = 5000; // Scan for new devices every 5 seconds
+    ULONGLONG m_lastLatencyLogTime = 0;
+    ULONGLONG m_lastScanTime;
 };
\ No newline at end of file
@@ -0,0 +1,444 @@
+#include "HidDevice.h"
+#include "ConfigManager.h"
+#include "InputProcessor.h"
+#include "Logger.h"
+#include <cstring>
+#include <cwchar>
+#include <cwctype>
+#include <iterator>
+#include <algorithm>
+
+namespace {
+
+// Generic Desktop collections that are game controllers
+bool IsGameControllerUsage(USHORT usagePage, USHORT usage)
+{
+    return usagePage == HID_USAGE_PAGE_GENERIC &&
+           (usage == HID_USAGE_GENERIC_JOYSTICK || usage == HID_USAGE_GENERIC_GAMEPAD ||
+            usage == HID_USAGE_GENERIC_MULTI_AXIS_CONTROLLER);
+}
+
+// DIJOYSTATE2 axis DirectInput assigns a Generic Desktop usage to
+LONG DIJOYSTATE2::* AxisForUsage(USAGE usage)
+{
+    switch (usage) {
+        case HID_USAGE_GENERIC_X: return &DIJOYSTATE2::lX;
+        case HID_USAGE_GENERIC_Y: return &DIJOYSTATE2::lY;
+        case HID_USAGE_GENERIC_Z: return &DIJOYSTATE2::lZ;
+        case HID_USAGE_GENERIC_RX: return &DIJOYSTATE2::lRx;
+        case HID_USAGE_GENERIC_RY: return &DIJOYSTATE2::lRy;
+        case HID_USAGE_GENERIC_RZ: return &DIJOYSTATE2::lRz;
+        default: return nullptr;
+    }
+}
+
+bool ContainsIgnoreCase(const wchar_t* text, const wchar_t* needle)
+{
+    const size_t needleLength = std::wcslen(needle);
+    for (; *text; ++text) {
+        size_t i = 0;
+        while (i < needleLength && text[i] && std::towupper(text[i]) == std::towupper(needle[i])) {
+            ++i;
+        }
+        if (i == needleLength) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+HidDevice::~HidDevice()
+{
+    Shutdown();
+}
+
+std::vector<HidDevice::ControllerInfo> HidDevice::ListControllers()
+{
+    std::vector<ControllerInfo> controllers;
+
+    UINT deviceCount = 0;
+    if (GetRawInputDeviceList(nullptr, &deviceCount, sizeof(RAWINPUTDEVICELIST)) != 0 || deviceCount == 0) {
+        return controllers;
+    }
+    std::vector<RAWINPUTDEVICELIST> devices(deviceCount);
+    const UINT listed = GetRawInputDeviceList(devices.data(), &deviceCount, sizeof(RAWINPUTDEVICELIST));
+    if (listed == static_cast<UINT>(-1)) {
+        return controllers;
+    }
+    devices.resize(listed);
+
+    for (const RAWINPUTDEVICELIST& device : devices) {
+        if (device.dwType != RIM_TYPEHID) {
+            continue;
+        }
+
+        RID_DEVICE_INFO info{};
+        info.cbSize = sizeof(info);
+        UINT infoSize = sizeof(info);
+        if (GetRawInputDeviceInfoW(device.hDevice, RIDI_DEVICEINFO, &info, &infoSize) == static_cast<UINT>(-1) ||
+            !IsGameControllerUsage(info.hid.usUsagePage, info.hid.usUsage)) {
+            continue;
+        }
+
+        // The raw input device name is the interface path CreateFile opens
+        wchar_t name[512];
+        UINT nameSize = static_cast<UINT>(std::size(name));
+        if (GetRawInputDeviceInfoW(device.hDevice, RIDI_DEVICENAME, name, &nameSize) == static_cast<UINT>(-1)) {
+            continue;
+        }
+
+        ControllerInfo controller;
+        controller.path = name;
+        controller.productId = MAKELONG(info.hid.dwVendorId, info.hid.dwProductId);
+        // XInput-compatible controllers expose an "IG_" HID interface
+        controller.xinput = ContainsIgnoreCase(name, L"IG_");
+        controllers.push_back(std::move(controller));
+    }
+
+    return controllers;
+}
+
+GUID HidDevice::MakeGuid(const std::wstring& path)
+{
+    // FNV-1a over the case-folded interface path: stable across runs and reconnects
+    ULONGLONG hash = 14695981039346656037ull;
+    for (const wchar_t c : path) {
+        hash ^= static_cast<ULONGLONG>(std::towupper(c));
+        hash *= 1099511628211ull;
+    }
+
+    // "HIDP" + hash; never collides with a DirectInput instance GUID
+    GUID guid{ 0x50444948, 0x0000, 0x0000, {} };
+    guid.Data2 = static_cast<USHORT>(hash >> 48);
+    guid.Data3 = static_cast<USHORT>(hash >> 32);
+    for (int i = 0; i < 8; ++i) {
+        guid.Data4[i] = static_cast<BYTE>(hash >> (i * 8));
+    }
+    return guid;
+}
+
+bool HidDevice::Initialize(const ControllerInfo& controller)
+{
+    if (m_initialized) {
+        return true;
+    }
+
+    // Store device information
+    m_path = controller.path;
+    m_deviceInstanceName = controller.path;
+    m_deviceGUID = MakeGuid(controller.path);
+
+    if (!OpenDevice()) {
+        LOG_ERROR_W(L"Failed to open HID device: " + m_path);
+        return false;
+    }
+
+    // The product string is what DirectInput shows as the product name
+    wchar_t product[127] = {};
+    if (HidD_GetProductString(m_file.get(), product, sizeof(product)) && product[0]) {
+        m_deviceName = product;
+    } else {
+        wchar_t fallback[32];
+        swprintf_s(fallback, L"HID Controller %04X:%04X", LOWORD(controller.productId), HIWORD(controller.productId));
+        m_deviceName = fallback;
+    }
+
+    if (!BuildReportPlan()) {
+        LOG_ERROR_W(L"Failed to parse the report descriptor of device: " + m_deviceName);
+        CloseDevice();
+        return false;
+    }
+
+    // Load configuration
+    if (!LoadConfiguration()) {
+        LOG_ERROR_W(L"Failed to load configuration for device: " + m_deviceName);
+        CloseDevice();
+        return false;
+    }
+
+    // Initialize input processor
+    CreateInputProcessor();
+    ResetState();
+
+    m_eventDriven = true;
+    m_initialized = true;
+    m_connected = IssueRead();
+
+    LOG_INFO_W(L"GamepadDevice initialized successfully: " + m_deviceName + L" (" + m_deviceInstanceName + L") [HID, " +
+               std::to_wstring(m_valueFields.size()) + L" value fields, " +
+               std::to_wstring(m_caps.InputReportByteLength) + L" byte reports]");
+
+    return true;
+}
+
+bool HidDevice::OpenDevice()
+{
+    HANDLE file = CreateFileW(m_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        // Some drivers only grant read access to a second opener
+        file = CreateFileW(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    }
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_WARN_W(L"CreateFile failed for HID device: " + m_path + L". Error: " + std::to_wstring(GetLastError()));
+        return false;
+    }
+    m_file.reset(file);
+
+    // Room for the reports that arrive between two drains
+    if (!HidD_SetNumInputBuffers(m_file.get(), AppConstants::HID_INPUT_BUFFER_COUNT)) {
+        LOG_WARN_W(L"HidD_SetNumInputBuffers failed for device: " + m_path);
+    }
+
+    if (!m_readEvent) {
+        m_readEvent.reset(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+        if (!m_readEvent) {
+            LOG_ERROR("Failed to create HID read event");
+            m_file.reset();
+            return false;
+        }
+    }
+    m_overlapped = OVERLAPPED{};
+    m_overlapped.hEvent = m_readEvent.get();
+    m_readPending = false;
+    return true;
+}
+
+void HidDevice::CloseFile()
+{
+    if (m_file && m_readPending) {
+        // The read still targets m_report; wait for the cancellation to land
+        CancelIoEx(m_file.get(), &m_overlapped);
+        DWORD ignored = 0;
+        GetOverlappedResult(m_file.get(), &m_overlapped, &ignored, TRUE);
+    }
+    m_readPending = false;
+    m_file.reset();
+}
+
+void HidDevice::CloseDevice()
+{
+    CloseFile();
+    m_readEvent.reset();
+    if (m_preparsed) {
+        HidD_FreePreparsedData(m_preparsed);
+        m_preparsed = nullptr;
+    }
+    m_valueFields.clear();
+}
+
+bool HidDevice::BuildReportPlan()
+{
+    if (!HidD_GetPreparsedData(m_file.get(), &m_preparsed)) {
+        m_preparsed = nullptr;
+        return false;
+    }
+    if (HidP_GetCaps(m_preparsed, &m_caps) != HIDP_STATUS_SUCCESS || m_caps.InputReportByteLength == 0) {
+        return false;
+    }
+    m_report.assign(m_caps.InputReportByteLength, 0);
+
+    // Buttons: one usage list per report
+    m_hasButtons = false;
+    USHORT buttonCapCount = m_caps.NumberInputButtonCaps;
+    std::vector<HIDP_BUTTON_CAPS> buttonCaps(buttonCapCount);
+    if (buttonCapCount > 0 &&
+        HidP_GetButtonCaps(HidP_Input, buttonCaps.data(), &buttonCapCount, m_preparsed) == HIDP_STATUS_SUCCESS) {
+        for (USHORT i = 0; i < buttonCapCount; ++i) {
+            m_hasButtons = m_hasButtons || buttonCaps[i].UsagePage == HID_USAGE_PAGE_BUTTON;
+        }
+    }
+    m_usages.resize(m_hasButtons ? HidP_MaxUsageListLength(HidP_Input, HID_USAGE_PAGE_BUTTON, m_preparsed) : 0);
+
+    // Values: the first field of each axis usage, and the first hat switch
+    m_valueFields.clear();
+    USHORT valueCapCount = m_caps.NumberInputValueCaps;
+    std::vector<HIDP_VALUE_CAPS> valueCaps(valueCapCount);
+    if (valueCapCount > 0 &&
+        HidP_GetValueCaps(HidP_Input, valueCaps.data(), &valueCapCount, m_preparsed) == HIDP_STATUS_SUCCESS) {
+        bool hasHat = false;
+        for (USHORT i = 0; i < valueCapCount; ++i) {
+            const HIDP_VALUE_CAPS& caps = valueCaps[i];
+            if (caps.UsagePage != HID_USAGE_PAGE_GENERIC) {
+                continue;
+            }
+
+            const USAGE first = caps.IsRange ? caps.Range.UsageMin : caps.NotRange.Usage;
+            const USAGE last = caps.IsRange ? caps.Range.UsageMax : first;
+            for (ULONG usage = first; usage <= last; ++usage) {
+                ValueField field;
+                field.usagePage = caps.UsagePage;
+                field.usage = static_cast<USAGE>(usage);
+                field.linkCollection = caps.LinkCollection;
+                field.bitSize = caps.BitSize;
+                field.logicalMin = caps.LogicalMin;
+                field.logicalMax = caps.LogicalMax;
+                if (field.logicalMax < field.logicalMin && field.bitSize > 0 && field.bitSize < 32) {
+                    // Unsigned ranges that overflowed the descriptor's signed encoding
+                    field.logicalMin = 0;
+                    field.logicalMax = static_cast<LONG>((1ul << field.bitSize) - 1);
+                }
+
+                if (field.usage == HID_USAGE_GENERIC_HATSWITCH) {
+                    if (hasHat) {
+                        continue;
+                    }
+                    field.isHat = hasHat = true;
+                } else {
+                    field.axis = AxisForUsage(field.usage);
+                    const bool mapped = std::any_of(m_valueFields.begin(), m_valueFields.end(),
+                        [&](const ValueField& other) { return other.axis == field.axis; });
+                    if (!field.axis || mapped) {
+                        continue;
+                    }
+                }
+                m_valueFields.push_back(field);
+            }
+        }
+    }
+
+    return true;
+}
+
+void HidDevice::ResetState()
+{
+    // Neutral until the first report: no buttons, centred axes and hat
+    m_currentState = DIJOYSTATE2{};
+    for (DWORD& pov : m_currentState.rgdwPOV) {
+        pov = 0xFFFFFFFF;
+    }
+}
+
+bool HidDevice::IssueRead()
+{
+    // Also completes synchronously when a report is already queued; the event is set either way
+    if (!ReadFile(m_file.get(), m_report.data(), static_cast<DWORD>(m_report.size()), nullptr, &m_overlapped) &&
+        GetLastError() != ERROR_IO_PENDING) {
+        LOG_WARN_W(L"Device is unplugged or lost: " + m_deviceName + L". Error: " + std::to_wstring(GetLastError()));
+        return false;
+    }
+    m_readPending = true;
+    return true;
+}
+
+bool HidDevice::ReadInput()
+{
+    if (!m_file) {
+        return false;
+    }
+
+    // Drain every report the driver has queued; each one is a separate transition
+    for (ULONG reports = 0; reports < AppConstants::HID_INPUT_BUFFER_COUNT; ++reports) {
+        if (!m_readPending && !IssueRead()) {
+            m_connected = false;
+            CloseFile();
+            return false;
+        }
+
+        DWORD length = 0;
+        if (!GetOverlappedResult(m_file.get(), &m_overlapped, &length, FALSE)) {
+            const DWORD error = GetLastError();
+            if (error == ERROR_IO_INCOMPLETE) {
+                break; // Nothing new yet; the read stays pending
+            }
+            LOG_WARN_W(L"Device is unplugged or lost: " + m_deviceName + L". Error: " + std::to_wstring(error));
+            m_readPending = false;
+            m_connected = false;
+            CloseFile();
+            return false;
+        }
+        m_readPending = false;
+
+        m_latency.OnRead(Qpc::Now());
+        m_latency.OnEventTimestamp(0); // No hardware timestamp
+        ApplyReport(length);
+        MapCurrentState();
+    }
+
+    return true;
+}
+
+void HidDevice::ApplyReport(ULONG length)
+{
+    DIJOYSTATE2& js = m_currentState;
+    const PCHAR report = reinterpret_cast<PCHAR>(m_report.data());
+
+    if (m_hasButtons) {
+        ULONG count = static_cast<ULONG>(m_usages.size());
+        // Reports with another report ID carry no buttons; keep the last ones then
+        if (HidP_GetUsages(HidP_Input, HID_USAGE_PAGE_BUTTON, 0, m_usages.data(), &count,
+                           m_preparsed, report, length) == HIDP_STATUS_SUCCESS) {
+            std::memset(js.rgbButtons, 0, sizeof(js.rgbButtons));
+            for (ULONG i = 0; i < count; ++i) {
+                const USAGE usage = m_usages[i];
+                if (usage >= 1 && usage <= AppConstants::MAX_BUTTONS) {
+                    js.rgbButtons[usage - 1] = 0x80;
+                }
+            }
+        }
+    }
+
+    for (const ValueField& field : m_valueFields) {
+        ULONG raw = 0;
+        if (HidP_GetUsageValue(HidP_Input, field.usagePage, field.linkCollection, field.usage, &raw,
+                               m_preparsed, report, length) != HIDP_STATUS_SUCCESS) {
+            continue;
+        }
+
+        if (field.isHat) {
+            // Out of range is the null state (centred)
+            const LONG value = static_cast<LONG>(raw);
+            js.rgdwPOV[0] = (value < field.logicalMin || value > field.logicalMax)
+                ? 0xFFFFFFFF
+                : static_cast<DWORD>((value - field.logicalMin) * 36000 / (field.logicalMax - field.logicalMin + 1));
+        } else {
+            js.*field.axis = ScaleValue(field, raw);
+        }
+    }
+}
+
+LONG HidDevice::ScaleValue(const ValueField& field, ULONG raw) const
+{
+    LONG value = static_cast<LONG>(raw);
+    if (field.logicalMin < 0 && field.bitSize > 0 && field.bitSize < 32) {
+        // Sign-extend fields whose logical range is signed
+        const ULONG signBit = 1ul << (field.bitSize - 1);
+        value = static_cast<LONG>((raw ^ signBit) - signBit);
+    }
+    if (field.logicalMax <= field.logicalMin) {
+        return 0;
+    }
+
+    // logicalMin..logicalMax -> AXIS_RANGE_MIN..AXIS_RANGE_MAX
+    value = std::clamp(value, field.logicalMin, field.logicalMax);
+    return AppConstants::AXIS_RANGE_MIN + static_cast<LONG>(
+        static_cast<LONGLONG>(value - field.logicalMin) * (AppConstants::AXIS_RANGE_MAX - AppConstants::AXIS_RANGE_MIN) /
+        (static_cast<LONGLONG>(field.logicalMax) - field.logicalMin));
+}
+
+bool HidDevice::TryToReconnect(HWND)
+{
+    if (m_connected) {
+        return true;
+    }
+
+    LOG_INFO_W(L"Attempting to reconnect device: " + m_deviceName);
+
+    // Same interface path, same descriptor: the report plan stays valid
+    if (!m_preparsed || !OpenDevice()) {
+        return false;
+    }
+    if (!IssueRead()) {
+        CloseFile();
+        return false;
+    }
+
+    ResetState();
+    m_connected = true;
+    ResetReconnectBackoff();
+    LOG_INFO_W(L"Device reconnected successfully: " + m_deviceName);
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "GamepadDevice.h"
+#include <hidsdi.h>
+#include <hidpi.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief HID backend: overlapped ReadFile on the controller's HID interface
+ *
+ * Meant for high polling rate sticks. The driver keeps a queue of input
+ * reports (HidD_SetNumInputBuffers); one overlapped read is always
+ * outstanding and its event wakes the input thread. ReadInput drains every
+ * completed report and feeds each one to the processor, so no report is
+ * collapsed into a later snapshot the way GetDeviceState collapses them.
+ *
+ * The preparsed report descriptor is fetched once in Initialize and the
+ * fields the mapping uses are compiled into a plan: buttons go to
+ * rgbButtons (usage - 1), Generic Desktop X/Y/Z/Rx/Ry/Rz to the matching
+ * axes scaled to the DirectInput range, the first hat switch to
+ * POV 0. Reports are parsed in place into the device's DIJOYSTATE2, which
+ * is what DirectInput would report for the same descriptor, so
+ * analog_layout and existing mappings carry over.
+ */
+class HidDevice final : public GamepadDevice {
+public:
+    // A game controller HID interface (from the raw input device list)
+    struct ControllerInfo {
+        std::wstring path;
+        DWORD productId = 0; // MAKELONG(VID, PID), as in DIDEVICEINSTANCE::guidProduct.Data1
+        bool xinput = false; // "IG_" interface: driven by XInput
+    };
+
+    HidDevice() = default;
+    ~HidDevice() override;
+
+    static std::vector<ControllerInfo> ListControllers();
+    static GUID MakeGuid(const std::wstring& path);
+
+    // Initialization
+    bool Initialize(const ControllerInfo& controller);
+
+    const wchar_t* GetBackendName() const override { return L"HID"; }
+    HANDLE GetInputEvent() const override { return m_readEvent.get(); }
+    bool TryToReconnect(HWND hWnd) override;
+
+protected:
+    bool ReadInput() override;
+    void CloseDevice() override;
+
+private:
+    struct ValueField {
+        USAGE usagePage = 0;
+        USAGE usage = 0;
+        USHORT linkCollection = 0;
+        USHORT bitSize = 0;
+        LONG logicalMin = 0;
+        LONG logicalMax = 0;
+        bool isHat = false;
+        LONG DIJOYSTATE2::* axis = nullptr; // Unused for the hat
+    };
+
+    bool OpenDevice();
+    void CloseFile();                 // Keeps the report plan for reconnecting
+    bool BuildReportPlan();
+    bool IssueRead();                 // false: device lost
+    void ResetState();
+    void ApplyReport(ULONG length);   // Parses m_report into m_currentState
+    LONG ScaleValue(const ValueField& field, ULONG raw) const;
+
+    std::wstring m_path;
+    UniqueHandle m_file;
+    UniqueHandle m_readEvent;         // Manual reset, owned by m_overlapped
+    OVERLAPPED m_overlapped{};
+    bool m_readPending = false;
+
+    // Report descriptor (cached at Initialize)
+    PHIDP_PREPARSED_DATA m_preparsed = nullptr;
+    HIDP_CAPS m_caps{};
+    bool m_hasButtons = false;
+    std::vector<ValueField> m_valueFields;
+    std::vector<BYTE> m_report;       // InputReportByteLength, reused
+    std::vector<USAGE> m_usages;      // Pressed-button scratch, reused
+};
@@ -2,9 +2,49 @@
 #include "ConfigManager.h"
 #include "Logger.h"
 #include "DisplayBuffer.h"
+#include "LatencyStats.h"
+#include "KeyScheduler.h"
 #include <cstring>
+#include <cwchar>
 #include <algorithm>
+#include <iterator>
+#include <bit>
 
+namespace {
+
+// Indexed by AxisDirection
+constexpr const char* DIRECTION_NAMES[] = { "Left", "Right", "Up", "Down" };
+constexpr const wchar_t* DIRECTION_NAMES_W[] = { L"Left", L"Right", L"Up", L"Down" };
+
+// Indexed by AnalogSource (left stick names kept short as before)
+constexpr const char* ANALOG_SOURCE_NAMES[] = {
+    "Left", "Right", "Up", "Down",
+    "RStick Left", "RStick Right", "RStick Up", "RStick Down",
+    "LTrigger", "RTrigger",
+};
+constexpr const wchar_t* ANALOG_SOURCE_NAMES_W[] = {
+    L"Left", L"Right", L"Up", L"Down",
+    L"RStick Left", L"RStick Right", L"RStick Up", L"RStick Down",
+    L"LTrigger", L"RTrigger",
+};
+static_assert(std::size(ANALOG_SOURCE_NAMES) == ANALOG_SOURCE_COUNT);
+static_assert(std::size(ANALOG_SOURCE_NAMES_W) == ANALOG_SOURCE_COUNT);
+
+// Formats "0x41+0x42" into a caller-provided buffer (display only, no heap)
+template<size_t N>
+const wchar_t* FormatKeySequence(std::span<const WORD> vks, wchar_t (&buffer)[N])
+{
+    size_t pos = 0;
+    buffer[0] = L'\0';
+    for (size_t i = 0; i < vks.size() && pos + 8 < N; ++i) {
+        int written = swprintf_s(buffer + pos, N - pos, i > 0 ? L"+0x%02X" : L"0x%02X", vks[i]);
+        if (written < 0) break;
+        pos += static_cast<size_t>(written);
+    }
+    return buffer;
+}
+
+} // namespace
 
 // =====================================
 // InputProcessor Class Implementation
@@ -23,6 +63,7 @@ InputProcessor::InputProcessor(const ConfigManager& config)
     , m_configManager(&config)
     , m_displayBuffer(nullptr)
 {
+    ConfigureAnalog(config);
     InitializeState();
 }
 
@@ -31,12 +72,47 @@ InputProcessor::InputProcessor(const ConfigManager& config, DisplayBuffer* displ
     , m_configManager(&config)
     , m_displayBuffer(displayBuffer)
 {
+    ConfigureAnalog(config);
     InitializeState();
 }
 
+InputProcessor::InputProcessor(const ConfigManager& config, DisplayBuffer* displayBuffer, IInputSink& sink)
+    : m_prevPOV(0xFFFFFFFF)
+    , m_configManager(&config)
+    , m_displayBuffer(displayBuffer)
+    , m_localQueue(sink, LOCAL_QUEUE_CAPACITY)
+{
+    ConfigureAnalog(config);
+    InitializeState();
+}
+
+InputProcessor::~InputProcessor()
+{
+    // Keys a timed event already pressed would otherwise stay down (and counted as held)
+    if (m_scheduler) {
+        CancelTimedEvents(KeyScheduler::ANY_TAG);
+    }
+}
+
 void InputProcessor::SetConfig(const ConfigManager& config)
 {
     m_configManager = &config;
+    ConfigureAnalog(config);
+}
+
+void InputProcessor::SetNativeAnalogLayout(AnalogLayout layout)
+{
+    m_nativeLayout = layout;
+    ConfigureAnalog(*m_configManager);
+}
+
+void InputProcessor::ConfigureAnalog(const ConfigManager& config)
+{
+    AnalogSettings settings = config.getAnalogSettings();
+    if (m_nativeLayout) {
+        settings.layout = *m_nativeLayout;
+    }
+    m_analog.Configure(settings);
 }
 
 void InputProcessor::InitializeState()
@@ -46,137 +122,328 @@ void InputProcessor::InitializeState()
 
 void InputProcessor::ResetState()
 {
-    m_prevButtons.fill(false);
+    m_prevButtons = {};
+    m_prevRawButtons = {};
+    m_holdScheduled = {};
+    m_activeChords = 0;
+    m_consumedButtons = {};
     m_prevPOV = 0xFFFFFFFF;
     m_prevAxisDown.fill(false);
+    m_analog.Reset();
 }
 
-void InputProcessor::SendVirtualKeySequence(const std::vector<WORD>& vks, bool down)
+void InputProcessor::ReleaseAllKeys()
+{
+    if (m_configManager) {
+        const CompiledKeyMap& keyMap = m_configManager->getKeyMap();
+        
+        // Timed buttons release through the scheduler, which knows whether their keys are down
+        m_prevButtons.ForEachSetBit([&](size_t i) {
+            if (m_scheduler && keyMap.timedButtons().Test(i)) {
+                ReleaseTimedButton(i, false);
+            } else {
+                SendVirtualKeySequence(keyMap.buttonKeys(i), false);
+            }
+        });
+        
+        // Whatever is still scheduled (macros, taps) gives back the keys it pressed
+        if (m_scheduler) {
+            CancelTimedEvents(KeyScheduler::ANY_TAG);
+        }
+        
+        const auto chords = keyMap.chords();
+        for (size_t c = 0; c < chords.size(); ++c) {
+            if ((m_activeChords >> c) & 1) {
+                SendVirtualKeySequence(keyMap.chordKeys(chords[c]), false);
+            }
+        }
+        
+        for (size_t direction = 0; direction < AXIS_DIRECTIONS; ++direction) {
+            if (m_prevAxisDown[direction]) {
+                SendVirtualKeySequence(keyMap.dpadKeys(direction), false);
+            }
+        }
+        const AnalogEngine::SourceMask held = m_analog.Active();
+        for (size_t source = 0; source < ANALOG_SOURCE_COUNT; ++source) {
+            if ((held >> source) & 1) {
+                SendVirtualKeySequence(keyMap.analogKeys(source), false);
+            }
+        }
+    }
+    
+    ResetState();
+}
+
+void InputProcessor::SendVirtualKeySequence(std::span<const WORD> vks, bool down)
 {
     if (vks.empty()) return;
     
-    auto inputs = CreateKeyInputSequence(vks, down);
-    SendInputSequence(inputs);
+    if (m_latency) {
+        m_latency->OnMapped(Qpc::Now());
+    }
     
-    // ログ出力（シーケンス表示）
-    std::wstring seq;
-    for (size_t i = 0; i < vks.size(); ++i) {
-        wchar_t buf[32];
-        swprintf_s(buf, L"0x%02X", vks[i]);
-        if (i) seq += L"+";
-        seq += buf;
+    if (m_inputQueue) {
+        // Sent with the rest of the frame's events by GamepadManager
+        m_inputQueue->AppendKeySequence(vks, down);
+    } else {
+        m_localQueue.AppendKeySequence(vks, down);
+        m_localQueue.Flush();
+        if (m_latency) {
+            m_latency->OnSent(Qpc::Now());
+        }
     }
+    
     // Display input sequence information
-    if (m_displayBuffer) {
-        m_displayBuffer->AddFormattedLine(L"SendInputSeq: %s %s", seq.c_str(), down ? L"DOWN" : L"UP");
+    if (m_displayBuffer && m_displayBuffer->IsEnabled()) {
+        wchar_t seq[128];
+        m_displayBuffer->AddFormattedLine(L"SendInputSeq: %s %s", FormatKeySequence(vks, seq), down ? L"DOWN" : L"UP");
     }
 }
 
 void InputProcessor::SendVirtualKey(WORD vk, bool down)
 {
     if (vk == 0) return;
-    std::vector<WORD> seq = { vk };
+    const WORD seq[] = { vk };
     SendVirtualKeySequence(seq, down);
 }
 
-std::vector<INPUT> InputProcessor::CreateKeyInputSequence(const std::vector<WORD>& vks, bool down)
+void InputProcessor::ProcessGamepadInput(const DIJOYSTATE2& js)
 {
-    size_t n = vks.size();
-    std::vector<INPUT> inputs;
-    inputs.reserve(n);
-    
-    if (down) {
-        // Press keys in order
-        for (size_t i = 0; i < n; ++i) {
-            INPUT ip{};
-            ip.type = INPUT_KEYBOARD;
-            ip.ki.wVk = vks[i];
-            ip.ki.dwFlags = 0;
-            inputs.push_back(ip);
-        }
-    } else {
-        // Release keys in reverse order
-        for (size_t i = 0; i < n; ++i) {
-            INPUT ip{};
-            ip.type = INPUT_KEYBOARD;
-            ip.ki.wVk = vks[n - 1 - i];
-            ip.ki.dwFlags = KEYEVENTF_KEYUP;
-            inputs.push_back(ip);
-        }
+    if (!m_configManager) {
+        // No configuration available, cannot process input
+        return;
     }
     
-    return inputs;
+    ProcessButtons(js);
+    ProcessPOV(js);
+    ProcessAnalogSticks(js);
 }
 
-void InputProcessor::SendInputSequence(const std::vector<INPUT>& inputs)
+void InputProcessor::ProcessButtons(const DIJOYSTATE2& js)
 {
-    if (!inputs.empty()) {
-        SendInput(static_cast<UINT>(inputs.size()), 
-                 const_cast<INPUT*>(inputs.data()), 
-                 sizeof(INPUT));
+    // Diff the packed button state against the previous frame, restricted to mapped buttons
+    const CompiledKeyMap& keyMap = m_configManager->getKeyMap();
+    const ButtonMask current = ButtonMask::FromButtons(js.rgbButtons) & keyMap.mappedButtons();
+    if (current == m_prevRawButtons) {
+        return; // Common case: nothing changed
+    }
+    
+    // Chords decide first which held buttons they consume
+    const uint64_t chordsChanged = keyMap.chords().empty() ? 0 : EvaluateChords(current);
+    m_prevRawButtons = current;
+    
+    // Individual mappings only see buttons no chord has claimed
+    const ButtonMask effective = current & ~m_consumedButtons;
+    const ButtonMask changed = effective ^ m_prevButtons;
+    changed.ForEachSetBit([&](size_t i) {
+        ProcessButtonInternal(i, effective.Test(i));
+    });
+    m_prevButtons = effective;
+    
+    // Chord keys go after the individual releases they caused
+    for (uint64_t bits = chordsChanged; bits != 0; bits &= bits - 1) {
+        const size_t c = static_cast<size_t>(std::countr_zero(bits));
+        ProcessChord(c, (m_activeChords >> c) & 1);
     }
 }
 
-void InputProcessor::ProcessGamepadInput(const DIJOYSTATE2& js)
+uint64_t InputProcessor::EvaluateChords(const ButtonMask& current)
 {
-    if (!m_configManager) {
-        // No configuration available, cannot process input
-        return;
+    const CompiledKeyMap& keyMap = m_configManager->getKeyMap();
+    const ButtonMask pressed = current & ~m_prevRawButtons;
+    pressed.ForEachSetBit([&](size_t i) {
+        m_pressOrder[i] = ++m_pressCounter;
+    });
+    
+    // A consumed button stays silent until it is released
+    m_consumedButtons = m_consumedButtons & current;
+    
+    // Largest chords first: an active or newly completed chord claims its buttons, so a
+    // smaller chord sharing any of them cannot fire (or is taken over) in the same frame.
+    // A chord only starts on a frame where one of its buttons went down.
+    const auto chords = keyMap.chords();
+    ButtonMask claimed;
+    uint64_t active = 0;
+    for (size_t c = 0; c < chords.size(); ++c) {
+        const CompiledKeyMap::Chord& chord = chords[c];
+        if ((current & chord.buttons) != chord.buttons || (claimed & chord.buttons).Any()) {
+            continue;
+        }
+        const bool wasActive = (m_activeChords >> c) & 1;
+        if (wasActive || ((pressed & chord.buttons).Any() && PressOrderMatches(keyMap.chordOrder(chord)))) {
+            active |= uint64_t{1} << c;
+            claimed = claimed | chord.buttons;
+        }
     }
     
-    ProcessButtons(js);
-    ProcessPOV(js);
-    ProcessAnalogSticks(js);
+    m_consumedButtons = m_consumedButtons | claimed;
+    const uint64_t changed = active ^ m_activeChords;
+    m_activeChords = active;
+    return changed;
 }
 
-void InputProcessor::ProcessButtons(const DIJOYSTATE2& js)
+bool InputProcessor::PressOrderMatches(std::span<const uint8_t> order) const
 {
-    // Process all buttons with mappings
-    for (size_t i = 0; i < MAX_BUTTONS; ++i) {
-        const auto& vks = m_configManager->getButtonKeys(static_cast<int>(i));
-        if (vks.empty()) continue;
-        
-        bool pressed = (js.rgbButtons[i] & 0x80) != 0;
-        if (pressed != m_prevButtons[i]) {
-            ProcessButtonInternal(i, pressed);
-            m_prevButtons[i] = pressed;
+    // Empty order: any press order is fine
+    for (size_t i = 1; i < order.size(); ++i) {
+        if (m_pressOrder[order[i - 1]] >= m_pressOrder[order[i]]) {
+            return false;
         }
     }
+    return true;
 }
 
-void InputProcessor::ProcessButtonInternal(size_t buttonIndex, bool pressed)
+void InputProcessor::ProcessChord(size_t chordIndex, bool active)
 {
-    const auto& vks = m_configManager->getButtonKeys(static_cast<int>(buttonIndex));
+    const CompiledKeyMap& keyMap = m_configManager->getKeyMap();
+    const auto vks = keyMap.chordKeys(keyMap.chords()[chordIndex]);
     
-    // Log detailed button event with configuration info
-    std::wstring vkSeq;
-    for (size_t i = 0; i < vks.size(); ++i) {
-        if (i > 0) vkSeq += L"+";
-        wchar_t buf[16];
-        swprintf_s(buf, L"0x%02X", vks[i]);
-        vkSeq += buf;
-    }
+    LOG_DEBUG("Chord{} -> Keys[{}] {} (Config: {})", chordIndex, VkSequence{ vks },
+              active ? "ON" : "OFF", m_configManager->getConfigPath());
     
-    std::wstring configPath;
-    try {
-        configPath = m_configManager->getConfigFilePath();
-    } catch (...) {
-        configPath = L"[config path error]";
+    if (m_displayBuffer && m_displayBuffer->IsEnabled()) {
+        wchar_t vkSeq[128];
+        m_displayBuffer->AddFormattedLine(L"Chord%zu -> Keys[%s] %s", chordIndex,
+                                          FormatKeySequence(vks, vkSeq), active ? L"ON" : L"OFF");
     }
-    LOG_DEBUG_W(L"Button" + std::to_wstring(buttonIndex) + L" -> Keys[" + vkSeq + L"] " + 
-               (pressed ? L"PRESSED" : L"RELEASED") + L" (Config: " + configPath + L")");
+    
+    SendVirtualKeySequence(vks, active);
+}
+
+void InputProcessor::ProcessButtonInternal(size_t buttonIndex, bool pressed)
+{
+    const auto vks = m_configManager->getKeyMap().buttonKeys(buttonIndex);
+    
+    // Structured fields: nothing is formatted unless debug logging is enabled
+    LOG_DEBUG("Button{} -> Keys[{}] {} (Config: {})", buttonIndex, VkSequence{ vks },
+              pressed ? "PRESSED" : "RELEASED", m_configManager->getConfigPath());
     
     // Display button event information
-    if (m_displayBuffer) {
+    if (m_displayBuffer && m_displayBuffer->IsEnabled()) {
+        wchar_t vkSeq[128];
         m_displayBuffer->AddFormattedLine(L"Button%zu -> Keys[%s] %s", 
                         buttonIndex, 
-                        vkSeq.c_str(), 
+                        FormatKeySequence(vks, vkSeq), 
                         pressed ? L"PRESSED" : L"RELEASED");
     }
     
+    if (m_scheduler && m_configManager->getKeyMap().timedButtons().Test(buttonIndex)) {
+        ProcessTimedButton(buttonIndex, pressed);
+        return;
+    }
+    
     SendVirtualKeySequence(vks, pressed);
 }
 
+void InputProcessor::ProcessTimedButton(size_t buttonIndex, bool pressed)
+{
+    const CompiledKeyMap& keyMap = m_configManager->getKeyMap();
+    const CompiledKeyMap::ButtonTiming& timing = keyMap.buttonTiming(buttonIndex);
+    const auto vks = keyMap.buttonKeys(buttonIndex);
+    const uint16_t tag = static_cast<uint16_t>(buttonIndex);
+    
+    if (!pressed) {
+        ReleaseTimedButton(buttonIndex, true);
+        return;
+    }
+    
+    if (timing.macroCount > 0) {
+        StartMacro(buttonIndex);
+    } else if (timing.holdMs > 0) {
+        // Without a pending hold (pool full) the release can only tap
+        if (m_scheduler->Schedule(this, tag, keyMap.holdKeys(buttonIndex), true, timing.holdMs)) {
+            m_holdScheduled.Set(buttonIndex);
+        }
+    } else {
+        SendVirtualKeySequence(vks, true);
+        if (timing.turboMs > 0) {
+            const uint32_t halfPeriod = (std::max)(timing.turboMs / 2, 1);
+            m_scheduler->Schedule(this, tag, vks, false, halfPeriod, KeyScheduler::Repeat::Toggle, halfPeriod);
+        } else {
+            m_scheduler->Schedule(this, tag, vks, true, timing.repeatDelayMs, KeyScheduler::Repeat::Press,
+                                  timing.repeatIntervalMs);
+        }
+    }
+}
+
+void InputProcessor::ReleaseTimedButton(size_t buttonIndex, bool allowTap)
+{
+    const CompiledKeyMap& keyMap = m_configManager->getKeyMap();
+    const CompiledKeyMap::ButtonTiming& timing = keyMap.buttonTiming(buttonIndex);
+    const auto vks = keyMap.buttonKeys(buttonIndex);
+    const uint16_t tag = static_cast<uint16_t>(buttonIndex);
+    
+    if (timing.macroCount > 0) {
+        return; // A macro runs to completion once started
+    }
+    
+    if (timing.holdMs > 0) {
+        // Scheduled and no longer pending: the hold fired and its keys are down
+        const bool scheduled = m_holdScheduled.Test(buttonIndex);
+        m_holdScheduled.Reset(buttonIndex);
+        const bool fired = scheduled && m_scheduler->Cancel(this, tag).cancelled == 0;
+        if (fired) {
+            SendVirtualKeySequence(keyMap.holdKeys(buttonIndex), false);
+        } else if (allowTap) {
+            // Released before the hold fired: tap the regular keys (their release has its own tag,
+            // so pressing the button again right away cannot cancel it)
+            const uint16_t tapTag = static_cast<uint16_t>(MAX_BUTTONS + buttonIndex);
+            SendVirtualKeySequence(vks, true);
+            if (!m_scheduler->Schedule(this, tapTag, vks, false, AppConstants::TAP_KEY_DURATION_MS)) {
+                SendVirtualKeySequence(vks, false);
+            }
+        }
+        return;
+    }
+    
+    // Turbo: a pending toggle-up is released by the cancel; one that could never be scheduled is still down.
+    // Repeat: the initial press is always still down.
+    const KeyScheduler::CancelResult result = CancelTimedEvents(tag);
+    if (timing.turboMs == 0 || result.cancelled == 0) {
+        SendVirtualKeySequence(vks, false);
+    }
+}
+
+KeyScheduler::CancelResult InputProcessor::CancelTimedEvents(uint32_t tag)
+{
+    if (m_inputQueue) {
+        return m_scheduler->Cancel(this, tag, m_inputQueue);
+    }
+    const KeyScheduler::CancelResult result = m_scheduler->Cancel(this, tag, &m_localQueue);
+    m_localQueue.Flush();
+    return result;
+}
+
+void InputProcessor::StartMacro(size_t buttonIndex)
+{
+    const CompiledKeyMap& keyMap = m_configManager->getKeyMap();
+    const uint16_t tag = static_cast<uint16_t>(buttonIndex);
+    
+    uint32_t at = 0;
+    for (const auto& step : keyMap.macroSteps(buttonIndex)) {
+        const auto keys = keyMap.stepKeys(step);
+        const uint32_t holdMs = (std::max<uint32_t>)(step.holdMs, 1); // Up always lands in a later frame
+        
+        // The first step presses now and only schedules its release; later steps schedule both.
+        // If the pool is full a step is skipped, never left held or released unpressed.
+        if (!keys.empty()) {
+            bool scheduled;
+            if (at == 0) {
+                scheduled = m_scheduler->Schedule(this, tag, keys, false, holdMs);
+                if (scheduled) {
+                    SendVirtualKeySequence(keys, true);
+                }
+            } else {
+                scheduled = m_scheduler->SchedulePress(this, tag, keys, at, holdMs);
+            }
+            if (!scheduled) {
+                LOG_WARN("Key scheduler full: macro on button {} truncated", buttonIndex);
+            }
+        }
+        at += holdMs + step.waitMs;
+    }
+}
+
 void InputProcessor::ProcessPOV(const DIJOYSTATE2& js)
 {
     // POV (Hat) -> Map to configured directions
@@ -213,42 +480,16 @@ void InputProcessor::ProcessPOV(const DIJOYSTATE2& js)
 
 void InputProcessor::ProcessPOVDirection(size_t direction, bool active)
 {
-    std::string dirStr;
-    switch (direction) {
-        case AX_UP: dirStr = "up"; break;
-        case AX_DOWN: dirStr = "down"; break;
-        case AX_LEFT: dirStr = "left"; break;
-        case AX_RIGHT: dirStr = "right"; break;
-        default: return;
-    }
-
-    const auto& vks = m_configManager->getDpadKeys(dirStr);
+    const auto vks = m_configManager->getDpadKeys(direction);
     if (!vks.empty()) {
-        // Log detailed POV event with configuration info
-        std::wstring vkSeq;
-        for (size_t i = 0; i < vks.size(); ++i) {
-            if (i > 0) vkSeq += L"+";
-            wchar_t buf[16];
-            swprintf_s(buf, L"0x%02X", vks[i]);
-            vkSeq += buf;
-        }
-        
-        const wchar_t* dirName = (direction == AX_UP) ? L"Up" : 
-                                (direction == AX_DOWN) ? L"Down" :
-                                (direction == AX_LEFT) ? L"Left" : L"Right";
-        
-        std::wstring configPath;
-        try {
-            configPath = m_configManager->getConfigFilePath();
-        } catch (...) {
-            configPath = L"[config path error]";
-        }
-        LOG_DEBUG_W(L"POV " + std::wstring(dirName) + L" -> Keys[" + vkSeq + L"] " + 
-                   (active ? L"ON" : L"OFF") + L" (Config: " + configPath + L")");
+        LOG_DEBUG("POV {} -> Keys[{}] {} (Config: {})", DIRECTION_NAMES[direction], VkSequence{ vks },
+                  active ? "ON" : "OFF", m_configManager->getConfigPath());
         
         // Display POV event information
-        if (m_displayBuffer) {
-            m_displayBuffer->AddFormattedLine(L"POV %s -> Keys[%s] %s", dirName, vkSeq.c_str(), active ? L"ON" : L"OFF");
+        if (m_displayBuffer && m_displayBuffer->IsEnabled()) {
+            wchar_t vkSeq[128];
+            m_displayBuffer->AddFormattedLine(L"POV %s -> Keys[%s] %s", DIRECTION_NAMES_W[direction],
+                                              FormatKeySequence(vks, vkSeq), active ? L"ON" : L"OFF");
         }
         
         SendVirtualKeySequence(vks, active);
@@ -257,73 +498,34 @@ void InputProcessor::ProcessPOVDirection(size_t direction, bool active)
 
 void InputProcessor::ProcessAnalogSticks(const DIJOYSTATE2& js)
 {
-    // Left stick (X/Y) -> Map to configured keys with threshold
-    LONG threshold = m_configManager->getStickThreshold();
-    bool stickLeft = js.lX < -threshold;
-    bool stickRight = js.lX > threshold;
-    bool stickUp = js.lY < -threshold;    // Up is negative direction
-    bool stickDown = js.lY > threshold;
-
-    // Process each axis direction if it has changed
-    if (stickLeft != m_prevAxisDown[AX_LEFT]) {
-        ProcessAxisDirection(AX_LEFT, stickLeft);
-        m_prevAxisDown[AX_LEFT] = stickLeft;
-    }
-    if (stickRight != m_prevAxisDown[AX_RIGHT]) {
-        ProcessAxisDirection(AX_RIGHT, stickRight);
-        m_prevAxisDown[AX_RIGHT] = stickRight;
+    // All six axes are shaped and thresholded in one pass; only real transitions come back
+    const AnalogEngine::SourceMask changed = m_analog.Update(js);
+    if (changed == 0) {
+        return; // Common case: nothing crossed a threshold
     }
-    if (stickUp != m_prevAxisDown[AX_UP]) {
-        ProcessAxisDirection(AX_UP, stickUp);
-        m_prevAxisDown[AX_UP] = stickUp;
-    }
-    if (stickDown != m_prevAxisDown[AX_DOWN]) {
-        ProcessAxisDirection(AX_DOWN, stickDown);
-        m_prevAxisDown[AX_DOWN] = stickDown;
+    
+    const AnalogEngine::SourceMask active = m_analog.Active();
+    for (size_t source = 0; source < ANALOG_SOURCE_COUNT; ++source) {
+        if ((changed >> source) & 1) {
+            ProcessAnalogSource(source, (active >> source) & 1);
+        }
     }
 }
 
-void InputProcessor::ProcessAxisDirection(size_t direction, bool active)
+void InputProcessor::ProcessAnalogSource(size_t source, bool active)
 {
-    std::string dirStr;
-    switch (direction) {
-        case AX_UP: dirStr = "up"; break;
-        case AX_DOWN: dirStr = "down"; break;
-        case AX_LEFT: dirStr = "left"; break;
-        case AX_RIGHT: dirStr = "right"; break;
-        default: return;
-    }
-
-    const auto& vks = m_configManager->getStickKeys(dirStr);
+    const auto vks = m_configManager->getKeyMap().analogKeys(source);
     if (!vks.empty()) {
-        // Log detailed axis event with configuration info
-        std::wstring vkSeq;
-        for (size_t i = 0; i < vks.size(); ++i) {
-            if (i > 0) vkSeq += L"+";
-            wchar_t buf[16];
-            swprintf_s(buf, L"0x%02X", vks[i]);
-            vkSeq += buf;
-        }
-        
-        const wchar_t* dirName = (direction == AX_UP) ? L"Up" : 
-                                (direction == AX_DOWN) ? L"Down" :
-                                (direction == AX_LEFT) ? L"Left" : L"Right";
-        
-        std::wstring configPath;
-        try {
-            configPath = m_configManager->getConfigFilePath();
-        } catch (...) {
-            configPath = L"[config path error]";
-        }
-        LOG_DEBUG_W(L"Axis " + std::wstring(dirName) + L" -> Keys[" + vkSeq + L"] " + 
-                   (active ? L"ON" : L"OFF") + L" (Config: " + configPath + L")");
+        LOG_DEBUG("Axis {} -> Keys[{}] {} (Config: {})", ANALOG_SOURCE_NAMES[source], VkSequence{ vks },
+                  active ? "ON" : "OFF", m_configManager->getConfigPath());
         
         // Display axis event information
-        if (m_displayBuffer) {
-            m_displayBuffer->AddFormattedLine(L"Axis %s -> Keys[%s] %s", dirName, vkSeq.c_str(), active ? L"ON" : L"OFF");
+        if (m_displayBuffer && m_displayBuffer->IsEnabled()) {
+            wchar_t vkSeq[128];
+            m_displayBuffer->AddFormattedLine(L"Axis %s -> Keys[%s] %s", ANALOG_SOURCE_NAMES_W[source],
+                                              FormatKeySequence(vks, vkSeq), active ? L"ON" : L"OFF");
         }
         
         SendVirtualKeySequence(vks, active);
     }
 }
-
@@ -3,12 +3,19 @@
 #include <dinput.h>
 #include <vector>
 #include <array>
+#include <span>
 #include <memory>
+#include <optional>
 #include "Constants.h"
+#include "ButtonMask.h"
+#include "AnalogEngine.h"
+#include "InputQueue.h"
+#include "KeyScheduler.h"
 
 // Forward declarations
 class ConfigManager;
 class DisplayBuffer;
+class DeviceLatencyStats;
 
 class InputProcessor {
 public:
@@ -16,24 +23,42 @@ public:
     InputProcessor();
     explicit InputProcessor(const ConfigManager& config);
     InputProcessor(const ConfigManager& config, DisplayBuffer* displayBuffer);
-    ~InputProcessor() = default;
+    InputProcessor(const ConfigManager& config, DisplayBuffer* displayBuffer, IInputSink& sink);
+    ~InputProcessor();
     
-    // Non-copyable, but movable
+    // Non-copyable and non-movable: scheduled events are owned by this address
     InputProcessor(const InputProcessor&) = delete;
     InputProcessor& operator=(const InputProcessor&) = delete;
-    InputProcessor(InputProcessor&&) = default;
-    InputProcessor& operator=(InputProcessor&&) = default;
+    InputProcessor(InputProcessor&&) = delete;
+    InputProcessor& operator=(InputProcessor&&) = delete;
     
     // Configuration management
     void SetConfig(const ConfigManager& config);
     const ConfigManager* GetConfig() const { return m_configManager; }
     
+    // Backends that always fill the axes the same way (XInput) override the config's analog_layout
+    void SetNativeAnalogLayout(AnalogLayout layout);
+    
     // Display management
     void SetDisplayBuffer(DisplayBuffer* displayBuffer) { m_displayBuffer = displayBuffer; }
     
+    // Injection queue (shared, flushed once per frame by GamepadManager).
+    // Without one, each transition is sent immediately to the sink (SendInput by default).
+    void SetInputQueue(InputQueue* inputQueue) { m_inputQueue = inputQueue; }
+    void SetInputSink(IInputSink& sink) { m_localQueue.SetSink(sink); }
+    
+    // Latency instrumentation (owned by the device)
+    void SetLatencyStats(DeviceLatencyStats* latency) { m_latency = latency; }
+    
+    // Timed key events (turbo, hold-to-repeat, macros; shared, owned by GamepadManager).
+    // Events are keyed by this object's address. Without a scheduler, timed buttons act as plain buttons.
+    void SetKeyScheduler(KeyScheduler* scheduler) { m_scheduler = scheduler; }
+    
     // State management
     void InitializeState();
     void ResetState();
+    // Sends key-up for everything currently held under the active mapping, then resets state
+    void ReleaseAllKeys();
     
     // Main processing method
     void ProcessGamepadInput(const DIJOYSTATE2& js);
@@ -41,11 +66,11 @@ public:
     // Individual input type processors
     void ProcessButtons(const DIJOYSTATE2& js);
     void ProcessPOV(const DIJOYSTATE2& js);
-    void ProcessAnalogSticks(const DIJOYSTATE2& js);
+    void ProcessAnalogSticks(const DIJOYSTATE2& js); // Both sticks and the analog triggers
     
     // Key sending methods
     void SendVirtualKey(WORD vk, bool down);
-    void SendVirtualKeySequence(const std::vector<WORD>& vks, bool down);
+    void SendVirtualKeySequence(std::span<const WORD> vks, bool down);
 
 private:
     // Internal state management
@@ -53,9 +78,19 @@ private:
     static constexpr size_t AXIS_DIRECTIONS = AppConstants::AXIS_DIRECTIONS;
     
     // State tracking (encapsulated)
-    std::array<bool, MAX_BUTTONS> m_prevButtons;
+    ButtonMask m_prevButtons;      // Individual button state last emitted (mapped, not consumed by a chord)
+    ButtonMask m_prevRawButtons;   // Last seen state of mapped buttons
+    
+    // Chords (bit c <=> CompiledKeyMap::chords()[c])
+    uint64_t m_activeChords = 0;
+    ButtonMask m_consumedButtons;  // Held buttons claimed by a chord; silent until released
+    ButtonMask m_holdScheduled;    // Hold buttons whose long-press event got into the scheduler
+    std::array<uint32_t, MAX_BUTTONS> m_pressOrder{}; // Press sequence numbers for ordered chords
+    uint32_t m_pressCounter = 0;
     DWORD m_prevPOV;
-    std::array<bool, AXIS_DIRECTIONS> m_prevAxisDown; // 0: left, 1: right, 2: up, 3: down
+    std::array<bool, AXIS_DIRECTIONS> m_prevAxisDown; // D-pad (POV) directions, indexed by AxisDirection
+    AnalogEngine m_analog; // Stick/trigger state with hysteresis
+    std::optional<AnalogLayout> m_nativeLayout;
     
     // Configuration reference
     const ConfigManager* m_configManager;
@@ -63,11 +98,24 @@ private:
     // Display buffer for screen output (not logging)
     DisplayBuffer* m_displayBuffer;
     
+    // Key injection
+    static constexpr size_t LOCAL_QUEUE_CAPACITY = 16;
+    InputQueue* m_inputQueue = nullptr;
+    InputQueue m_localQueue{ LOCAL_QUEUE_CAPACITY };
+    DeviceLatencyStats* m_latency = nullptr;
+    KeyScheduler* m_scheduler = nullptr;
+    
     // Helper methods
     void ProcessButtonInternal(size_t buttonIndex, bool pressed);
+    void ProcessTimedButton(size_t buttonIndex, bool pressed);
+    void ReleaseTimedButton(size_t buttonIndex, bool allowTap);
+    KeyScheduler::CancelResult CancelTimedEvents(uint32_t tag); // Owed key-ups go to this processor's queue
+    uint64_t EvaluateChords(const ButtonMask& current);
+    bool PressOrderMatches(std::span<const uint8_t> order) const;
+    void ProcessChord(size_t chordIndex, bool active);
+    void StartMacro(size_t buttonIndex);
+    void ConfigureAnalog(const ConfigManager& config);
     void ProcessPOVDirection(size_t direction, bool active);
-    void ProcessAxisDirection(size_t direction, bool active);
-    void SendInputSequence(const std::vector<INPUT>& inputs);
-    std::vector<INPUT> CreateKeyInputSequence(const std::vector<WORD>& vks, bool down);
+    void ProcessAnalogSource(size_t source, bool active);
 };
 
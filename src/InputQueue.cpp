@@ -0,0 +1,95 @@
+#include "InputQueue.h"
+#include "KeyStateTable.h"
+#include "Logger.h"
+#include <algorithm>
+
+InputQueue::InputQueue(size_t capacity)
+    : InputQueue(SendInputSink::Default(), capacity)
+{
+}
+
+InputQueue::InputQueue(IInputSink& sink, size_t capacity)
+    : m_sink(&sink)
+    , m_buffer(std::max<size_t>(capacity, 1))
+{
+}
+
+void InputQueue::AppendKeySequence(std::span<const WORD> vks, bool down)
+{
+    const size_t n = vks.size();
+    for (size_t i = 0; i < n; ++i) {
+        // Press keys in order, release them in reverse order
+        AppendKey(down ? vks[i] : vks[n - 1 - i], down);
+    }
+}
+
+void InputQueue::AppendKey(WORD vk, bool down)
+{
+    if (vk == 0) return;
+    
+    if (m_keyState && !m_keyState->Apply(vk, down)) {
+        m_suppressedEvents++; // Another source holds it, or nobody did
+        return;
+    }
+    QueueKey(vk, down);
+}
+
+void InputQueue::AppendKeyRepeat(std::span<const WORD> vks)
+{
+    for (WORD vk : vks) {
+        if (vk != 0 && (!m_keyState || m_keyState->IsDown(vk))) {
+            QueueKey(vk, true);
+        }
+    }
+}
+
+void InputQueue::QueueKey(WORD vk, bool down)
+{
+    if (m_count == m_buffer.size()) {
+        // Out of room: send what we have so ordering is preserved
+        Flush();
+    }
+    
+    INPUT& ip = m_buffer[m_count++];
+    ip = INPUT{};
+    ip.type = INPUT_KEYBOARD;
+    ip.ki.wVk = vk;
+    ip.ki.dwFlags = down ? 0 : KEYEVENTF_KEYUP;
+}
+
+void InputQueue::AppendEvents(std::span<const INPUT> events)
+{
+    for (const INPUT& event : events) {
+        if (m_keyState && event.type == INPUT_KEYBOARD &&
+            !m_keyState->Apply(event.ki.wVk, (event.ki.dwFlags & KEYEVENTF_KEYUP) == 0)) {
+            m_suppressedEvents++;
+            continue;
+        }
+        if (m_count == m_buffer.size()) {
+            Flush();
+        }
+        m_buffer[m_count++] = event;
+    }
+}
+
+void InputQueue::RecordFlush(UINT requested, UINT sent)
+{
+    if (sent != requested) {
+        // Typically UIPI blocking injection into an elevated foreground window
+        LOG_WARN("SendInput injected {}/{} events. Error: {}", sent, requested, GetLastError());
+    }
+    
+    m_lastFlushEvents = sent;
+    m_maxFlushEvents = (std::max)(m_maxFlushEvents, sent);
+    m_flushCount++;
+    m_totalEvents += sent;
+}
+
+void InputQueue::ResetStatistics()
+{
+    m_lastFlushEvents = 0;
+    m_maxFlushEvents = 0;
+    m_flushCount = 0;
+    m_totalEvents = 0;
+    m_suppressedEvents = 0;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <windows.h>
+#include <vector>
+#include <span>
+#include <cstdint>
+#include <concepts>
+#include <mutex>
+#include "InputSink.h"
+
+class KeyStateTable;
+
+/**
+ * @brief Per-frame keyboard injection queue
+ *
+ * InputProcessor instances append key transitions here instead of calling
+ * SendInput themselves; GamepadManager flushes everything queued during a
+ * frame with a single call into the sink. The buffer is allocated once at
+ * construction and never grows; if it fills up mid-frame it is flushed early
+ * into the same sink, which keeps the down/up ordering intact.
+ *
+ * With a KeyStateTable attached (GamepadManager's frame queue), every
+ * appended transition is arbitrated through it first, so a key shared by
+ * several sources is only pressed once and released by its last holder.
+ */
+class InputQueue {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+
+    explicit InputQueue(size_t capacity = DEFAULT_CAPACITY);
+    InputQueue(IInputSink& sink, size_t capacity = DEFAULT_CAPACITY);
+    
+    void SetSink(IInputSink& sink) { m_sink = &sink; }
+    IInputSink& GetSink() const { return *m_sink; }
+    
+    // Shared per-VK refcounts; nullptr queues every transition as is
+    void SetKeyState(KeyStateTable* keyState) { m_keyState = keyState; }
+
+    // Queueing (keys pressed in order, released in reverse order)
+    void AppendKeySequence(std::span<const WORD> vks, bool down);
+    void AppendKey(WORD vk, bool down);
+    // Typematic key-down for keys a source already holds; dropped for keys that are not down
+    void AppendKeyRepeat(std::span<const WORD> vks);
+    // Appends already-built events (merging another queue's output), keeping their order
+    void AppendEvents(std::span<const INPUT> events);
+    std::span<const INPUT> GetPending() const { return { m_buffer.data(), m_count }; }
+
+    // Sends everything queued to the sink in one batch; returns the number of events accepted
+    UINT Flush() { return FlushTo(*m_sink); }
+    
+    // Statically dispatched flush for the production path; pass the queue's own sink
+    template<std::derived_from<IInputSink> Sink>
+    UINT FlushTo(Sink& sink) {
+        if (m_count == 0) {
+            return 0;
+        }
+        const UINT requested = static_cast<UINT>(m_count);
+        const UINT sent = sink.Send(std::span<const INPUT>(m_buffer.data(), m_count));
+        m_count = 0;
+        RecordFlush(requested, sent);
+        return sent;
+    }
+    
+    // Drops everything queued without injecting it (benchmarks, shutdown)
+    void Clear() { m_count = 0; }
+
+    bool IsEmpty() const { return m_count == 0; }
+    size_t GetPendingCount() const { return m_count; }
+    size_t GetCapacity() const { return m_buffer.size(); }
+
+    // Diagnostics
+    UINT GetLastFlushEventCount() const { return m_lastFlushEvents; }
+    UINT GetMaxFlushEventCount() const { return m_maxFlushEvents; }
+    uint64_t GetFlushCount() const { return m_flushCount; }
+    uint64_t GetTotalEventCount() const { return m_totalEvents; }
+    uint64_t GetSuppressedEventCount() const { return m_suppressedEvents; } // Absorbed by the key state table
+    void ResetStatistics();
+
+private:
+    void QueueKey(WORD vk, bool down);
+    void RecordFlush(UINT requested, UINT sent);
+    
+    IInputSink* m_sink;
+    KeyStateTable* m_keyState = nullptr;
+    std::vector<INPUT> m_buffer; // Fixed capacity, sized once
+    size_t m_count = 0;
+
+    // Statistics (only flushes that actually sent something are counted)
+    UINT m_lastFlushEvents = 0;
+    UINT m_maxFlushEvents = 0;
+    uint64_t m_flushCount = 0;
+    uint64_t m_totalEvents = 0;
+    uint64_t m_suppressedEvents = 0;
+};
+
+/**
+ * @brief Overflow sink of the parallel per-device queues
+ *
+ * A private queue that fills up within one frame moves its events into the
+ * shared frame queue, under a lock (several workers may overflow at once),
+ * so they are still arbitrated by its key state instead of reaching
+ * SendInput around it. Each device's events keep their order.
+ */
+class SharedQueueSink final : public IInputSink {
+public:
+    explicit SharedQueueSink(InputQueue& target) : m_target(target) {}
+
+    UINT Send(std::span<const INPUT> inputs) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_target.AppendEvents(inputs);
+        return static_cast<UINT>(inputs.size());
+    }
+
+private:
+    InputQueue& m_target;
+    std::mutex m_mutex;
+};
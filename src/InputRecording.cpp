@@ -0,0 +1,395 @@
+#include "InputRecording.h"
+#include "Constants.h"
+#include "LatencyStats.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+#include <system_error>
+
+using namespace InputRecording;
+
+namespace {
+
+// Longest encoded record: timestamp varint, count, every word changed by a 5-byte varint
+constexpr size_t MAX_RECORD_BYTES = 10 + 1 + STATE_WORDS * (1 + 5);
+
+constexpr uint32_t ZERO_STATE[STATE_WORDS] = {};
+
+void PutVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ZigZag(int32_t value)
+{
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t UnZigZag(uint32_t value)
+{
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+} // namespace
+
+// =====================================
+// InputRecorder
+// =====================================
+
+InputRecorder::~InputRecorder()
+{
+    Close();
+}
+
+bool InputRecorder::Open(const std::wstring& path, const std::wstring& deviceName, const GUID& deviceGuid)
+{
+    if (IsOpen()) {
+        return true;
+    }
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR_W(L"Failed to create recording: " + path + L". Error: " + std::to_wstring(GetLastError()));
+        return false;
+    }
+    m_file.reset(file);
+
+    FileHeader header;
+    header.qpcFrequency = Qpc::Frequency();
+    header.deviceGuid = deviceGuid;
+    deviceName.copy(header.deviceName, DEVICE_NAME_CHARS - 1);
+    DWORD written = 0;
+    if (!WriteFile(m_file.get(), &header, sizeof(header), &written, nullptr) || written != sizeof(header)) {
+        LOG_ERROR_W(L"Failed to write recording header: " + path + L". Error: " + std::to_wstring(GetLastError()));
+        m_file.reset();
+        return false;
+    }
+
+    m_path = path;
+    m_chunk.clear();
+    m_chunk.reserve(AppConstants::RECORDING_CHUNK_BYTES + MAX_RECORD_BYTES);
+    m_chunkRecords = 0;
+    m_hasPrevious = false;
+    m_recordCount = 0;
+    m_maxChunkAge = static_cast<int64_t>(AppConstants::RECORDING_CHUNK_MAX_AGE_MS) * header.qpcFrequency / 1000;
+    m_stopping = false;
+
+    try {
+        m_writer = std::thread(&InputRecorder::WriterMain, this);
+    } catch (const std::system_error& e) {
+        LOG_ERROR("Failed to start recording writer thread: {}", e.what());
+        m_file.reset();
+        return false;
+    }
+
+    LOG_INFO_W(L"Recording input to: " + m_path);
+    return true;
+}
+
+void InputRecorder::Close()
+{
+    if (!IsOpen()) {
+        return;
+    }
+
+    SealChunk();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_chunkReady.notify_one();
+    m_writer.join();
+
+    m_file.reset();
+    m_sealed.clear();
+    m_spare.clear();
+    LOG_INFO_W(L"Recording closed: " + m_path + L" (" + std::to_wstring(m_recordCount) + L" states)");
+}
+
+void InputRecorder::Record(int64_t timestamp, const DIJOYSTATE2& state)
+{
+    if (!m_file) {
+        return;
+    }
+
+    uint32_t words[STATE_WORDS];
+    std::memcpy(words, &state, sizeof(words));
+    if (m_hasPrevious && std::memcmp(words, m_previous, sizeof(words)) == 0) {
+        return;
+    }
+
+    if (m_chunkRecords == 0) {
+        BeginChunk(timestamp);
+    }
+    const uint32_t* reference = m_chunkRecords == 0 ? ZERO_STATE : m_previous;
+
+    // Capacity was reserved for a full chunk plus one worst-case record, so this never reallocates
+    PutVarint(m_chunk, static_cast<uint64_t>((std::max)(timestamp - m_lastTimestamp, int64_t{ 0 })));
+    const size_t countOffset = m_chunk.size();
+    m_chunk.push_back(0);
+    uint8_t changed = 0;
+    for (size_t i = 0; i < STATE_WORDS; ++i) {
+        if (words[i] != reference[i]) {
+            m_chunk.push_back(static_cast<uint8_t>(i));
+            PutVarint(m_chunk, ZigZag(static_cast<int32_t>(words[i] - reference[i])));
+            ++changed;
+        }
+    }
+    m_chunk[countOffset] = changed;
+
+    std::memcpy(m_previous, words, sizeof(words));
+    m_hasPrevious = true;
+    m_lastTimestamp = timestamp;
+    ++m_chunkRecords;
+    ++m_recordCount;
+
+    if (m_chunk.size() >= AppConstants::RECORDING_CHUNK_BYTES || timestamp - m_chunkStart >= m_maxChunkAge) {
+        SealChunk();
+    }
+}
+
+void InputRecorder::Tick(int64_t now)
+{
+    if (m_chunkRecords > 0 && now - m_chunkStart >= m_maxChunkAge) {
+        SealChunk();
+    }
+}
+
+void InputRecorder::BeginChunk(int64_t timestamp)
+{
+    m_chunk.assign(sizeof(ChunkHeader), 0);
+    m_chunkStart = timestamp;
+    m_lastTimestamp = timestamp;
+}
+
+void InputRecorder::SealChunk()
+{
+    if (m_chunkRecords == 0) {
+        return;
+    }
+
+    ChunkHeader header;
+    header.payloadBytes = static_cast<uint32_t>(m_chunk.size() - sizeof(ChunkHeader));
+    header.recordCount = m_chunkRecords;
+    header.baseTimestamp = m_chunkStart;
+    std::memcpy(m_chunk.data(), &header, sizeof(header));
+    m_chunkRecords = 0;
+
+    std::vector<uint8_t> next;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sealed.push_back(std::move(m_chunk));
+        if (!m_spare.empty()) {
+            next = std::move(m_spare.back());
+            m_spare.pop_back();
+        }
+    }
+    m_chunkReady.notify_one();
+
+    // Only the first few chunks allocate; after that the writer hands buffers back
+    next.clear();
+    next.reserve(AppConstants::RECORDING_CHUNK_BYTES + MAX_RECORD_BYTES);
+    m_chunk = std::move(next);
+}
+
+void InputRecorder::WriterMain()
+{
+    std::vector<std::vector<uint8_t>> batch;
+    bool failed = false;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_chunkReady.wait(lock, [this] { return m_stopping || !m_sealed.empty(); });
+            if (m_sealed.empty()) {
+                break; // Stopping, everything written
+            }
+            batch.swap(m_sealed);
+        }
+
+        for (const std::vector<uint8_t>& chunk : batch) {
+            DWORD written = 0;
+            if (!failed && (!WriteFile(m_file.get(), chunk.data(), static_cast<DWORD>(chunk.size()), &written, nullptr) ||
+                            written != chunk.size())) {
+                // Later chunks would follow a gap; the file ends at the last complete chunk
+                LOG_ERROR_W(L"Recording write failed, stopping: " + m_path + L". Error: " + std::to_wstring(GetLastError()));
+                failed = true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (std::vector<uint8_t>& chunk : batch) {
+            m_spare.push_back(std::move(chunk));
+        }
+        batch.clear();
+    }
+}
+
+// =====================================
+// RecordingReader
+// =====================================
+
+RecordingReader::~RecordingReader()
+{
+    Close();
+}
+
+bool RecordingReader::Open(const std::wstring& path)
+{
+    Close();
+
+    // The recording may still be open for writing by another instance
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR_W(L"Failed to open recording: " + path + L". Error: " + std::to_wstring(GetLastError()));
+        return false;
+    }
+    m_file.reset(file);
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(m_file.get(), &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+        LOG_ERROR_W(L"Not a recording (too short): " + path);
+        Close();
+        return false;
+    }
+
+    m_mapping.reset(CreateFileMappingW(m_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+    if (m_mapping) {
+        m_view = static_cast<const uint8_t*>(MapViewOfFile(m_mapping.get(), FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!m_view) {
+        LOG_ERROR_W(L"Failed to map recording: " + path + L". Error: " + std::to_wstring(GetLastError()));
+        Close();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    std::memcpy(&m_header, m_view, sizeof(m_header));
+    if (m_header.magic != FILE_MAGIC || m_header.version != VERSION || m_header.headerBytes < sizeof(FileHeader) ||
+        m_header.headerBytes > m_size || m_header.qpcFrequency <= 0) {
+        LOG_ERROR_W(L"Not a recording (bad header): " + path);
+        Close();
+        return false;
+    }
+    m_header.deviceName[DEVICE_NAME_CHARS - 1] = L'\0';
+
+    // Timestamps count from the first chunk's base
+    m_firstTimestamp = 0;
+    if (m_header.headerBytes + sizeof(ChunkHeader) <= m_size) {
+        ChunkHeader first;
+        std::memcpy(&first, m_view + m_header.headerBytes, sizeof(first));
+        m_firstTimestamp = first.baseTimestamp;
+    }
+
+    Rewind();
+    return true;
+}
+
+void RecordingReader::Close()
+{
+    if (m_view) {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    m_mapping.reset();
+    m_file.reset();
+    m_size = 0;
+    m_cursor = m_chunkEnd = nullptr;
+    m_recordsLeft = 0;
+}
+
+void RecordingReader::Rewind()
+{
+    m_chunkOffset = m_header.headerBytes;
+    m_cursor = m_chunkEnd = nullptr;
+    m_recordsLeft = 0;
+    m_timestamp = m_firstTimestamp;
+    m_state = DIJOYSTATE2{};
+}
+
+bool RecordingReader::EnterChunk()
+{
+    if (!m_view || m_chunkOffset + sizeof(ChunkHeader) > m_size) {
+        return false;
+    }
+
+    ChunkHeader header;
+    std::memcpy(&header, m_view + m_chunkOffset, sizeof(header));
+    const size_t payloadStart = m_chunkOffset + sizeof(ChunkHeader);
+    if (header.magic != CHUNK_MAGIC || header.payloadBytes > m_size - payloadStart) {
+        return Stop(); // Torn by a crash, or not ours
+    }
+
+    m_cursor = m_view + payloadStart;
+    m_chunkEnd = m_cursor + header.payloadBytes;
+    m_recordsLeft = header.recordCount;
+    m_timestamp = header.baseTimestamp;
+    m_chunkOffset = payloadStart + header.payloadBytes;
+
+    // Chunks start from the zero state
+    m_state = DIJOYSTATE2{};
+    return true;
+}
+
+bool RecordingReader::Next()
+{
+    while (m_recordsLeft == 0) {
+        if (!EnterChunk()) {
+            return false;
+        }
+    }
+
+    uint64_t delta = 0;
+    if (!ReadVarint(delta) || m_cursor >= m_chunkEnd) {
+        return Stop();
+    }
+    m_timestamp += static_cast<int64_t>(delta);
+
+    uint8_t* words = reinterpret_cast<uint8_t*>(&m_state);
+    const uint8_t changed = *m_cursor++;
+    for (uint8_t i = 0; i < changed; ++i) {
+        uint64_t encoded = 0;
+        if (m_cursor >= m_chunkEnd) {
+            return Stop();
+        }
+        const uint8_t index = *m_cursor++;
+        if (index >= STATE_WORDS || !ReadVarint(encoded)) {
+            return Stop();
+        }
+
+        uint32_t word;
+        std::memcpy(&word, words + index * sizeof(uint32_t), sizeof(word));
+        word += static_cast<uint32_t>(UnZigZag(static_cast<uint32_t>(encoded)));
+        std::memcpy(words + index * sizeof(uint32_t), &word, sizeof(word));
+    }
+
+    --m_recordsLeft;
+    return true;
+}
+
+bool RecordingReader::ReadVarint(uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && m_cursor < m_chunkEnd; shift += 7) {
+        const uint8_t byte = *m_cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RecordingReader::Stop()
+{
+    LOG_WARN("Recording ends in a corrupt or incomplete chunk; replay stops there.");
+    m_recordsLeft = 0;
+    m_chunkOffset = m_size;
+    return false;
+}
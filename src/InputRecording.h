@@ -0,0 +1,156 @@
+#pragma once
+#include <windows.h>
+#include <dinput.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Win32Handle.h"
+
+/**
+ * @brief On-disk layout of an input recording (.gmrec)
+ *
+ * A file header followed by self-contained chunks. Each chunk is a header
+ * and a run of records; a record is
+ *
+ *     varint   QPC ticks since the previous record (the chunk's base for the first)
+ *     uint8    number of changed 32-bit words of DIJOYSTATE2
+ *     n x      uint8 word index, varint zigzag(new - old)
+ *
+ * The first record of a chunk is a delta against the all-zero state, so any
+ * chunk decodes on its own. The file is append-only: a chunk torn by a crash
+ * (payload running past the end of the file) is simply where replay stops.
+ */
+namespace InputRecording {
+    constexpr uint32_t FILE_MAGIC = 0x43524D47;  // "GMRC"
+    constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t STATE_WORDS = sizeof(DIJOYSTATE2) / sizeof(uint32_t);
+    constexpr size_t DEVICE_NAME_CHARS = 64;
+
+    struct FileHeader {
+        uint32_t magic = FILE_MAGIC;
+        uint16_t version = VERSION;
+        uint16_t headerBytes = sizeof(FileHeader);
+        int64_t qpcFrequency = 0;
+        GUID deviceGuid{};
+        wchar_t deviceName[DEVICE_NAME_CHARS]{}; // Null-terminated, truncated
+    };
+
+    struct ChunkHeader {
+        uint32_t magic = CHUNK_MAGIC;
+        uint32_t payloadBytes = 0;
+        uint32_t recordCount = 0;
+        uint32_t reserved = 0;
+        int64_t baseTimestamp = 0; // QPC ticks
+    };
+}
+
+/**
+ * @brief Records the states a device maps into a chunked .gmrec file
+ *
+ * Record() runs on the thread that processes the device: it delta-encodes
+ * into the open chunk and never touches the file. Sealed chunks (full, or
+ * older than RECORDING_CHUNK_MAX_AGE_MS, also checked every frame by Tick())
+ * go to a background writer thread; chunk buffers are recycled, so recording
+ * does not allocate once warm.
+ */
+class InputRecorder {
+public:
+    InputRecorder() = default;
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    bool Open(const std::wstring& path, const std::wstring& deviceName, const GUID& deviceGuid);
+    // Writes the open chunk and waits for the writer to finish
+    void Close();
+    bool IsOpen() const { return m_writer.joinable(); }
+
+    // States equal to the previous one are skipped
+    void Record(int64_t timestamp, const DIJOYSTATE2& state);
+    // Once per frame, changed or not: seals an open chunk that has reached its maximum age,
+    // so the last transitions before an idle period reach the file too
+    void Tick(int64_t now);
+
+    uint64_t GetRecordCount() const { return m_recordCount; }
+
+private:
+    void BeginChunk(int64_t timestamp);
+    void SealChunk();
+    void WriterMain();
+
+    UniqueHandle m_file;
+    std::wstring m_path;
+
+    // Open chunk (recording thread only)
+    std::vector<uint8_t> m_chunk;
+    uint32_t m_previous[InputRecording::STATE_WORDS]{}; // Last recorded state
+    bool m_hasPrevious = false;
+    int64_t m_chunkStart = 0;
+    int64_t m_lastTimestamp = 0;
+    int64_t m_maxChunkAge = 0; // QPC ticks
+    uint32_t m_chunkRecords = 0;
+    uint64_t m_recordCount = 0;
+
+    // Writer handoff
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_chunkReady;
+    std::vector<std::vector<uint8_t>> m_sealed;
+    std::vector<std::vector<uint8_t>> m_spare;
+    bool m_stopping = false;
+};
+
+/**
+ * @brief Memory-mapped sequential reader for .gmrec files
+ *
+ * Decodes one state per Next() in place (no copies of the mapped data and
+ * no allocation), so it can feed a device or a benchmark loop directly.
+ */
+class RecordingReader {
+public:
+    RecordingReader() = default;
+    ~RecordingReader();
+
+    RecordingReader(const RecordingReader&) = delete;
+    RecordingReader& operator=(const RecordingReader&) = delete;
+
+    bool Open(const std::wstring& path);
+    void Close();
+    bool IsOpen() const { return m_view != nullptr; }
+
+    const InputRecording::FileHeader& GetHeader() const { return m_header; }
+
+    // Advances to the next recorded state; false at the end of the recording
+    bool Next();
+    // Back to before the first state
+    void Rewind();
+
+    const DIJOYSTATE2& GetState() const { return m_state; }
+    int64_t GetTimestamp() const { return m_timestamp; } // QPC ticks of the recording machine
+    int64_t GetFirstTimestamp() const { return m_firstTimestamp; }
+
+private:
+    bool EnterChunk();
+    bool ReadVarint(uint64_t& value);
+    bool Stop(); // Corrupt or torn data: ends the recording here
+
+    UniqueHandle m_file;
+    UniqueHandle m_mapping;
+    const uint8_t* m_view = nullptr;
+    size_t m_size = 0;
+    InputRecording::FileHeader m_header{};
+
+    // Cursor
+    size_t m_chunkOffset = 0;  // Next chunk header
+    const uint8_t* m_cursor = nullptr;
+    const uint8_t* m_chunkEnd = nullptr;
+    uint32_t m_recordsLeft = 0;
+    int64_t m_firstTimestamp = 0;
+    int64_t m_timestamp = 0;
+    DIJOYSTATE2 m_state{};
+};
@@ -0,0 +1,49 @@
+#include "InputSink.h"
+#include <algorithm>
+
+SendInputSink& SendInputSink::Default()
+{
+    static SendInputSink sink;
+    return sink;
+}
+
+UINT RecordingInputSink::Send(std::span<const INPUT> inputs)
+{
+    m_events.insert(m_events.end(), inputs.begin(), inputs.end());
+    return static_cast<UINT>(inputs.size());
+}
+
+RingBufferInputSink::RingBufferInputSink(size_t capacity)
+    : m_buffer(std::max<size_t>(capacity, 1))
+{
+}
+
+UINT RingBufferInputSink::Send(std::span<const INPUT> inputs)
+{
+    for (const INPUT& input : inputs) {
+        m_buffer[m_head] = input;
+        m_head = (m_head + 1) % m_buffer.size();
+        if (m_size < m_buffer.size()) {
+            m_size++;
+        }
+    }
+    m_totalEvents += inputs.size();
+    return static_cast<UINT>(inputs.size());
+}
+
+void RingBufferInputSink::CopyEvents(std::vector<INPUT>& out) const
+{
+    out.clear();
+    out.reserve(m_size);
+    const size_t start = (m_head + m_buffer.size() - m_size) % m_buffer.size();
+    for (size_t i = 0; i < m_size; ++i) {
+        out.push_back(m_buffer[(start + i) % m_buffer.size()]);
+    }
+}
+
+void RingBufferInputSink::Clear()
+{
+    m_head = 0;
+    m_size = 0;
+    m_totalEvents = 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <windows.h>
+#include <span>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @brief Destination for injected keyboard events
+ *
+ * InputQueue hands each flushed batch to a sink. The production path uses
+ * SendInputSink through InputQueue::FlushTo<SendInputSink>, so the call is
+ * resolved at compile time; the other sinks let the mapping pipeline run in
+ * benchmarks and replays without typing into the desktop.
+ */
+class IInputSink {
+public:
+    virtual ~IInputSink() = default;
+
+    // Returns the number of events accepted
+    virtual UINT Send(std::span<const INPUT> inputs) = 0;
+};
+
+// Injects into the OS input stream
+class SendInputSink final : public IInputSink {
+public:
+    UINT Send(std::span<const INPUT> inputs) override {
+        if (inputs.empty()) return 0;
+        return ::SendInput(static_cast<UINT>(inputs.size()), const_cast<INPUT*>(inputs.data()), sizeof(INPUT));
+    }
+
+    // Shared instance for queues that were not given a sink
+    static SendInputSink& Default();
+};
+
+// Accepts and discards everything (benchmarks)
+class NullInputSink final : public IInputSink {
+public:
+    UINT Send(std::span<const INPUT> inputs) override {
+        m_eventCount += inputs.size();
+        return static_cast<UINT>(inputs.size());
+    }
+
+    uint64_t GetEventCount() const { return m_eventCount; }
+    void Reset() { m_eventCount = 0; }
+
+private:
+    uint64_t m_eventCount = 0;
+};
+
+// Keeps every event in order (replays, debugging stuck keys)
+class RecordingInputSink final : public IInputSink {
+public:
+    UINT Send(std::span<const INPUT> inputs) override;
+
+    const std::vector<INPUT>& GetEvents() const { return m_events; }
+    void Clear() { m_events.clear(); }
+
+private:
+    std::vector<INPUT> m_events;
+};
+
+// Keeps only the most recent events in a fixed buffer allocated once
+class RingBufferInputSink final : public IInputSink {
+public:
+    explicit RingBufferInputSink(size_t capacity = 1024);
+
+    UINT Send(std::span<const INPUT> inputs) override;
+
+    // Copies retained events, oldest first
+    void CopyEvents(std::vector<INPUT>& out) const;
+    size_t GetSize() const { return m_size; }
+    uint64_t GetTotalEventCount() const { return m_totalEvents; }
+    void Clear();
+
+private:
+    std::vector<INPUT> m_buffer;
+    size_t m_head = 0; // Next write position
+    size_t m_size = 0;
+    uint64_t m_totalEvents = 0;
+};
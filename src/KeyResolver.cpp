@@ -1,30 +1,211 @@
 #include "KeyResolver.h"
 #include <windows.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
-#include <unordered_map>
-#include <algorithm> // For std::transform
-#include <cctype>    // For std::tolower
-#include <stdexcept> // For std::invalid_argument, std::out_of_range
-
-// Initialize static KEY_MAP by calling createKeyMap()
-const std::unordered_map<std::string, WORD> KeyResolver::KEY_MAP = KeyResolver::createKeyMap();
-
-std::optional<WORD> KeyResolver::resolve(const std::string& keyName) {
-    std::string lowerKeyName = keyName;
-    std::transform(lowerKeyName.begin(), lowerKeyName.end(), lowerKeyName.begin(),
-                   [](unsigned char c){ return std::tolower(c); });
-
-    auto it = KEY_MAP.find(lowerKeyName);
-    if (it != KEY_MAP.end()) {
-        return it->second;
+
+namespace {
+
+struct KeyEntry {
+    std::string_view name; // Lowercase
+    WORD vk;
+};
+
+// Named keys other than the single letters and digits (added below).
+// Names must be lowercase; the table is sorted at compile time.
+constexpr KeyEntry NAMED_KEYS[] = {
+    // Editing / navigation
+    { "space", VK_SPACE },
+    { "enter", VK_RETURN },
+    { "return", VK_RETURN },
+    { "escape", VK_ESCAPE },
+    { "esc", VK_ESCAPE },
+    { "tab", VK_TAB },
+    { "backspace", VK_BACK },
+    { "delete", VK_DELETE },
+    { "del", VK_DELETE },
+    { "insert", VK_INSERT },
+    { "ins", VK_INSERT },
+    { "home", VK_HOME },
+    { "end", VK_END },
+    { "pageup", VK_PRIOR },
+    { "pgup", VK_PRIOR },
+    { "pagedown", VK_NEXT },
+    { "pgdn", VK_NEXT },
+    { "up", VK_UP },
+    { "down", VK_DOWN },
+    { "left", VK_LEFT },
+    { "right", VK_RIGHT },
+    { "clear", VK_CLEAR },
+    { "select", VK_SELECT },
+    { "execute", VK_EXECUTE },
+    { "help", VK_HELP },
+
+    // Locks / system
+    { "capslock", VK_CAPITAL },
+    { "numlock", VK_NUMLOCK },
+    { "scrolllock", VK_SCROLL },
+    { "pause", VK_PAUSE },
+    { "printscreen", VK_SNAPSHOT },
+    { "prtsc", VK_SNAPSHOT },
+    { "apps", VK_APPS },
+    { "menu", VK_APPS },
+    { "sleep", VK_SLEEP },
+
+    // Modifiers
+    { "ctrl", VK_CONTROL },
+    { "control", VK_CONTROL },
+    { "lctrl", VK_LCONTROL },
+    { "rctrl", VK_RCONTROL },
+    { "alt", VK_MENU },
+    { "lalt", VK_LMENU },
+    { "ralt", VK_RMENU },
+    { "shift", VK_SHIFT },
+    { "lshift", VK_LSHIFT },
+    { "rshift", VK_RSHIFT },
+    { "win", VK_LWIN },
+    { "lwin", VK_LWIN },
+    { "rwin", VK_RWIN },
+
+    // Function keys
+    { "f1", VK_F1 }, { "f2", VK_F2 }, { "f3", VK_F3 }, { "f4", VK_F4 },
+    { "f5", VK_F5 }, { "f6", VK_F6 }, { "f7", VK_F7 }, { "f8", VK_F8 },
+    { "f9", VK_F9 }, { "f10", VK_F10 }, { "f11", VK_F11 }, { "f12", VK_F12 },
+    { "f13", VK_F13 }, { "f14", VK_F14 }, { "f15", VK_F15 }, { "f16", VK_F16 },
+    { "f17", VK_F17 }, { "f18", VK_F18 }, { "f19", VK_F19 }, { "f20", VK_F20 },
+    { "f21", VK_F21 }, { "f22", VK_F22 }, { "f23", VK_F23 }, { "f24", VK_F24 },
+
+    // Numpad
+    { "numpad0", VK_NUMPAD0 }, { "numpad1", VK_NUMPAD1 }, { "numpad2", VK_NUMPAD2 },
+    { "numpad3", VK_NUMPAD3 }, { "numpad4", VK_NUMPAD4 }, { "numpad5", VK_NUMPAD5 },
+    { "numpad6", VK_NUMPAD6 }, { "numpad7", VK_NUMPAD7 }, { "numpad8", VK_NUMPAD8 },
+    { "numpad9", VK_NUMPAD9 },
+    { "multiply", VK_MULTIPLY },
+    { "add", VK_ADD },
+    { "separator", VK_SEPARATOR },
+    { "subtract", VK_SUBTRACT },
+    { "decimal", VK_DECIMAL },
+    { "divide", VK_DIVIDE },
+
+    // Media / browser / launch
+    { "volumemute", VK_VOLUME_MUTE },
+    { "volumedown", VK_VOLUME_DOWN },
+    { "volumeup", VK_VOLUME_UP },
+    { "medianext", VK_MEDIA_NEXT_TRACK },
+    { "mediaprev", VK_MEDIA_PREV_TRACK },
+    { "mediastop", VK_MEDIA_STOP },
+    { "mediaplaypause", VK_MEDIA_PLAY_PAUSE },
+    { "browserback", VK_BROWSER_BACK },
+    { "browserforward", VK_BROWSER_FORWARD },
+    { "browserrefresh", VK_BROWSER_REFRESH },
+    { "browserstop", VK_BROWSER_STOP },
+    { "browsersearch", VK_BROWSER_SEARCH },
+    { "browserfavorites", VK_BROWSER_FAVORITES },
+    { "browserhome", VK_BROWSER_HOME },
+    { "launchmail", VK_LAUNCH_MAIL },
+    { "launchmedia", VK_LAUNCH_MEDIA_SELECT },
+    { "launchapp1", VK_LAUNCH_APP1 },
+    { "launchapp2", VK_LAUNCH_APP2 },
+
+    // OEM (US layout names)
+    { "semicolon", VK_OEM_1 },
+    { "plus", VK_OEM_PLUS },
+    { "equals", VK_OEM_PLUS },
+    { "comma", VK_OEM_COMMA },
+    { "minus", VK_OEM_MINUS },
+    { "period", VK_OEM_PERIOD },
+    { "slash", VK_OEM_2 },
+    { "backquote", VK_OEM_3 },
+    { "grave", VK_OEM_3 },
+    { "lbracket", VK_OEM_4 },
+    { "backslash", VK_OEM_5 },
+    { "rbracket", VK_OEM_6 },
+    { "quote", VK_OEM_7 },
+    { "oem8", VK_OEM_8 },
+    { "oem102", VK_OEM_102 },
+
+    // IME (Japanese keyboards)
+    { "kana", VK_KANA },
+    { "kanji", VK_KANJI },
+    { "convert", VK_CONVERT },
+    { "nonconvert", VK_NONCONVERT },
+};
+
+constexpr char LETTERS[] = "abcdefghijklmnopqrstuvwxyz";
+constexpr char DIGITS[] = "0123456789";
+
+// Letters and digits map to their uppercase ASCII code
+constexpr auto KEY_TABLE = [] {
+    std::array<KeyEntry, std::size(NAMED_KEYS) + 26 + 10> table{};
+    size_t n = 0;
+    for (size_t i = 0; i < 26; ++i) {
+        table[n++] = { std::string_view(LETTERS + i, 1), static_cast<WORD>('A' + i) };
+    }
+    for (size_t i = 0; i < 10; ++i) {
+        table[n++] = { std::string_view(DIGITS + i, 1), static_cast<WORD>('0' + i) };
+    }
+    for (const auto& entry : NAMED_KEYS) {
+        table[n++] = entry;
+    }
+    std::sort(table.begin(), table.end(), [](const KeyEntry& a, const KeyEntry& b) { return a.name < b.name; });
+    return table;
+}();
+
+static_assert(std::adjacent_find(KEY_TABLE.begin(), KEY_TABLE.end(),
+                                 [](const KeyEntry& a, const KeyEntry& b) { return a.name == b.name; }) == KEY_TABLE.end(),
+              "duplicate key name");
+static_assert(std::all_of(KEY_TABLE.begin(), KEY_TABLE.end(), [](const KeyEntry& e) {
+                  return std::none_of(e.name.begin(), e.name.end(), [](char c) { return c >= 'A' && c <= 'Z'; });
+              }),
+              "key names must be lowercase");
+
+constexpr char ToLowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// Compares a (lowercase) table name with user input, folding the input's case on the fly
+constexpr int CompareIgnoreCase(std::string_view lowerName, std::string_view key) {
+    const size_t common = (std::min)(lowerName.size(), key.size());
+    for (size_t i = 0; i < common; ++i) {
+        const unsigned char a = static_cast<unsigned char>(lowerName[i]);
+        const unsigned char b = static_cast<unsigned char>(ToLowerAscii(key[i]));
+        if (a != b) {
+            return a < b ? -1 : 1;
+        }
+    }
+    if (lowerName.size() == key.size()) {
+        return 0;
+    }
+    return lowerName.size() < key.size() ? -1 : 1;
+}
+
+constexpr const KeyEntry* FindKey(std::string_view keyName) {
+    auto it = std::lower_bound(KEY_TABLE.begin(), KEY_TABLE.end(), keyName,
+                               [](const KeyEntry& entry, std::string_view key) { return CompareIgnoreCase(entry.name, key) < 0; });
+    return (it != KEY_TABLE.end() && CompareIgnoreCase(it->name, keyName) == 0) ? &*it : nullptr;
+}
+
+static_assert(FindKey("ENTER") && FindKey("ENTER")->vk == VK_RETURN);
+static_assert(FindKey("Numpad7") && FindKey("Numpad7")->vk == VK_NUMPAD7);
+static_assert(!FindKey("f25"));
+
+} // namespace
+
+std::optional<WORD> KeyResolver::resolve(std::string_view keyName) {
+    if (const KeyEntry* entry = FindKey(keyName)) {
+        return entry->vk;
     }
     return parseNumericKey(keyName);
 }
 
 std::vector<WORD> KeyResolver::resolveSequence(const std::vector<std::string>& keys) {
     std::vector<WORD> sequence;
+    sequence.reserve(keys.size());
     for (const auto& key : keys) {
         if (auto resolvedKey = resolve(key)) {
             sequence.push_back(resolvedKey.value());
@@ -33,69 +214,18 @@ std::vector<WORD> KeyResolver::resolveSequence(const std::vector<std::string>& k
     return sequence;
 }
 
-std::optional<WORD> KeyResolver::parseNumericKey(const std::string& keyName) {
-    try {
-        size_t pos;
-        long long_val;
-        if (keyName.size() > 2 && (keyName.substr(0, 2) == "0x" || keyName.substr(0, 2) == "0X")) {
-            long_val = static_cast<long>(std::stoll(keyName, &pos, 16));
-        } else {
-            long_val = static_cast<long>(std::stoll(keyName, &pos, 10));
-        }
-
-        if (pos == keyName.size() && long_val >= 0 && long_val <= 0xFFFF) {
-            return static_cast<WORD>(long_val);
-        }
-    } catch (const std::invalid_argument&) {
-        // Not a number, which is fine
-    } catch (const std::out_of_range&) {
-        // Number is out of range for long, which is also fine
-    }
-    return std::nullopt;
-}
-
-
-std::unordered_map<std::string, WORD> KeyResolver::createKeyMap() {
-    std::unordered_map<std::string, WORD> map;
-
-    // Alphanumeric keys
-    for (char c = 'a'; c <= 'z'; ++c) {
-        map[std::string(1, c)] = toupper(c);
-    }
-    for (char c = '0'; c <= '9'; ++c) {
-        map[std::string(1, c)] = c;
+std::optional<WORD> KeyResolver::parseNumericKey(std::string_view keyName) {
+    int base = 10;
+    if (keyName.size() > 2 && keyName[0] == '0' && (keyName[1] == 'x' || keyName[1] == 'X')) {
+        keyName.remove_prefix(2);
+        base = 16;
     }
 
-    // Special keys
-    map["space"] = VK_SPACE;
-    map["enter"] = VK_RETURN;
-    map["escape"] = VK_ESCAPE;
-    map["tab"] = VK_TAB;
-    map["backspace"] = VK_BACK;
-    map["delete"] = VK_DELETE;
-
-    // Modifier keys
-    map["ctrl"] = VK_CONTROL;
-    map["alt"] = VK_MENU;
-    map["shift"] = VK_SHIFT;
-    map["win"] = VK_LWIN;
-    map["lwin"] = VK_LWIN;
-    map["rwin"] = VK_RWIN;
-
-    // Function keys
-    for (int i = 1; i <= 12; ++i) {
-        map["f" + std::to_string(i)] = VK_F1 + (i - 1);
+    unsigned long value = 0;
+    const char* end = keyName.data() + keyName.size();
+    auto [ptr, ec] = std::from_chars(keyName.data(), end, value, base);
+    if (ec == std::errc() && ptr == end && !keyName.empty() && value <= 0xFFFF) {
+        return static_cast<WORD>(value);
     }
-
-    // Arrow keys
-    map["up"] = VK_UP;
-    map["down"] = VK_DOWN;
-    map["left"] = VK_LEFT;
-    map["right"] = VK_RIGHT;
-
-    // PrintScreen
-    map["printscreen"] = VK_SNAPSHOT;
-    map["prtsc"] = VK_SNAPSHOT;
-
-    return map;
+    return std::nullopt;
 }
@@ -1,17 +1,17 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <windows.h>
-#include <unordered_map>
 
 class KeyResolver {
 public:
-    static std::optional<WORD> resolve(const std::string& keyName);
+    // Case-insensitive key name ("a", "F5", "numpad3", "volumeup", ...) or a
+    // decimal / 0x-prefixed hex virtual-key code. Never allocates or throws.
+    static std::optional<WORD> resolve(std::string_view keyName);
     static std::vector<WORD> resolveSequence(const std::vector<std::string>& keys);
 private:
-    static const std::unordered_map<std::string, WORD> KEY_MAP;
-    static std::unordered_map<std::string, WORD> createKeyMap();
-    static std::optional<WORD> parseNumericKey(const std::string& keyName);
+    static std::optional<WORD> parseNumericKey(std::string_view keyName);
 };
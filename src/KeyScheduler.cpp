@@ -0,0 +1,264 @@
+#include "KeyScheduler.h"
+#include "InputQueue.h"
+#include "LatencyStats.h"
+#include <algorithm>
+
+KeyScheduler::KeyScheduler()
+    : m_pool(POOL_SIZE)
+    , m_currentTick(ToTick(Qpc::Now()))
+{
+    m_slotHead.fill(NONE);
+    m_slotTail.fill(NONE);
+    
+    // Thread every event onto the free list
+    for (uint32_t i = 0; i < POOL_SIZE; ++i) {
+        m_pool[i].next = i + 1 < POOL_SIZE ? i + 1 : NONE;
+    }
+    m_freeHead = 0;
+}
+
+int64_t KeyScheduler::ToTick(int64_t qpc)
+{
+    return Qpc::ToMicroseconds(qpc) / 1000;
+}
+
+uint32_t KeyScheduler::AllocateEvent()
+{
+    const uint32_t index = m_freeHead;
+    if (index != NONE) {
+        m_freeHead = m_pool[index].next;
+        m_pool[index].next = NONE;
+    }
+    return index;
+}
+
+void KeyScheduler::InitEvent(uint32_t index, const void* owner, uint16_t tag, std::span<const WORD> keys, bool down,
+                             int64_t dueTick, Repeat repeat, uint32_t intervalMs)
+{
+    Event& event = m_pool[index];
+    // Never behind the wheel cursor, or it would wait a whole revolution
+    event.dueTick = (std::max)(dueTick, m_currentTick + 1);
+    event.owner = owner;
+    event.tag = tag;
+    event.repeat = intervalMs > 0 ? repeat : Repeat::None;
+    event.intervalMs = intervalMs;
+    event.release = NONE;
+    event.down = down;
+    event.owed = !down;
+    event.keyCount = static_cast<uint8_t>((std::min)(keys.size(), MAX_KEYS));
+    std::copy_n(keys.begin(), event.keyCount, event.keys.begin());
+}
+
+bool KeyScheduler::OwesRelease(const Event& event) const
+{
+    // Turbo alternates: a pending up means its last down went out. Typematic repeats never
+    // own the press (the source does). A one-shot up owes only what was really pressed.
+    switch (event.repeat) {
+    case Repeat::Toggle: return !event.down;
+    case Repeat::Press:  return false;
+    default:             return !event.down && event.owed;
+    }
+}
+
+void KeyScheduler::FreeEvent(uint32_t index)
+{
+    Event& event = m_pool[index];
+    event.owner = nullptr;
+    event.release = NONE;
+    event.next = m_freeHead;
+    m_freeHead = index;
+}
+
+void KeyScheduler::LinkEvent(uint32_t index)
+{
+    // Append at the tail so events due on the same tick fire in scheduling order
+    Event& event = m_pool[index];
+    event.next = NONE;
+    const size_t slot = static_cast<size_t>(event.dueTick) % WHEEL_SLOTS;
+    if (m_slotTail[slot] == NONE) {
+        m_slotHead[slot] = index;
+    } else {
+        m_pool[m_slotTail[slot]].next = index;
+    }
+    m_slotTail[slot] = index;
+    m_pending++;
+}
+
+bool KeyScheduler::Schedule(const void* owner, uint16_t tag, std::span<const WORD> keys, bool down,
+                            uint32_t delayMs, Repeat repeat, uint32_t intervalMs)
+{
+    if (!owner || keys.empty()) {
+        return false;
+    }
+    
+    const int64_t now = ToTick(Qpc::Now());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    const uint32_t index = AllocateEvent();
+    if (index == NONE) {
+        m_dropped++;
+        return false;
+    }
+    
+    InitEvent(index, owner, tag, keys, down, now + static_cast<int64_t>(delayMs), repeat, intervalMs);
+    LinkEvent(index);
+    return true;
+}
+
+bool KeyScheduler::SchedulePress(const void* owner, uint16_t tag, std::span<const WORD> keys,
+                                 uint32_t delayMs, uint32_t holdMs)
+{
+    if (!owner || keys.empty()) {
+        return false;
+    }
+    
+    const int64_t now = ToTick(Qpc::Now());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    const uint32_t downIndex = AllocateEvent();
+    const uint32_t upIndex = downIndex != NONE ? AllocateEvent() : NONE;
+    if (upIndex == NONE) {
+        if (downIndex != NONE) {
+            FreeEvent(downIndex);
+        }
+        m_dropped++;
+        return false;
+    }
+    
+    const int64_t downTick = now + static_cast<int64_t>(delayMs);
+    InitEvent(downIndex, owner, tag, keys, true, downTick, Repeat::None, 0);
+    // Strictly after the down, even if the down was pushed past the cursor
+    InitEvent(upIndex, owner, tag, keys, false,
+              (std::max)(downTick, m_pool[downIndex].dueTick) + (std::max<int64_t>)(holdMs, 1), Repeat::None, 0);
+    m_pool[upIndex].owed = false;
+    m_pool[downIndex].release = upIndex;
+    
+    LinkEvent(downIndex);
+    LinkEvent(upIndex);
+    return true;
+}
+
+KeyScheduler::CancelResult KeyScheduler::Cancel(const void* owner, uint32_t tag, InputQueue* releaseInto)
+{
+    CancelResult result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending == 0) {
+        return result;
+    }
+    
+    // Rare (button release, device teardown): a linear pass over the pool is fine.
+    // Free events have owner == nullptr, so only live ones can match.
+    for (Event& event : m_pool) {
+        if (event.owner == owner && (tag == ANY_TAG || event.tag == tag)) {
+            const bool owesRelease = OwesRelease(event);
+            result.cancelled++;
+            result.keysHeld = result.keysHeld || owesRelease;
+            if (owesRelease && releaseInto) {
+                releaseInto->AppendKeySequence(std::span<const WORD>(event.keys.data(), event.keyCount), false);
+            }
+            event.owner = nullptr;
+        }
+    }
+    return result;
+}
+
+void KeyScheduler::FireSlot(size_t slot, int64_t tick, int64_t now, InputQueue& queue, size_t& fired)
+{
+    // Detach the slot's list: events not yet due and re-armed repeats are linked again
+    uint32_t index = m_slotHead[slot];
+    m_slotHead[slot] = NONE;
+    m_slotTail[slot] = NONE;
+    
+    while (index != NONE) {
+        Event& event = m_pool[index];
+        const uint32_t next = event.next;
+        m_pending--;
+        
+        if (event.owner && event.dueTick > tick) {
+            LinkEvent(index); // Due on a later revolution
+        } else {
+            if (event.owner) {
+                const std::span<const WORD> keys(event.keys.data(), event.keyCount);
+                if (event.repeat == Repeat::Press) {
+                    queue.AppendKeyRepeat(keys); // The source's own press is still holding them
+                } else {
+                    queue.AppendKeySequence(keys, event.down);
+                }
+                if (event.release != NONE && m_pool[event.release].owner == event.owner) {
+                    m_pool[event.release].owed = true; // Its key-up now gives back a real press
+                }
+                fired++;
+            }
+            
+            if (event.owner && event.repeat != Repeat::None) {
+                // Skip cycles missed during a stall instead of bursting them out: the next one is
+                // due after the real time, not after the tick being caught up (only one-shot
+                // events are replayed in order)
+                event.dueTick = (std::max)(event.dueTick + static_cast<int64_t>(event.intervalMs), now + 1);
+                if (event.repeat == Repeat::Toggle) {
+                    event.down = !event.down;
+                }
+                LinkEvent(index);
+            } else {
+                FreeEvent(index);
+            }
+        }
+        index = next;
+    }
+}
+
+size_t KeyScheduler::Advance(int64_t nowQpc, InputQueue& queue)
+{
+    const int64_t now = ToTick(nowQpc);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    size_t fired = 0;
+    if (m_pending == 0) {
+        m_currentTick = (std::max)(m_currentTick, now);
+        return 0;
+    }
+    
+    // Visit every tick in order so a macro's down always precedes its up, even after a stall
+    while (m_currentTick < now) {
+        ++m_currentTick;
+        const size_t slot = static_cast<size_t>(m_currentTick) % WHEEL_SLOTS;
+        if (m_slotHead[slot] != NONE) {
+            FireSlot(slot, m_currentTick, now, queue, fired);
+        }
+        if (m_pending == 0) {
+            m_currentTick = now;
+        }
+    }
+    return fired;
+}
+
+DWORD KeyScheduler::GetNextDelayMs(int64_t nowQpc) const
+{
+    const int64_t now = ToTick(nowQpc);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending == 0) {
+        return INFINITE;
+    }
+    
+    // First occupied slot after the cursor; it may hold a later revolution's event,
+    // which only costs one early wake-up
+    for (size_t k = 1; k <= WHEEL_SLOTS; ++k) {
+        const int64_t tick = m_currentTick + static_cast<int64_t>(k);
+        if (m_slotHead[static_cast<size_t>(tick) % WHEEL_SLOTS] != NONE) {
+            return tick > now ? static_cast<DWORD>(tick - now) : 0;
+        }
+    }
+    return INFINITE;
+}
+
+size_t KeyScheduler::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending;
+}
+
+uint64_t KeyScheduler::GetDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped;
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <windows.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+class InputQueue;
+
+/**
+ * @brief Timer wheel for delayed and repeating key events (macros, turbo, hold-to-repeat)
+ *
+ * InputProcessor schedules key transitions here instead of sleeping; the
+ * input thread's wait loop wakes up for the next deadline (GetNextDelayMs)
+ * and GamepadManager fires everything due into the frame's InputQueue
+ * (Advance), so a macro never stalls any device.
+ *
+ * One wheel slot per millisecond; events further out than one revolution
+ * simply stay in their slot until their own due tick comes round. All events
+ * come from a fixed pool allocated at construction, so scheduling never
+ * allocates. Calls may come from device worker threads and are serialized by
+ * an internal lock.
+ */
+class KeyScheduler {
+public:
+    static constexpr size_t POOL_SIZE = 1024;
+    static constexpr size_t WHEEL_SLOTS = 256; // 1 ms per slot
+    static constexpr size_t MAX_KEYS = 8;      // Per event; longer sequences are truncated
+    static constexpr uint32_t ANY_TAG = 0xFFFFFFFF;
+
+    enum class Repeat : uint8_t {
+        None,   // Fire once
+        Toggle, // Alternate down/up every interval (turbo)
+        Press,  // Key-down again every interval (typematic repeat)
+    };
+
+    KeyScheduler();
+
+    KeyScheduler(const KeyScheduler&) = delete;
+    KeyScheduler& operator=(const KeyScheduler&) = delete;
+
+    // False (and counted as dropped) when the pool is exhausted. A one-shot key-up scheduled
+    // here releases keys the caller has already pressed, so cancelling it still owes them.
+    bool Schedule(const void* owner, uint16_t tag, std::span<const WORD> keys, bool down,
+                  uint32_t delayMs, Repeat repeat = Repeat::None, uint32_t intervalMs = 0);
+    
+    // Key-down after delayMs and its key-up holdMs later, both or neither. The key-up is only
+    // owed once the key-down has fired: cancelling the pair before that releases nothing.
+    bool SchedulePress(const void* owner, uint16_t tag, std::span<const WORD> keys,
+                       uint32_t delayMs, uint32_t holdMs);
+
+    struct CancelResult {
+        size_t cancelled = 0;
+        bool keysHeld = false; // A cancelled event was an owed key-up: its keys are still down
+    };
+
+    // Drops the owner's pending events (all of them with ANY_TAG). With releaseInto, the key-ups
+    // the cancelled events still owed are appended there, so nothing they pressed stays down.
+    CancelResult Cancel(const void* owner, uint32_t tag = ANY_TAG, InputQueue* releaseInto = nullptr);
+
+    // Fires every event due by nowQpc into queue, in due order; returns the number fired
+    size_t Advance(int64_t nowQpc, InputQueue& queue);
+
+    // Milliseconds until the next event may be due (INFINITE when nothing is scheduled)
+    DWORD GetNextDelayMs(int64_t nowQpc) const;
+
+    size_t GetPendingCount() const;
+    uint64_t GetDroppedCount() const;
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    struct Event {
+        int64_t dueTick = 0;
+        const void* owner = nullptr; // nullptr: cancelled, freed when its slot is next visited
+        uint32_t next = NONE;
+        uint32_t intervalMs = 0;
+        uint32_t release = NONE;     // Key-down of a SchedulePress pair: its key-up
+        uint16_t tag = 0;
+        Repeat repeat = Repeat::None;
+        bool down = false;
+        bool owed = false;           // One-shot key-up whose keys were actually pressed
+        uint8_t keyCount = 0;
+        std::array<WORD, MAX_KEYS> keys{};
+    };
+
+    static int64_t ToTick(int64_t qpc);
+    uint32_t AllocateEvent();
+    void InitEvent(uint32_t index, const void* owner, uint16_t tag, std::span<const WORD> keys, bool down,
+                   int64_t dueTick, Repeat repeat, uint32_t intervalMs);
+    bool OwesRelease(const Event& event) const;
+    void FreeEvent(uint32_t index);
+    void LinkEvent(uint32_t index);
+    void FireSlot(size_t slot, int64_t tick, int64_t now, InputQueue& queue, size_t& fired);
+
+    mutable std::mutex m_mutex;
+    std::vector<Event> m_pool;                       // Fixed size
+    uint32_t m_freeHead = NONE;
+    std::array<uint32_t, WHEEL_SLOTS> m_slotHead{};
+    std::array<uint32_t, WHEEL_SLOTS> m_slotTail{};
+    int64_t m_currentTick;                           // Last tick processed by Advance
+    size_t m_pending = 0;                            // Linked events, cancelled ones included
+    uint64_t m_dropped = 0;
+};
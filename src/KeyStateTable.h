@@ -0,0 +1,66 @@
+#pragma once
+#include <windows.h>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Reference-counted down state of every virtual key, shared by all devices
+ *
+ * Each source (button, chord, D-pad direction, stick, timed event, on any
+ * pad) pushes its own down/up transitions; only the first press and the
+ * last release of a VK reach SendInput. Two buttons mapped to "alt" keep it
+ * held until both are let go, and the second press injects nothing.
+ *
+ * Sources are expected to be balanced (every up matches an earlier down
+ * from the same source). A stray up on a key nobody holds is dropped
+ * instead of underflowing. Not synchronized: only the thread that owns the
+ * frame's InputQueue touches it.
+ */
+class KeyStateTable {
+public:
+    static constexpr size_t KEY_COUNT = 256;
+
+    // Records one source's transition; true when it changes the key's real state
+    bool Apply(WORD vk, bool down) {
+        if (vk >= KEY_COUNT) {
+            return true; // Not tracked: pass through
+        }
+        uint16_t& count = m_counts[vk];
+        if (down) {
+            if (count == UINT16_MAX) {
+                return false;
+            }
+            if (count++ == 0) {
+                m_heldKeys++;
+                return true;
+            }
+            return false;
+        }
+        if (count == 0) {
+            m_strayReleases++;
+            return false;
+        }
+        if (--count == 0) {
+            m_heldKeys--;
+            return true;
+        }
+        return false;
+    }
+
+    bool IsDown(WORD vk) const { return vk < KEY_COUNT && m_counts[vk] != 0; }
+    uint16_t GetCount(WORD vk) const { return vk < KEY_COUNT ? m_counts[vk] : 0; }
+    size_t GetHeldKeyCount() const { return m_heldKeys; }
+    uint64_t GetStrayReleaseCount() const { return m_strayReleases; }
+
+    // Forgets every hold without injecting anything (the caller releases the keys itself)
+    void Reset() {
+        m_counts.fill(0);
+        m_heldKeys = 0;
+    }
+
+private:
+    std::array<uint16_t, KEY_COUNT> m_counts{};
+    size_t m_heldKeys = 0;
+    uint64_t m_strayReleases = 0;
+};
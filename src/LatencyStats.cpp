@@ -0,0 +1,161 @@
+#include "LatencyStats.h"
+#include <bit>
+
+// =====================================
+// QPC helpers
+// =====================================
+
+int64_t Qpc::Now()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+int64_t Qpc::Frequency()
+{
+    // Fixed at boot, so query once
+    static const int64_t frequency = [] {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return f.QuadPart;
+    }();
+    return frequency;
+}
+
+int64_t Qpc::ToMicroseconds(int64_t ticks)
+{
+    // Split to avoid overflow of ticks * 1'000'000 on long uptimes
+    const int64_t frequency = Frequency();
+    return (ticks / frequency) * 1'000'000 + (ticks % frequency) * 1'000'000 / frequency;
+}
+
+// =====================================
+// LatencyHistogram
+// =====================================
+
+size_t LatencyHistogram::BucketIndex(uint64_t value)
+{
+    constexpr uint64_t linearLimit = uint64_t{1} << SUB_BUCKET_BITS;
+    if (value < linearLimit) {
+        return static_cast<size_t>(value);
+    }
+
+    const size_t msb = static_cast<size_t>(std::bit_width(value)) - 1;
+    const size_t sub = static_cast<size_t>(value >> (msb - SUB_BUCKET_BITS)) & (linearLimit - 1);
+    const size_t index = ((msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + sub;
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index)
+{
+    constexpr size_t linearLimit = size_t{1} << SUB_BUCKET_BITS;
+    if (index < linearLimit) {
+        return index;
+    }
+
+    const size_t shift = (index >> SUB_BUCKET_BITS) - 1;
+    const uint64_t lower = static_cast<uint64_t>(linearLimit + (index & (linearLimit - 1))) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t microseconds)
+{
+    m_buckets[BucketIndex(microseconds)].fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (microseconds > currentMax &&
+           !m_max.compare_exchange_weak(currentMax, microseconds, std::memory_order_relaxed)) {
+    }
+}
+
+LatencySummary LatencyHistogram::Summarize() const
+{
+    // Snapshot the buckets first; concurrent Records may make the result slightly stale, never torn
+    std::array<uint32_t, BUCKET_COUNT> buckets;
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+
+    LatencySummary summary;
+    summary.count = total;
+    summary.max = m_max.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return summary;
+    }
+
+    const uint64_t targets[] = { (total * 50 + 99) / 100, (total * 95 + 99) / 100, (total * 99 + 99) / 100 };
+    uint64_t* results[] = { &summary.p50, &summary.p95, &summary.p99 };
+
+    uint64_t cumulative = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < BUCKET_COUNT && next < 3; ++i) {
+        cumulative += buckets[i];
+        while (next < 3 && cumulative >= targets[next]) {
+            uint64_t bound = BucketUpperBound(i);
+            *results[next++] = bound < summary.max ? bound : summary.max;
+        }
+    }
+
+    return summary;
+}
+
+void LatencyHistogram::Reset()
+{
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+// =====================================
+// DeviceLatencyStats
+// =====================================
+
+void DeviceLatencyStats::OnRead(int64_t qpc)
+{
+    // A read that produced nothing must not be charged to a later transition
+    if (!m_pendingSend) {
+        m_readQpc = qpc;
+    }
+    m_mappedSinceRead = false;
+}
+
+void DeviceLatencyStats::OnMapped(int64_t qpc)
+{
+    if (m_mappedSinceRead) {
+        return; // Only the first transition per read is measured
+    }
+    m_mappedSinceRead = true;
+
+    readToMapped.Record(static_cast<uint64_t>(Qpc::ToMicroseconds(qpc - m_readQpc)));
+
+    if (m_eventTimestampMs != 0) {
+        // dwTimeStamp shares the GetTickCount clock (millisecond resolution)
+        const DWORD ageMs = GetTickCount() - m_eventTimestampMs;
+        eventAge.Record(static_cast<uint64_t>(ageMs) * 1000);
+    }
+
+    m_pendingSend = true;
+}
+
+void DeviceLatencyStats::OnSent(int64_t qpc)
+{
+    if (!m_pendingSend) {
+        return;
+    }
+    m_pendingSend = false;
+
+    readToSent.Record(static_cast<uint64_t>(Qpc::ToMicroseconds(qpc - m_readQpc)));
+}
+
+void DeviceLatencyStats::Reset()
+{
+    readToMapped.Reset();
+    readToSent.Reset();
+    eventAge.Reset();
+    m_mappedSinceRead = false;
+    m_pendingSend = false;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <windows.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief QueryPerformanceCounter helpers
+ */
+namespace Qpc {
+    int64_t Now();
+    int64_t Frequency();
+    int64_t ToMicroseconds(int64_t ticks);
+}
+
+// Percentile summary of one histogram (all values in microseconds)
+struct LatencySummary {
+    uint64_t count = 0;
+    uint64_t p50 = 0;
+    uint64_t p95 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+/**
+ * @brief Lock-free log-linear latency histogram (microsecond resolution)
+ *
+ * Each power of two is split into 4 sub-buckets (~25% relative error), which
+ * covers 1 us .. 2^33 us (~2.4 h) in 128 counters; longer values land in the
+ * last one. Recording is a single relaxed atomic increment, so the input
+ * thread never blocks; any thread may summarize. The count is the sum of the
+ * bucket snapshot, so it always matches the percentiles.
+ */
+class LatencyHistogram {
+public:
+    void Record(uint64_t microseconds);
+    LatencySummary Summarize() const;
+    void Reset();
+
+private:
+    static constexpr size_t SUB_BUCKET_BITS = 2;
+    static constexpr size_t BUCKET_COUNT = 128;
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+
+    std::array<std::atomic<uint32_t>, BUCKET_COUNT> m_buckets{};
+    std::atomic<uint64_t> m_max{ 0 };
+};
+
+/**
+ * @brief Per-device input latency tracking
+ *
+ * Stages, all QPC based unless noted:
+ *   read    - GetDeviceState / GetDeviceData returned
+ *   mapped  - InputProcessor produced the first key transition for that read
+ *   sent    - SendInput returned for the flush carrying that transition
+ * eventAge is the DirectInput dwTimeStamp of the record (millisecond clock) to mapping.
+ */
+class DeviceLatencyStats {
+public:
+    void OnRead(int64_t qpc);
+    void OnEventTimestamp(DWORD timestampMs) { m_eventTimestampMs = timestampMs; }
+    void OnMapped(int64_t qpc);
+    void OnSent(int64_t qpc);
+    void Reset();
+
+    LatencyHistogram readToMapped;
+    LatencyHistogram readToSent;
+    LatencyHistogram eventAge;
+
+private:
+    int64_t m_readQpc = 0;
+    DWORD m_eventTimestampMs = 0; // 0: not in buffered mode
+    bool m_mappedSinceRead = false;
+    bool m_pendingSend = false;
+};
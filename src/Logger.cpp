@@ -1,14 +1,14 @@
 #include "Logger.h"
+#include "TextConversion.h"
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/async.h>
 #include <windows.h>
+#include <algorithm>
 #include <cstdio>
 #include <cstdarg>
 #include <cwchar>
-#include <codecvt>
-#include <locale>
 
 // Singleton instance
 Logger& Logger::GetInstance() {
@@ -24,7 +24,7 @@ Logger::~Logger() {
     Close();
 }
 
-bool Logger::Init(const std::string& logFilePath) {
+bool Logger::Init(const std::string& logFilePath, const LoggerOptions& options) {
     try {
         // Create rotating file sink (5MB max size, 3 backup files)
         auto rotating_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
@@ -40,17 +40,26 @@ bool Logger::Init(const std::string& logFilePath) {
         sinks.push_back(console_sink);
 #endif
 
-        // Create logger with multiple sinks
-        m_logger = std::make_shared<spdlog::logger>("gamepad_mapper", sinks.begin(), sinks.end());
+        if (options.async) {
+            // One background thread owns the sinks; callers only enqueue into a bounded queue
+            m_threadPool = std::make_shared<spdlog::details::thread_pool>(std::max<size_t>(options.queueSize, 1), 1);
+            auto policy = options.discardOldestOnOverflow ? spdlog::async_overflow_policy::overrun_oldest
+                                                          : spdlog::async_overflow_policy::block;
+            m_logger = std::make_shared<spdlog::async_logger>("gamepad_mapper", sinks.begin(), sinks.end(),
+                                                              m_threadPool, policy);
+        } else {
+            // Create logger with multiple sinks
+            m_logger = std::make_shared<spdlog::logger>("gamepad_mapper", sinks.begin(), sinks.end());
+        }
         
         // Set pattern: [timestamp] [level] message
         m_logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] %v");
         
-        // Set log level (INFO for release, DEBUG for debug builds)
-#ifdef _DEBUG
-        m_logger->set_level(spdlog::level::debug);
+        // Set log level (always at least DEBUG for debug builds)
+#ifndef NDEBUG
+        m_logger->set_level((std::min)(options.level, spdlog::level::debug));
 #else
-        m_logger->set_level(spdlog::level::info);
+        m_logger->set_level(options.level);
 #endif
 
         // Register logger globally
@@ -59,10 +68,35 @@ bool Logger::Init(const std::string& logFilePath) {
         // Enable automatic flushing on error level
         m_logger->flush_on(spdlog::level::err);
         
+        // Periodic flush keeps the file reasonably current without flushing per message.
+        // spdlog's flusher only takes whole seconds
+        std::chrono::milliseconds flushInterval{ 0 };
+        if (options.flushInterval.count() > 0) {
+            const auto flushSeconds = (std::max)(std::chrono::round<std::chrono::seconds>(options.flushInterval),
+                                                 std::chrono::seconds(1));
+            spdlog::flush_every(flushSeconds);
+            flushInterval = flushSeconds;
+        }
+        
         m_isInitialized = true;
         
         // Log startup message
         m_logger->info("=== Gamepad to Keyboard Mapper Log Started ===");
+        if (options.async) {
+            m_logger->info("Async logging: queue {} messages, overflow policy {}, flush every {} ms",
+                           options.queueSize, options.discardOldestOnOverflow ? "discard_oldest" : "block",
+                           flushInterval.count());
+        }
+        if (flushInterval != options.flushInterval && options.flushInterval.count() > 0) {
+            m_logger->warn("Log flush interval {} ms rounded to {} ms (whole seconds only)",
+                           options.flushInterval.count(), flushInterval.count());
+        }
+        if (options.level < GAMEPAD_LOG_ACTIVE_LEVEL) {
+            m_logger->warn("Log level \"{}\" requested, but this build only contains messages from \"{}\" up "
+                           "(GAMEPAD_LOG_ACTIVE_LEVEL)",
+                           spdlog::level::to_string_view(options.level),
+                           spdlog::level::to_string_view(static_cast<spdlog::level::level_enum>(GAMEPAD_LOG_ACTIVE_LEVEL)));
+        }
         
         SYSTEMTIME st;
         GetLocalTime(&st);
@@ -81,14 +115,24 @@ bool Logger::Init(const std::string& logFilePath) {
 
 void Logger::Close() {
     if (m_logger && m_isInitialized) {
-        m_logger->info("=== Log Ended ===");
+        if (m_threadPool) {
+            m_logger->info("=== Log Ended ({} messages dropped) ===", GetDroppedMessageCount());
+        } else {
+            m_logger->info("=== Log Ended ===");
+        }
         m_logger->flush();
         spdlog::drop("gamepad_mapper");
         m_logger.reset();
+        // Destroying the pool drains the queue and joins the logging thread
+        m_threadPool.reset();
         m_isInitialized = false;
     }
 }
 
+uint64_t Logger::GetDroppedMessageCount() const {
+    return m_threadPool ? static_cast<uint64_t>(m_threadPool->overrun_counter()) : 0;
+}
+
 void Logger::Write(const char* fmt, ...) {
     if (!m_logger) return;
     
@@ -110,8 +154,7 @@ void Logger::WriteW(const wchar_t* fmt, ...) {
     vswprintf_s(buf, _countof(buf), fmt, ap);
     va_end(ap);
     
-    std::string utf8_str = WStringToString(buf);
-    m_logger->info(utf8_str);
+    m_logger->info(Text::WideToUtf8Scratch(buf));
 }
 
 
@@ -119,8 +162,7 @@ void Logger::WriteW(const wchar_t* fmt, ...) {
 void Logger::InfoW(const std::wstring& message) {
     if (m_logger) {
         try {
-            std::string utf8_str = WStringToString(message);
-            m_logger->info(utf8_str);
+            m_logger->info(Text::WideToUtf8Scratch(message));
         }
         catch (const std::exception& e) {
             m_logger->error("Failed to convert wide string for logging: {}", e.what());
@@ -131,8 +173,7 @@ void Logger::InfoW(const std::wstring& message) {
 void Logger::DebugW(const std::wstring& message) {
     if (m_logger) {
         try {
-            std::string utf8_str = WStringToString(message);
-            m_logger->debug(utf8_str);
+            m_logger->debug(Text::WideToUtf8Scratch(message));
         }
         catch (const std::exception& e) {
             m_logger->error("Failed to convert wide string for logging: {}", e.what());
@@ -143,8 +184,7 @@ void Logger::DebugW(const std::wstring& message) {
 void Logger::WarnW(const std::wstring& message) {
     if (m_logger) {
         try {
-            std::string utf8_str = WStringToString(message);
-            m_logger->warn(utf8_str);
+            m_logger->warn(Text::WideToUtf8Scratch(message));
         }
         catch (const std::exception& e) {
             m_logger->error("Failed to convert wide string for logging: {}", e.what());
@@ -155,8 +195,7 @@ void Logger::WarnW(const std::wstring& message) {
 void Logger::ErrorW(const std::wstring& message) {
     if (m_logger) {
         try {
-            std::string utf8_str = WStringToString(message);
-            m_logger->error(utf8_str);
+            m_logger->error(Text::WideToUtf8Scratch(message));
         }
         catch (const std::exception& e) {
             // Last resort error output
@@ -180,22 +219,3 @@ void Logger::EnableConsoleOutput(bool enable) {
         m_logger->info("Console output setting changed to: {}", enable ? "enabled" : "disabled");
     }
 }
-
-// Helper methods for string conversion
-std::string Logger::WStringToString(const std::wstring& wstr) {
-    if (wstr.empty()) return {};
-    
-    int size_needed = WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), NULL, 0, NULL, NULL);
-    std::string strTo(size_needed, 0);
-    WideCharToMultiByte(CP_UTF8, 0, &wstr[0], (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
-    return strTo;
-}
-
-std::wstring Logger::StringToWString(const std::string& str) {
-    if (str.empty()) return {};
-    
-    int size_needed = MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), NULL, 0);
-    std::wstring wstrTo(size_needed, 0);
-    MultiByteToWideChar(CP_UTF8, 0, &str[0], (int)str.size(), &wstrTo[0], size_needed);
-    return wstrTo;
-}
\ No newline at end of file
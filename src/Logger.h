@@ -2,11 +2,66 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/async_logger.h>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <span>
 #include <mutex>
 
+// Compile-time minimum log level (SPDLOG_LEVEL_*). Calls below it compile to nothing,
+// including their arguments. Override with -DGAMEPAD_LOG_ACTIVE_LEVEL=<level>.
+// Keyed on NDEBUG rather than _DEBUG, which only MSVC defines (MinGW builds never set it).
+#ifndef GAMEPAD_LOG_ACTIVE_LEVEL
+#ifndef NDEBUG
+#define GAMEPAD_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_DEBUG
+#else
+#define GAMEPAD_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_INFO
+#endif
+#endif
+
+/**
+ * @brief Structured log field for a virtual-key sequence
+ *
+ * Formats as "0x41+0x42" only when the message is actually emitted, so hot-path
+ * callers can pass the compiled key span instead of building a string up front.
+ */
+struct VkSequence {
+    std::span<const unsigned short> keys;
+};
+
+template<>
+struct fmt::formatter<VkSequence> {
+    constexpr auto parse(fmt::format_parse_context& ctx) { return ctx.begin(); }
+
+    template<typename FormatContext>
+    auto format(const VkSequence& seq, FormatContext& ctx) const {
+        auto out = ctx.out();
+        for (size_t i = 0; i < seq.keys.size(); ++i) {
+            if (i > 0) *out++ = '+';
+            out = fmt::format_to(out, "0x{:02X}", seq.keys[i]);
+        }
+        return out;
+    }
+};
+
+/**
+ * @brief Logger pipeline settings (filled from SystemConfig by Application)
+ *
+ * In async mode log calls only enqueue; formatting and file I/O happen on a
+ * dedicated spdlog thread pool, so disk stalls never reach the input thread.
+ */
+struct LoggerOptions {
+    bool async = true;
+    size_t queueSize = 8192;                         // Messages, preallocated
+    bool discardOldestOnOverflow = true;             // false: block the caller until there is room
+    std::chrono::milliseconds flushInterval{ 1000 }; // 0 disables periodic flushing; rounded to whole seconds (min 1 s)
+    spdlog::level::level_enum level = spdlog::level::info;
+};
+
 class Logger {
 public:
     // Constructor/Destructor for dependency injection
@@ -17,37 +72,41 @@ public:
     static Logger& GetInstance();
 
     // ILogger interface implementation
-    bool Init(const std::string& logFilePath);
+    bool Init(const std::string& logFilePath, const LoggerOptions& options = {});
     void Close();
 
+    // Async pipeline diagnostics
+    bool IsAsync() const { return static_cast<bool>(m_threadPool); }
+    uint64_t GetDroppedMessageCount() const;
+
     void Write(const char* fmt, ...);
     void WriteW(const wchar_t* fmt, ...);
 
 
     // Modern logging methods with levels
     template<typename... Args>
-    void Info(const std::string& fmt, Args&&... args) {
+    void Info(std::string_view fmt, Args&&... args) {
         if (m_logger) {
             m_logger->info(fmt::runtime(fmt), std::forward<Args>(args)...);
         }
     }
 
     template<typename... Args>
-    void Debug(const std::string& fmt, Args&&... args) {
+    void Debug(std::string_view fmt, Args&&... args) {
         if (m_logger) {
             m_logger->debug(fmt::runtime(fmt), std::forward<Args>(args)...);
         }
     }
 
     template<typename... Args>
-    void Warn(const std::string& fmt, Args&&... args) {
+    void Warn(std::string_view fmt, Args&&... args) {
         if (m_logger) {
             m_logger->warn(fmt::runtime(fmt), std::forward<Args>(args)...);
         }
     }
 
     template<typename... Args>
-    void Error(const std::string& fmt, Args&&... args) {
+    void Error(std::string_view fmt, Args&&... args) {
         if (m_logger) {
             m_logger->error(fmt::runtime(fmt), std::forward<Args>(args)...);
         }
@@ -59,6 +118,11 @@ public:
     void WarnW(const std::wstring& message);
     void ErrorW(const std::wstring& message);
 
+    // Runtime level check (used by the LOG_* macros before evaluating arguments)
+    bool ShouldLog(spdlog::level::level_enum level) const {
+        return m_logger && m_logger->should_log(level);
+    }
+
     // Configuration methods
     void SetLogLevel(spdlog::level::level_enum level);
     void EnableConsoleOutput(bool enable);
@@ -68,26 +132,51 @@ private:
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    // Helper methods
-    std::string WStringToString(const std::wstring& wstr);
-    std::wstring StringToWString(const std::string& str);
-
     // Member variables
     std::shared_ptr<spdlog::logger> m_logger;
+    std::shared_ptr<spdlog::details::thread_pool> m_threadPool; // Only set in async mode
     bool m_isInitialized;
 };
 
+// Arguments are only evaluated when the level is enabled at runtime
+#define GAMEPAD_LOG_AT_LEVEL_(level, method, ...) \
+    do { \
+        Logger& gamepadLogger_ = Logger::GetInstance(); \
+        if (gamepadLogger_.ShouldLog(level)) { \
+            gamepadLogger_.method(__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define GAMEPAD_LOG_DISABLED_ do { } while (0)
+
 // New modern macros for improved logging
-#define LOG_INFO(...) Logger::GetInstance().Info(__VA_ARGS__)
-#define LOG_DEBUG(...) Logger::GetInstance().Debug(__VA_ARGS__)
-#define LOG_WARN(...) Logger::GetInstance().Warn(__VA_ARGS__)
-#define LOG_ERROR(...) Logger::GetInstance().Error(__VA_ARGS__)
-
-// Wide string macros for Windows
-#define LOG_INFO_W(msg) Logger::GetInstance().InfoW(msg)
-#define LOG_DEBUG_W(msg) Logger::GetInstance().DebugW(msg)
-#define LOG_WARN_W(msg) Logger::GetInstance().WarnW(msg)
-#define LOG_ERROR_W(msg) Logger::GetInstance().ErrorW(msg)
+#if GAMEPAD_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define LOG_INFO(...) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::info, Info, __VA_ARGS__)
+#define LOG_INFO_W(msg) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::info, InfoW, msg)
+#else
+#define LOG_INFO(...) GAMEPAD_LOG_DISABLED_
+#define LOG_INFO_W(msg) GAMEPAD_LOG_DISABLED_
+#endif
+
+#if GAMEPAD_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::debug, Debug, __VA_ARGS__)
+#define LOG_DEBUG_W(msg) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::debug, DebugW, msg)
+#else
+#define LOG_DEBUG(...) GAMEPAD_LOG_DISABLED_
+#define LOG_DEBUG_W(msg) GAMEPAD_LOG_DISABLED_
+#endif
+
+#if GAMEPAD_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
+#define LOG_WARN(...) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::warn, Warn, __VA_ARGS__)
+#define LOG_WARN_W(msg) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::warn, WarnW, msg)
+#else
+#define LOG_WARN(...) GAMEPAD_LOG_DISABLED_
+#define LOG_WARN_W(msg) GAMEPAD_LOG_DISABLED_
+#endif
+
+// Errors are never compiled out
+#define LOG_ERROR(...) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::err, Error, __VA_ARGS__)
+#define LOG_ERROR_W(msg) GAMEPAD_LOG_AT_LEVEL_(spdlog::level::err, ErrorW, msg)
 
 
 // Backward compatibility macros (DEPRECATED - for old Logger.h compatibility)
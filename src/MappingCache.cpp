@@ -0,0 +1,195 @@
+#include "MappingCache.h"
+#include "Win32Handle.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t CACHE_MAGIC = 0x31434D47; // "GMC1"
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceSize;
+    uint64_t sourceWriteTime;
+    uint64_t sourceHash;
+    uint32_t systemJsonBytes;
+    uint32_t keyMapBytes;
+    uint64_t payloadHash; // Guards against torn or truncated writes
+};
+
+uint64_t Fnv1a64(const void* data, size_t size, uint64_t hash = 0xCBF29CE484222325ull)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+uint64_t PayloadHash(std::span<const uint8_t> systemJson, std::span<const uint8_t> keyMap)
+{
+    return Fnv1a64(keyMap.data(), keyMap.size(), Fnv1a64(systemJson.data(), systemJson.size()));
+}
+
+// Read-only view of a whole file; unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path)
+    {
+        m_file.reset(CreateFileW(std::filesystem::path(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+        if (m_file.get() == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file.get(), &size) || size.QuadPart <= 0 || size.QuadPart > 0x7FFFFFFF) {
+            return;
+        }
+        m_mapping.reset(CreateFileMappingW(m_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+        if (!m_mapping) {
+            return;
+        }
+        m_view = static_cast<const uint8_t*>(MapViewOfFile(m_mapping.get(), FILE_MAP_READ, 0, 0, 0));
+        if (m_view) {
+            m_size = static_cast<size_t>(size.QuadPart);
+        }
+    }
+
+    ~MappedFile()
+    {
+        if (m_view) {
+            UnmapViewOfFile(m_view);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::span<const uint8_t> Bytes() const { return { m_view, m_size }; }
+
+private:
+    UniqueHandle m_file;
+    UniqueHandle m_mapping;
+    const uint8_t* m_view = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace
+
+namespace MappingCache {
+
+std::string CachePathFor(const std::string& configPath)
+{
+    return configPath + ".cache";
+}
+
+SourceStamp MakeStamp(const std::string& configPath, std::string_view text)
+{
+    SourceStamp stamp;
+    stamp.size = text.size();
+    stamp.hash = Fnv1a64(text.data(), text.size());
+
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (GetFileAttributesExW(std::filesystem::path(configPath).c_str(), GetFileExInfoStandard, &attributes)) {
+        stamp.writeTime = (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+                          attributes.ftLastWriteTime.dwLowDateTime;
+    }
+    return stamp;
+}
+
+bool Load(const std::string& configPath, const SourceStamp& stamp,
+          std::string& systemJson, CompiledKeyMap& keyMap)
+{
+    // A zero write time means the attributes could not be read: never trust the cache then
+    if (stamp.writeTime == 0) {
+        return false;
+    }
+
+    const MappedFile file(CachePathFor(configPath));
+    const std::span<const uint8_t> bytes = file.Bytes();
+    if (bytes.size() < sizeof(CacheHeader)) {
+        return false;
+    }
+
+    CacheHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.magic != CACHE_MAGIC || header.version != FORMAT_VERSION ||
+        header.sourceSize != stamp.size || header.sourceWriteTime != stamp.writeTime ||
+        header.sourceHash != stamp.hash) {
+        return false;
+    }
+    if (bytes.size() != sizeof(CacheHeader) + size_t{header.systemJsonBytes} + header.keyMapBytes) {
+        return false;
+    }
+
+    const auto systemBytes = bytes.subspan(sizeof(CacheHeader), header.systemJsonBytes);
+    const auto keyMapBytes = bytes.subspan(sizeof(CacheHeader) + header.systemJsonBytes, header.keyMapBytes);
+    if (PayloadHash(systemBytes, keyMapBytes) != header.payloadHash) {
+        return false;
+    }
+
+    if (!keyMap.deserialize(keyMapBytes)) {
+        return false;
+    }
+    systemJson.assign(reinterpret_cast<const char*>(systemBytes.data()), systemBytes.size());
+    return true;
+}
+
+bool Store(const std::string& configPath, const SourceStamp& stamp,
+           std::string_view systemJson, const CompiledKeyMap& keyMap)
+{
+    if (stamp.writeTime == 0) {
+        return false;
+    }
+
+    std::vector<uint8_t> keyMapImage;
+    keyMap.serialize(keyMapImage);
+
+    const std::span<const uint8_t> systemBytes(reinterpret_cast<const uint8_t*>(systemJson.data()), systemJson.size());
+
+    CacheHeader header{};
+    header.magic = CACHE_MAGIC;
+    header.version = FORMAT_VERSION;
+    header.sourceSize = stamp.size;
+    header.sourceWriteTime = stamp.writeTime;
+    header.sourceHash = stamp.hash;
+    header.systemJsonBytes = static_cast<uint32_t>(systemBytes.size());
+    header.keyMapBytes = static_cast<uint32_t>(keyMapImage.size());
+    header.payloadHash = PayloadHash(systemBytes, keyMapImage);
+
+    const std::filesystem::path cachePath(CachePathFor(configPath));
+    std::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(systemJson.data(), static_cast<std::streamsize>(systemJson.size()));
+        out.write(reinterpret_cast<const char*>(keyMapImage.data()), static_cast<std::streamsize>(keyMapImage.size()));
+        if (!out) {
+            out.close();
+            std::error_code ignored;
+            std::filesystem::remove(tempPath, ignored);
+            return false;
+        }
+    }
+
+    // Readers see either the old or the new cache, never a partial one
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+} // namespace MappingCache
@@ -0,0 +1,41 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "CompiledKeyMap.h"
+
+/**
+ * @brief Binary cache of a compiled device configuration
+ *
+ * Stored next to the JSON file as "<config>.json.cache". It holds the
+ * CompiledKeyMap image plus the raw "config" object, so a warm start skips
+ * parsing the gamepad section and resolving every key name. The header
+ * records the size, last-write time and FNV-1a hash of the JSON it was built
+ * from; any mismatch (or a different format version) makes the cache stale
+ * and ConfigManager falls back to the JSON and rewrites it.
+ */
+namespace MappingCache {
+    // Bump whenever the image layout, the key name table (KeyResolver) or the compile rules change
+    constexpr uint32_t FORMAT_VERSION = 6;
+
+    // Identity of the JSON text a cache was compiled from
+    struct SourceStamp {
+        uint64_t size = 0;
+        uint64_t writeTime = 0; // FILETIME of the last write
+        uint64_t hash = 0;      // FNV-1a 64 of the file contents
+    };
+
+    std::string CachePathFor(const std::string& configPath);
+
+    // text is the file content already read by the caller; the write time comes from the file system
+    SourceStamp MakeStamp(const std::string& configPath, std::string_view text);
+
+    // Memory-maps the cache; false when it is missing, stale or corrupt (outputs are then unspecified)
+    bool Load(const std::string& configPath, const SourceStamp& stamp,
+              std::string& systemJson, CompiledKeyMap& keyMap);
+
+    // Best effort: written to a temporary file and renamed over the old cache
+    bool Store(const std::string& configPath, const SourceStamp& stamp,
+               std::string_view systemJson, const CompiledKeyMap& keyMap);
+}
@@ -0,0 +1,69 @@
+#include "MetricsExport.h"
+#include "Logger.h"
+#include <cstring>
+
+MetricsExport::~MetricsExport()
+{
+    Close();
+}
+
+bool MetricsExport::Open(const std::wstring& name)
+{
+    if (IsOpen()) {
+        return true;
+    }
+
+    m_mapping.reset(CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+                                       static_cast<DWORD>(sizeof(Metrics::SharedBlock)), name.c_str()));
+    if (!m_mapping) {
+        LOG_ERROR_W(L"Failed to create metrics shared memory: " + name + L". Error: " + std::to_wstring(GetLastError()));
+        return false;
+    }
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        // Two writers would corrupt each other's snapshots
+        LOG_WARN_W(L"Metrics shared memory already exists (another instance?), not publishing: " + name);
+        m_mapping.reset();
+        return false;
+    }
+
+    m_block = static_cast<Metrics::SharedBlock*>(MapViewOfFile(m_mapping.get(), FILE_MAP_WRITE, 0, 0, sizeof(Metrics::SharedBlock)));
+    if (!m_block) {
+        LOG_ERROR_W(L"Failed to map metrics shared memory: " + name + L". Error: " + std::to_wstring(GetLastError()));
+        m_mapping.reset();
+        return false;
+    }
+
+    // Fresh pagefile-backed sections are zeroed, so the sequence starts even
+    m_block->magic = Metrics::MAGIC;
+    m_block->version = Metrics::VERSION;
+    m_block->blockBytes = static_cast<uint32_t>(sizeof(Metrics::SharedBlock));
+    m_block->writerProcessId = GetCurrentProcessId();
+    m_scratch = Metrics::Snapshot{};
+    m_scratch.qpcFrequency = Qpc::Frequency();
+
+    LOG_INFO_W(L"Publishing metrics to shared memory: " + name);
+    return true;
+}
+
+void MetricsExport::Close()
+{
+    if (m_block) {
+        UnmapViewOfFile(m_block);
+        m_block = nullptr;
+    }
+    m_mapping.reset();
+}
+
+void MetricsExport::Publish()
+{
+    if (!m_block) {
+        return;
+    }
+
+    // Odd while the copy is in progress; readers that overlap it retry
+    const uint32_t sequence = m_block->sequence.load(std::memory_order_relaxed);
+    m_block->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&m_block->data, &m_scratch, sizeof(m_scratch));
+    m_block->sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "LatencyStats.h"
+#include "Win32Handle.h"
+
+/**
+ * @brief Layout of the shared-memory metrics segment
+ *
+ * One writer (the input thread) and any number of readers in other
+ * processes. The block is a seqlock: the writer makes the sequence odd,
+ * copies a complete Snapshot in and makes it even again. A reader copies
+ * the snapshot out and keeps it only if the sequence was even and the same
+ * before and after the copy:
+ *
+ *     do { s1 = sequence (acquire); copy data; fence(acquire); s2 = sequence; }
+ *     while ((s1 & 1) || s1 != s2);
+ *
+ * Readers never block the writer. Counters are totals since start-up;
+ * latencies are in microseconds; fields only ever get appended (version).
+ */
+namespace Metrics {
+    constexpr uint32_t MAGIC = 0x4D544D47; // "GMTM"
+    constexpr uint16_t VERSION = 1;
+    constexpr size_t MAX_DEVICES = 16;
+    constexpr size_t NAME_CHARS = 64;
+    constexpr size_t BACKEND_CHARS = 16;
+
+    struct Device {
+        wchar_t name[NAME_CHARS];
+        wchar_t backend[BACKEND_CHARS];
+        GUID guid;
+        uint32_t slot;
+        uint32_t connected;
+        uint64_t reads;              // Reads that delivered state (polls, buffer drains)
+        uint64_t states;             // States fed to the mapping
+        uint64_t reconnectAttempts;
+        double readsPerSecond;       // Over the last publish interval
+        LatencySummary readToMapped;
+        LatencySummary readToSent;
+        LatencySummary eventAge;
+    };
+
+    struct Snapshot {
+        int64_t qpcTimestamp;        // When this snapshot was taken
+        int64_t qpcFrequency;
+        uint64_t frames;
+        LatencySummary frameTime;    // GamepadManager::ProcessAllDevices
+        uint64_t sendInputCalls;
+        uint64_t sendInputEvents;
+        uint64_t suppressedEvents;   // Absorbed by the shared key state
+        uint64_t enumerations;
+        uint64_t lastEnumerationUs;  // EnumDevices call
+        uint64_t maxEnumerationUs;
+        uint64_t droppedLogMessages;
+        uint32_t deviceCount;        // Valid entries in devices
+        uint32_t reserved;
+        Device devices[MAX_DEVICES];
+    };
+
+    struct SharedBlock {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t blockBytes;         // sizeof(SharedBlock) of the writer
+        uint32_t writerProcessId;
+        std::atomic<uint32_t> sequence;
+        uint32_t reserved2;
+        Snapshot data;
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "the seqlock must be lock-free across processes");
+}
+
+/**
+ * @brief Writer side of the metrics segment (input thread)
+ *
+ * Fill Data() and Publish() it; the scratch snapshot lives in this object so
+ * a publish never allocates and holds the segment for one memcpy.
+ */
+class MetricsExport {
+public:
+    MetricsExport() = default;
+    ~MetricsExport();
+
+    MetricsExport(const MetricsExport&) = delete;
+    MetricsExport& operator=(const MetricsExport&) = delete;
+
+    // name: a kernel object name, e.g. L"Local\\GamepadMapperMetrics"
+    bool Open(const std::wstring& name);
+    void Close();
+    bool IsOpen() const { return m_block != nullptr; }
+
+    Metrics::Snapshot& Data() { return m_scratch; }
+    void Publish();
+
+private:
+    UniqueHandle m_mapping;
+    Metrics::SharedBlock* m_block = nullptr;
+    Metrics::Snapshot m_scratch{};
+};
@@ -0,0 +1,124 @@
+#include "ProfileSwitcher.h"
+#include "Logger.h"
+#include "Win32Handle.h"
+#include "TextConversion.h"
+#include <algorithm>
+#include <iterator>
+
+ProfileSwitcher* ProfileSwitcher::s_instance = nullptr;
+
+namespace {
+
+std::wstring ToLowerFileName(std::wstring name)
+{
+    if (!name.empty()) {
+        CharLowerBuffW(&name[0], static_cast<DWORD>(name.size()));
+    }
+    return name;
+}
+
+} // namespace
+
+ProfileSwitcher::~ProfileSwitcher()
+{
+    Stop();
+}
+
+void ProfileSwitcher::SetRules(const std::map<std::string, std::string>& rules)
+{
+    m_profileNames.assign(1, std::string());
+    m_profileByExe.clear();
+
+    for (const auto& [exe, profile] : rules) {
+        if (exe.empty() || profile.empty()) {
+            continue;
+        }
+
+        // Several executables may share a profile: number each name once
+        auto it = std::find(m_profileNames.begin(), m_profileNames.end(), profile);
+        const uint32_t number = static_cast<uint32_t>(it - m_profileNames.begin());
+        if (it == m_profileNames.end()) {
+            m_profileNames.push_back(profile);
+        }
+
+        m_profileByExe[ToLowerFileName(Text::Utf8ToWide(exe))] = number;
+    }
+}
+
+bool ProfileSwitcher::Start()
+{
+    if (m_hook || !HasRules()) {
+        return m_hook != nullptr;
+    }
+
+    s_instance = this;
+    m_hook = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr, OnForegroundChanged,
+                             0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    if (!m_hook) {
+        LOG_ERROR("SetWinEventHook(EVENT_SYSTEM_FOREGROUND) failed. Error: {}", GetLastError());
+        s_instance = nullptr;
+        return false;
+    }
+
+    LOG_INFO("Profile switching enabled: {} profiles for {} applications.", m_profileNames.size() - 1, m_profileByExe.size());
+
+    // The hook only reports changes; pick up whatever is in front right now
+    UpdateFromWindow(GetForegroundWindow());
+    return true;
+}
+
+void ProfileSwitcher::Stop()
+{
+    if (m_hook) {
+        UnhookWinEvent(m_hook);
+        m_hook = nullptr;
+    }
+    if (s_instance == this) {
+        s_instance = nullptr;
+    }
+}
+
+void CALLBACK ProfileSwitcher::OnForegroundChanged(HWINEVENTHOOK, DWORD, HWND hwnd, LONG idObject,
+                                                   LONG idChild, DWORD, DWORD)
+{
+    if (s_instance && hwnd && idObject == OBJID_WINDOW && idChild == CHILDID_SELF) {
+        s_instance->UpdateFromWindow(hwnd);
+    }
+}
+
+void ProfileSwitcher::UpdateFromWindow(HWND hwnd)
+{
+    const uint32_t profile = FindProfile(hwnd);
+    if (m_activeProfile.exchange(profile, std::memory_order_relaxed) != profile) {
+        LOG_INFO("Active profile: {}", profile == 0 ? std::string("default") : m_profileNames[profile]);
+    }
+}
+
+uint32_t ProfileSwitcher::FindProfile(HWND hwnd) const
+{
+    DWORD processId = 0;
+    if (!hwnd || !GetWindowThreadProcessId(hwnd, &processId) || processId == 0) {
+        return 0;
+    }
+
+    // Limited access works for elevated and protected processes too
+    UniqueHandle process(OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId));
+    if (!process) {
+        return 0;
+    }
+
+    wchar_t path[MAX_PATH * 2];
+    DWORD size = static_cast<DWORD>(std::size(path));
+    if (!QueryFullProcessImageNameW(process.get(), 0, path, &size)) {
+        return 0;
+    }
+
+    std::wstring fileName(path, size);
+    const size_t separator = fileName.find_last_of(L"\\/");
+    if (separator != std::wstring::npos) {
+        fileName.erase(0, separator + 1);
+    }
+
+    auto it = m_profileByExe.find(ToLowerFileName(std::move(fileName)));
+    return it != m_profileByExe.end() ? it->second : 0;
+}
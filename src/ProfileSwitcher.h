@@ -0,0 +1,57 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Picks the mapping profile from the foreground application
+ *
+ * Rules map an executable file name (case-insensitive, e.g. "game.exe") to a
+ * profile name. Profile numbers index GetProfileNames(); 0 is the default
+ * mapping, used whenever the foreground application has no rule.
+ *
+ * A WinEvent hook on EVENT_SYSTEM_FOREGROUND resolves the new foreground
+ * process once per activation and publishes the profile number; the input
+ * thread only loads it (no GetForegroundWindow per frame). The hook is
+ * out of context, so Start/Stop must run on a thread that pumps messages
+ * (the window thread). Our own windows are skipped: bringing the mapper's
+ * window to the front keeps the game's profile.
+ */
+class ProfileSwitcher {
+public:
+    ProfileSwitcher() = default;
+    ~ProfileSwitcher();
+
+    ProfileSwitcher(const ProfileSwitcher&) = delete;
+    ProfileSwitcher& operator=(const ProfileSwitcher&) = delete;
+
+    // Before Start: executable name -> profile name (UTF-8, as in the system config)
+    void SetRules(const std::map<std::string, std::string>& rules);
+    bool HasRules() const { return !m_profileByExe.empty(); }
+
+    // [0] = "" (default); stable once the rules are set
+    const std::vector<std::string>& GetProfileNames() const { return m_profileNames; }
+
+    bool Start();
+    void Stop();
+
+    // Any thread
+    uint32_t GetActiveProfile() const { return m_activeProfile.load(std::memory_order_relaxed); }
+
+private:
+    static void CALLBACK OnForegroundChanged(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                                             LONG idChild, DWORD eventThread, DWORD eventTime);
+    void UpdateFromWindow(HWND hwnd);
+    uint32_t FindProfile(HWND hwnd) const;
+
+    static ProfileSwitcher* s_instance; // WinEvent callbacks carry no context
+
+    std::vector<std::string> m_profileNames{ std::string() };
+    std::unordered_map<std::wstring, uint32_t> m_profileByExe; // Lower-case file name
+    HWINEVENTHOOK m_hook = nullptr;
+    std::atomic<uint32_t> m_activeProfile{ 0 };
+};
@@ -0,0 +1,97 @@
+#include "ReplayDevice.h"
+#include "ConfigManager.h"
+#include "InputProcessor.h"
+#include "Logger.h"
+
+ReplayDevice::~ReplayDevice()
+{
+    Shutdown();
+}
+
+GUID ReplayDevice::MakeGuid()
+{
+    // "RPLY"; never collides with a DirectInput instance GUID
+    return GUID{ 0x594C5052, 0x0000, 0x0000, { 0, 0, 0, 0, 0, 0, 0, 0 } };
+}
+
+bool ReplayDevice::Initialize(const std::wstring& path, bool realTime)
+{
+    if (m_initialized) {
+        return true;
+    }
+
+    if (!m_reader.Open(path)) {
+        return false;
+    }
+
+    // Store device information (the recorded pad's name selects its configuration)
+    m_deviceName = m_reader.GetHeader().deviceName;
+    m_deviceInstanceName = path;
+    m_deviceGUID = MakeGuid();
+    m_realTime = realTime;
+
+    // Load configuration
+    if (!LoadConfiguration()) {
+        LOG_ERROR_W(L"Failed to load configuration for device: " + m_deviceName);
+        m_reader.Close();
+        return false;
+    }
+
+    // Initialize input processor
+    CreateInputProcessor();
+    m_currentState = DIJOYSTATE2{};
+    m_hasState = m_reader.Next();
+    m_finished = false;
+    m_startQpc = Qpc::Now();
+
+    m_initialized = true;
+    m_connected = true;
+
+    LOG_INFO_W(L"GamepadDevice initialized successfully: " + m_deviceName + L" (" + m_deviceInstanceName + L") [Replay, " +
+               (m_realTime ? L"real time]" : L"as fast as possible]"));
+
+    return true;
+}
+
+int64_t ReplayDevice::ToLocalTicks(int64_t recordedTicks) const
+{
+    // Split so hour-long recordings don't overflow the multiplication
+    const int64_t from = m_reader.GetHeader().qpcFrequency;
+    const int64_t to = Qpc::Frequency();
+    return recordedTicks / from * to + recordedTicks % from * to / from;
+}
+
+bool ReplayDevice::ReadInput()
+{
+    if (m_finished) {
+        return true;
+    }
+
+    const int64_t now = Qpc::Now();
+    size_t fed = 0;
+    while (m_hasState) {
+        if (m_realTime) {
+            const int64_t due = m_startQpc + ToLocalTicks(m_reader.GetTimestamp() - m_reader.GetFirstTimestamp());
+            if (due > now) {
+                break;
+            }
+        } else if (fed == AppConstants::REPLAY_FAST_STATES_PER_FRAME) {
+            break;
+        }
+
+        m_currentState = m_reader.GetState();
+        m_latency.OnRead(now);
+        m_latency.OnEventTimestamp(0); // No hardware timestamp
+        MapCurrentState();
+        ++fed;
+        m_hasState = m_reader.Next();
+    }
+
+    if (!m_hasState) {
+        // Whatever the recording still held is let go, never left stuck down
+        m_finished = true;
+        m_inputProcessor->ReleaseAllKeys();
+        LOG_INFO_W(L"Replay finished: " + m_deviceInstanceName);
+    }
+    return true;
+}
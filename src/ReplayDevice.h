@@ -0,0 +1,41 @@
+#pragma once
+#include "GamepadDevice.h"
+#include "InputRecording.h"
+
+/**
+ * @brief Replays a .gmrec recording as if the recorded pad were attached
+ *
+ * The device takes the recorded device name, so it loads that device's
+ * configuration file and maps exactly what the pad sent. In real-time mode
+ * each state is fed once its recorded offset has elapsed (at the frame
+ * scheduler's resolution); otherwise up to REPLAY_FAST_STATES_PER_FRAME
+ * states are fed per frame. When the recording ends every key is released
+ * and the device stays connected but idle.
+ */
+class ReplayDevice final : public GamepadDevice {
+public:
+    ReplayDevice() = default;
+    ~ReplayDevice() override;
+
+    static GUID MakeGuid();
+
+    // Initialization
+    bool Initialize(const std::wstring& path, bool realTime);
+
+    const wchar_t* GetBackendName() const override { return L"Replay"; }
+    bool TryToReconnect(HWND) override { return m_connected; }
+    bool IsFinished() const { return m_finished; }
+
+protected:
+    bool ReadInput() override;
+    void CloseDevice() override { m_reader.Close(); }
+
+private:
+    int64_t ToLocalTicks(int64_t recordedTicks) const;
+
+    RecordingReader m_reader;
+    bool m_realTime = true;
+    bool m_hasState = false;  // m_reader holds a decoded state not fed yet
+    bool m_finished = false;
+    int64_t m_startQpc = 0;
+};
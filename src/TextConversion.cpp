@@ -0,0 +1,64 @@
+#include "TextConversion.h"
+#include <windows.h>
+
+namespace {
+
+// Converts into out, reusing its capacity; the size query only runs when it is too small
+void WideToUtf8Into(std::wstring_view wide, std::string& out)
+{
+    out.clear();
+    if (wide.empty()) {
+        return;
+    }
+
+    const int length = static_cast<int>(wide.size());
+    out.resize(out.capacity());
+    int written = out.empty() ? 0 : WideCharToMultiByte(CP_UTF8, 0, wide.data(), length, &out[0],
+                                                         static_cast<int>(out.size()), nullptr, nullptr);
+    if (written == 0) {
+        const int needed = WideCharToMultiByte(CP_UTF8, 0, wide.data(), length, nullptr, 0, nullptr, nullptr);
+        if (needed <= 0) {
+            out.clear();
+            return;
+        }
+        out.resize(static_cast<size_t>(needed));
+        written = WideCharToMultiByte(CP_UTF8, 0, wide.data(), length, &out[0], needed, nullptr, nullptr);
+    }
+    out.resize(static_cast<size_t>(written));
+}
+
+} // namespace
+
+namespace Text {
+
+std::wstring Utf8ToWide(std::string_view utf8)
+{
+    std::wstring wide;
+    if (utf8.empty()) {
+        return wide;
+    }
+
+    const int length = static_cast<int>(utf8.size());
+    const int needed = MultiByteToWideChar(CP_UTF8, 0, utf8.data(), length, nullptr, 0);
+    if (needed > 0) {
+        wide.resize(static_cast<size_t>(needed));
+        MultiByteToWideChar(CP_UTF8, 0, utf8.data(), length, &wide[0], needed);
+    }
+    return wide;
+}
+
+std::string WideToUtf8(std::wstring_view wide)
+{
+    std::string utf8;
+    WideToUtf8Into(wide, utf8);
+    return utf8;
+}
+
+std::string_view WideToUtf8Scratch(std::wstring_view wide)
+{
+    thread_local std::string scratch;
+    WideToUtf8Into(wide, scratch);
+    return scratch;
+}
+
+} // namespace Text
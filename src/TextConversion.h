@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+/**
+ * @brief UTF-8 <-> UTF-16 conversion (Win32, no <codecvt>)
+ *
+ * Utf8ToWide/WideToUtf8 return new strings, for start-up and configuration
+ * paths; identifiers used repeatedly are converted once and cached by their
+ * owner. WideToUtf8Scratch converts into a buffer owned by the calling thread
+ * that only grows, so once it has reached the longest message the logger
+ * converts without allocating. Invalid sequences become U+FFFD.
+ */
+namespace Text {
+    std::wstring Utf8ToWide(std::string_view utf8);
+    std::string WideToUtf8(std::wstring_view wide);
+
+    // Valid until the next call on the same thread
+    std::string_view WideToUtf8Scratch(std::wstring_view wide);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <windows.h>
+#include <memory>
+
+/**
+ * @brief RAII owner for kernel object handles (events, timers, threads, files)
+ *
+ * Closes the handle with CloseHandle when it goes out of scope. Both nullptr
+ * and INVALID_HANDLE_VALUE are treated as "no handle".
+ */
+struct Win32HandleDeleter {
+    void operator()(HANDLE handle) const {
+        if (handle && handle != INVALID_HANDLE_VALUE) {
+            CloseHandle(handle);
+        }
+    }
+};
+
+using UniqueHandle = std::unique_ptr<void, Win32HandleDeleter>;
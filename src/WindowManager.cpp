@@ -3,6 +3,8 @@
 #include "DisplayBuffer.h"
 #include "resource.h"
 
+#include <algorithm>
+
 WindowManager::WindowManager(HINSTANCE hInstance, const std::wstring& title)
     : m_hInst(hInstance), m_title(title), m_logger(nullptr) {}
 
@@ -13,12 +15,16 @@ WindowManager::WindowManager(HINSTANCE hInstance, const std::wstring& title, Dis
     : m_hInst(hInstance), m_title(title), m_displayBuffer(displayBuffer) {}
 
 WindowManager::~WindowManager() {
+    RemoveTrayIcon();
     if (m_hWnd) {
         DestroyWindow(m_hWnd);
     }
+    ReleaseBackBuffer();
 }
 
-bool WindowManager::Init(int width, int height) {
+bool WindowManager::Init(int width, int height, bool trayMode) {
+    m_trayMode = trayMode;
+
     const wchar_t* clsName = L"DInputMinimalWnd";
     WNDCLASS wc{};
     wc.lpfnWndProc = StaticWndProc;
@@ -40,11 +46,174 @@ bool WindowManager::Init(int width, int height) {
     );
     if (!m_hWnd) return false;
 
+    if (m_trayMode) {
+        // The (hidden) window still exists: DirectInput needs it for the cooperative level
+        m_taskbarCreatedMsg = RegisterWindowMessageW(L"TaskbarCreated");
+        if (!AddTrayIcon()) {
+            LOG_WARN("Failed to add notification-area icon; showing the window instead");
+            m_trayMode = false;
+        } else {
+            HideToTray();
+            return true;
+        }
+    }
+
+    ShowLiveView();
+    return true;
+}
+
+void WindowManager::ShowLiveView() {
+    if (!m_hWnd) return;
+    if (m_displayBuffer) m_displayBuffer->SetEnabled(true);
+    m_liveView.store(true, std::memory_order_relaxed);
+
     ShowWindow(m_hWnd, SW_SHOW);
+    SetForegroundWindow(m_hWnd);
     UpdateWindow(m_hWnd);
+}
+
+void WindowManager::HideToTray() {
+    if (!m_hWnd) return;
+    // Stop all display formatting before the window goes away
+    m_liveView.store(false, std::memory_order_relaxed);
+    if (m_displayBuffer) m_displayBuffer->SetEnabled(false);
+
+    ShowWindow(m_hWnd, SW_HIDE);
+    ReleaseBackBuffer(); // Recreated on demand by the next paint
+}
+
+bool WindowManager::AddTrayIcon() {
+    NOTIFYICONDATAW nid{};
+    nid.cbSize = sizeof(nid);
+    nid.hWnd = m_hWnd;
+    nid.uID = TRAY_ICON_ID;
+    nid.uFlags = NIF_ICON | NIF_MESSAGE | NIF_TIP;
+    nid.uCallbackMessage = WM_TRAY_ICON;
+    nid.hIcon = LoadIcon(m_hInst, MAKEINTRESOURCE(IDI_GAMEPADMAPPER));
+    wcsncpy_s(nid.szTip, m_title.c_str(), _TRUNCATE);
+
+    m_trayIconAdded = Shell_NotifyIconW(NIM_ADD, &nid) != FALSE;
+    return m_trayIconAdded;
+}
+
+void WindowManager::RemoveTrayIcon() {
+    if (!m_trayIconAdded) return;
+
+    NOTIFYICONDATAW nid{};
+    nid.cbSize = sizeof(nid);
+    nid.hWnd = m_hWnd;
+    nid.uID = TRAY_ICON_ID;
+    Shell_NotifyIconW(NIM_DELETE, &nid);
+    m_trayIconAdded = false;
+}
+
+void WindowManager::ShowTrayMenu() {
+    HMENU menu = CreatePopupMenu();
+    if (!menu) return;
+
+    AppendMenuW(menu, MF_STRING, ID_TRAY_TOGGLE_VIEW, IsLiveViewVisible() ? L"Hide live view" : L"Show live view");
+    AppendMenuW(menu, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(menu, MF_STRING, ID_TRAY_EXIT, L"Exit");
+
+    // Required so the menu closes when the user clicks elsewhere
+    SetForegroundWindow(m_hWnd);
+    POINT pt;
+    GetCursorPos(&pt);
+    TrackPopupMenu(menu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, m_hWnd, nullptr);
+    PostMessage(m_hWnd, WM_NULL, 0, 0);
+    DestroyMenu(menu);
+}
+
+bool WindowManager::EnsureBackBuffer(int width, int height) {
+    if (m_backDC && width <= m_backWidth && height <= m_backHeight) {
+        return true;
+    }
+
+    HDC hdc = GetDC(m_hWnd);
+    if (!hdc) return false;
+
+    if (!m_backDC) {
+        m_backDC = CreateCompatibleDC(hdc);
+        if (!m_backDC) {
+            ReleaseDC(m_hWnd, hdc);
+            return false;
+        }
+        // Same (default) font for the life of the DC, so the metrics are read once
+        GetTextMetrics(m_backDC, &m_textMetrics);
+        m_rowHeight.store(m_textMetrics.tmHeight + ROW_SPACING, std::memory_order_relaxed);
+    }
+
+    // Grow only: shrinking the window keeps the larger bitmap
+    const int newWidth = (std::max)(width, m_backWidth);
+    const int newHeight = (std::max)(height, m_backHeight);
+    HBITMAP bitmap = CreateCompatibleBitmap(hdc, newWidth, newHeight);
+    ReleaseDC(m_hWnd, hdc);
+    if (!bitmap) return false;
+
+    HGDIOBJ previous = SelectObject(m_backDC, bitmap);
+    if (m_backBitmap) {
+        DeleteObject(m_backBitmap);
+    } else {
+        m_backOldBitmap = previous;
+    }
+    m_backBitmap = bitmap;
+    m_backWidth = newWidth;
+    m_backHeight = newHeight;
     return true;
 }
 
+void WindowManager::ReleaseBackBuffer() {
+    if (m_backDC) {
+        SelectObject(m_backDC, m_backOldBitmap);
+        DeleteDC(m_backDC);
+        m_backDC = nullptr;
+    }
+    if (m_backBitmap) {
+        DeleteObject(m_backBitmap);
+        m_backBitmap = nullptr;
+    }
+    m_backOldBitmap = nullptr;
+    m_backWidth = 0;
+    m_backHeight = 0;
+}
+
+void WindowManager::OnSize(int width, int height) {
+    if (width <= 0 || height <= 0) return; // Minimized
+    if (!IsLiveViewVisible()) return;      // Hidden in the tray: nothing is drawn
+
+    const bool recreated = !m_backDC || width > m_backWidth || height > m_backHeight;
+    if (EnsureBackBuffer(width, height) && recreated) {
+        // A new bitmap holds nothing yet: every row has to be drawn again
+        InvalidateRect(m_hWnd, nullptr, FALSE);
+    }
+}
+
+void WindowManager::InvalidateRows(const DisplayBuffer::DirtyRows& rows) {
+    if (!m_hWnd || rows.none()) return;
+
+    const int rowHeight = m_rowHeight.load(std::memory_order_relaxed);
+    if (rowHeight <= 0) {
+        InvalidateRect(m_hWnd, nullptr, FALSE);
+        return;
+    }
+
+    RECT client;
+    GetClientRect(m_hWnd, &client);
+
+    // One rect per run of consecutive dirty rows; Windows merges them into the update region
+    for (size_t first = 0; first < rows.size(); ++first) {
+        if (!rows.test(first)) continue;
+        size_t last = first;
+        while (last + 1 < rows.size() && rows.test(last + 1)) ++last;
+
+        RECT rc{ client.left, TEXT_MARGIN + static_cast<int>(first) * rowHeight,
+                 client.right, TEXT_MARGIN + static_cast<int>(last + 1) * rowHeight };
+        if (rc.top >= client.bottom) break; // Rows below the window are never painted
+        InvalidateRect(m_hWnd, &rc, FALSE);
+        first = last;
+    }
+}
+
 LRESULT CALLBACK WindowManager::StaticWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     WindowManager* pThis = nullptr;
 
@@ -66,53 +235,107 @@ LRESULT CALLBACK WindowManager::StaticWndProc(HWND hWnd, UINT msg, WPARAM wParam
 
 LRESULT WindowManager::MemberWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     switch (msg) {
+    case WM_CLOSE: {
+        if (m_trayMode) {
+            HideToTray(); // Keep running in the notification area
+            return 0;
+        }
+        DestroyWindow(hWnd);
+        return 0;
+    }
+    case WM_TRAY_ICON: {
+        switch (LOWORD(lParam)) {
+        case WM_LBUTTONDBLCLK:
+            if (IsLiveViewVisible()) HideToTray(); else ShowLiveView();
+            break;
+        case WM_RBUTTONUP:
+        case WM_CONTEXTMENU:
+            ShowTrayMenu();
+            break;
+        }
+        return 0;
+    }
+    case WM_DEVICECHANGE: {
+        if (m_deviceChangeHandler) {
+            m_deviceChangeHandler(wParam);
+        }
+        return TRUE;
+    }
+    case WM_APP_EXIT: {
+        DestroyWindow(hWnd);
+        return 0;
+    }
+    case WM_COMMAND: {
+        switch (LOWORD(wParam)) {
+        case ID_TRAY_TOGGLE_VIEW:
+            if (IsLiveViewVisible()) HideToTray(); else ShowLiveView();
+            return 0;
+        case ID_TRAY_EXIT:
+            DestroyWindow(hWnd);
+            return 0;
+        }
+        break;
+    }
     case WM_DESTROY: {
+        RemoveTrayIcon();
+        ReleaseBackBuffer();
         m_running = false;
         PostQuitMessage(0);
         return 0;
     }
+    case WM_SIZE: {
+        OnSize(LOWORD(lParam), HIWORD(lParam));
+        return 0;
+    }
     case WM_PAINT: {
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hWnd, &ps);
-
-        RECT rc;
-        GetClientRect(hWnd, &rc);
-        
-        // Create compatible DC for double buffering
-        HDC memDC = CreateCompatibleDC(hdc);
-        HBITMAP memBitmap = CreateCompatibleBitmap(hdc, rc.right - rc.left, rc.bottom - rc.top);
-        HBITMAP oldBitmap = (HBITMAP)SelectObject(memDC, memBitmap);
-
-        // Clear background in memory DC
-        HBRUSH hbr = (HBRUSH)(COLOR_WINDOW + 1);
-        FillRect(memDC, &rc, hbr);
-
-        // Get display lines from DisplayBuffer
-        const auto& logLines = m_displayBuffer ? 
-            m_displayBuffer->GetLines() : 
-            std::vector<std::wstring>();
-        
-        TEXTMETRIC tm;
-        GetTextMetrics(memDC, &tm);
-        int y = 4;
-        for (const auto& line : logLines) {
-            TextOutW(memDC, 4, y, line.c_str(), (int)line.size());
-            y += tm.tmHeight + 2;
-            if (y > rc.bottom - 10) break;
+        Paint(hdc, ps.rcPaint);
+        EndPaint(hWnd, &ps);
+        return 0;
+    }
+    default:
+        if (m_taskbarCreatedMsg != 0 && msg == m_taskbarCreatedMsg && m_trayMode) {
+            AddTrayIcon();
+            return 0;
         }
+        break;
+    }
+    return DefWindowProc(hWnd, msg, wParam, lParam);
+}
 
-        // Copy memory DC to screen DC
-        BitBlt(hdc, 0, 0, rc.right - rc.left, rc.bottom - rc.top, memDC, 0, 0, SRCCOPY);
+void WindowManager::Paint(HDC hdc, const RECT& dirty) {
+    // Only the invalidated part (typically a few dirty rows) is redrawn
+    if (dirty.right <= dirty.left || dirty.bottom <= dirty.top) return;
 
-        // Cleanup
-        SelectObject(memDC, oldBitmap);
-        DeleteObject(memBitmap);
-        DeleteDC(memDC);
+    RECT rc;
+    GetClientRect(m_hWnd, &rc);
+    if (!EnsureBackBuffer(rc.right - rc.left, rc.bottom - rc.top)) return;
 
-        EndPaint(hWnd, &ps);
-        return 0;
+    // Clear background in the back buffer
+    HBRUSH hbr = (HBRUSH)(COLOR_WINDOW + 1);
+    FillRect(m_backDC, &dirty, hbr);
+
+    // Get a stable copy of the last published frame (written by the input thread);
+    // the copy is skipped when this generation was already fetched
+    if (m_displayBuffer) {
+        m_displayBuffer->GetSnapshot(m_paintFrame);
+    } else {
+        m_paintFrame.count = 0;
     }
-    default:
-        return DefWindowProc(hWnd, msg, wParam, lParam);
+
+    const int rowHeight = m_textMetrics.tmHeight + ROW_SPACING;
+    int y = TEXT_MARGIN;
+    for (size_t i = 0; i < m_paintFrame.count; ++i) {
+        if (y >= dirty.bottom || y > rc.bottom - 10) break;
+        if (y + rowHeight > dirty.top) {
+            const DisplayBuffer::Line& line = m_paintFrame.lines[i];
+            TextOutW(m_backDC, TEXT_MARGIN, y, line.text, (int)line.length);
+        }
+        y += rowHeight;
     }
+
+    // Copy the dirty region of the back buffer to the screen
+    BitBlt(hdc, dirty.left, dirty.top, dirty.right - dirty.left, dirty.bottom - dirty.top,
+           m_backDC, dirty.left, dirty.top, SRCCOPY);
 }
@@ -1,6 +1,10 @@
 #pragma once
 #include <windows.h>
+#include <shellapi.h>
+#include <atomic>
+#include <functional>
 #include <string>
+#include <vector>
 #include "Logger.h"
 #include "DisplayBuffer.h"
 
@@ -11,23 +15,68 @@ public:
     WindowManager(HINSTANCE hInstance, const std::wstring& title, DisplayBuffer* displayBuffer);
     ~WindowManager();
 
-    bool Init(int width, int height);
+    // trayMode: start hidden behind a notification-area icon; closing the window hides it again
+    bool Init(int width, int height, bool trayMode = false);
     HWND GetHwnd() const { return m_hWnd; }
     bool IsRunning() const { return m_running; }
     void SetRunning(bool running) { m_running = running; }
+
+    // Live view on/off; the DisplayBuffer is enabled only while the window is shown
+    void ShowLiveView();
+    void HideToTray();
+    bool IsLiveViewVisible() const { return m_liveView.load(std::memory_order_relaxed); }
+    // Destroys the window (and so ends the message loop) even in tray mode, where WM_CLOSE only hides
+    void RequestExit() { if (m_hWnd) PostMessage(m_hWnd, WM_APP_EXIT, 0, 0); }
     
     // Dependency injection
     void SetLogger(Logger* logger) { m_logger = logger; }
     void SetDisplayBuffer(DisplayBuffer* displayBuffer) { m_displayBuffer = displayBuffer; }
 
+    // WM_DEVICECHANGE forwarding (runs on the window thread)
+    void SetDeviceChangeHandler(std::function<void(WPARAM)> handler) { m_deviceChangeHandler = std::move(handler); }
+
+    // Queue a repaint of just the given text rows (callable from any thread)
+    void InvalidateRows(const DisplayBuffer::DirtyRows& rows);
+
 private:
     static LRESULT CALLBACK StaticWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
     LRESULT MemberWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+    void OnSize(int width, int height);
+    bool EnsureBackBuffer(int width, int height);
+    void ReleaseBackBuffer();
+    void Paint(HDC hdc, const RECT& dirty);
+    bool AddTrayIcon();
+    void RemoveTrayIcon();
+    void ShowTrayMenu();
+
+    static constexpr UINT WM_TRAY_ICON = WM_APP + 1;
+    static constexpr UINT WM_APP_EXIT = WM_APP + 2;
+    static constexpr UINT TRAY_ICON_ID = 1;
+    static constexpr UINT ID_TRAY_TOGGLE_VIEW = 40001;
+    static constexpr UINT ID_TRAY_EXIT = 40002;
+
+    static constexpr int TEXT_MARGIN = 4;
+    static constexpr int ROW_SPACING = 2;
 
     HINSTANCE m_hInst = nullptr;
     HWND m_hWnd = nullptr;
     std::wstring m_title;
     bool m_running = true;
+    bool m_trayMode = false;
+    bool m_trayIconAdded = false;
+    UINT m_taskbarCreatedMsg = 0;       // Re-add the icon when Explorer restarts
+    std::atomic<bool> m_liveView{ false };
     Logger* m_logger = nullptr; // Injected dependency (legacy)
     DisplayBuffer* m_displayBuffer = nullptr; // Injected dependency (new)
+    std::function<void(WPARAM)> m_deviceChangeHandler;
+    DisplayBuffer::Frame m_paintFrame; // Snapshot copied from DisplayBuffer on WM_PAINT (reused, no per-paint allocation)
+    std::atomic<int> m_rowHeight{ 0 };  // Text row pitch in pixels; 0 until the window exists
+
+    // Back buffer kept alive between paints; it only grows, on WM_SIZE
+    HDC m_backDC = nullptr;
+    HBITMAP m_backBitmap = nullptr;
+    HGDIOBJ m_backOldBitmap = nullptr;
+    int m_backWidth = 0;
+    int m_backHeight = 0;
+    TEXTMETRIC m_textMetrics{}; // Cached when the back DC is created (font never changes)
 };
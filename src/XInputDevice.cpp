@@ -0,0 +1,162 @@
+#include "XInputDevice.h"
+#include "ConfigManager.h"
+#include "InputProcessor.h"
+#include "Logger.h"
+#include <iterator>
+#include <algorithm>
+
+namespace {
+
+// Button bits in the order the DirectInput driver numbers them
+constexpr WORD BUTTON_BITS[] = {
+    XINPUT_GAMEPAD_A, XINPUT_GAMEPAD_B, XINPUT_GAMEPAD_X, XINPUT_GAMEPAD_Y,
+    XINPUT_GAMEPAD_LEFT_SHOULDER, XINPUT_GAMEPAD_RIGHT_SHOULDER,
+    XINPUT_GAMEPAD_BACK, XINPUT_GAMEPAD_START,
+    XINPUT_GAMEPAD_LEFT_THUMB, XINPUT_GAMEPAD_RIGHT_THUMB,
+};
+
+// POV angle (hundredths of a degree) by [dy + 1][dx + 1], y pointing up
+constexpr DWORD POV_BY_DIRECTION[3][3] = {
+    { 22500, 18000, 13500 },      // down-left, down, down-right
+    { 27000, 0xFFFFFFFF, 9000 },  // left, centred, right
+    { 31500, 0, 4500 },           // up-left, up, up-right
+};
+
+LONG ScaleThumb(SHORT value)
+{
+    // -32768..32767 -> AXIS_RANGE_MIN..AXIS_RANGE_MAX
+    const LONG scaled = static_cast<LONG>(value) * AppConstants::AXIS_RANGE_MAX / 32767;
+    return (std::max)(scaled, AppConstants::AXIS_RANGE_MIN);
+}
+
+LONG ScaleTrigger(BYTE value)
+{
+    // 0..255 -> rest at the axis minimum, fully pressed at the maximum
+    return AppConstants::AXIS_RANGE_MIN +
+           static_cast<LONG>(value) * (AppConstants::AXIS_RANGE_MAX - AppConstants::AXIS_RANGE_MIN) / 255;
+}
+
+} // namespace
+
+XInputDevice::~XInputDevice()
+{
+    Shutdown();
+}
+
+GUID XInputDevice::MakeGuid(DWORD userIndex)
+{
+    // "XINP" + user index; never collides with a DirectInput instance GUID
+    return GUID{ 0x504E4958, 0x0000, 0x0000, { 0, 0, 0, 0, 0, 0, 0, static_cast<BYTE>(userIndex) } };
+}
+
+bool XInputDevice::IsUserConnected(DWORD userIndex)
+{
+    XINPUT_CAPABILITIES capabilities;
+    return XInputGetCapabilities(userIndex, XINPUT_FLAG_GAMEPAD, &capabilities) == ERROR_SUCCESS;
+}
+
+bool XInputDevice::Initialize(DWORD userIndex)
+{
+    if (m_initialized) {
+        return true;
+    }
+
+    // Store device information
+    m_userIndex = userIndex;
+    m_deviceName = L"XInput Controller " + std::to_wstring(userIndex + 1);
+    m_deviceInstanceName = L"XInput user " + std::to_wstring(userIndex);
+    m_deviceGUID = MakeGuid(userIndex);
+
+    if (!IsUserConnected(userIndex)) {
+        LOG_ERROR_W(L"No XInput controller on user index " + std::to_wstring(userIndex));
+        return false;
+    }
+
+    // Load configuration (one file per user index)
+    if (!LoadConfiguration()) {
+        LOG_ERROR_W(L"Failed to load configuration for device: " + m_deviceName);
+        return false;
+    }
+
+    // Initialize input processor; the axis layout is fixed by TranslateState
+    CreateInputProcessor();
+    m_inputProcessor->SetNativeAnalogLayout(AnalogLayout::DirectInput);
+    m_currentState = DIJOYSTATE2{};
+    m_hasPacket = false;
+
+    m_initialized = true;
+    m_connected = true;
+
+    LOG_INFO_W(L"GamepadDevice initialized successfully: " + m_deviceName + L" (" + m_deviceInstanceName + L") [XInput]");
+
+    return true;
+}
+
+bool XInputDevice::ReadInput()
+{
+    XINPUT_STATE state;
+    const DWORD result = XInputGetState(m_userIndex, &state);
+    m_latency.OnRead(Qpc::Now());
+    m_latency.OnEventTimestamp(0); // No hardware timestamp
+    if (result != ERROR_SUCCESS) {
+        if (result == ERROR_DEVICE_NOT_CONNECTED) {
+            LOG_WARN_W(L"Device is unplugged or lost: " + m_deviceName);
+            m_connected = false;
+        }
+        return false;
+    }
+
+    // Same packet number: nothing moved since the last frame
+    if (m_hasPacket && state.dwPacketNumber == m_lastPacket) {
+        return true;
+    }
+    m_lastPacket = state.dwPacketNumber;
+    m_hasPacket = true;
+
+    TranslateState(state.Gamepad);
+    MapCurrentState();
+    return true;
+}
+
+void XInputDevice::TranslateState(const XINPUT_GAMEPAD& pad)
+{
+    DIJOYSTATE2& js = m_currentState;
+
+    // Sticks (XInput y points up, DirectInput y points down)
+    js.lX = ScaleThumb(pad.sThumbLX);
+    js.lY = -ScaleThumb(pad.sThumbLY);
+    js.lZ = ScaleThumb(pad.sThumbRX);
+    js.lRz = -ScaleThumb(pad.sThumbRY);
+    js.lRx = ScaleTrigger(pad.bLeftTrigger);
+    js.lRy = ScaleTrigger(pad.bRightTrigger);
+
+    for (size_t i = 0; i < std::size(BUTTON_BITS); ++i) {
+        js.rgbButtons[i] = (pad.wButtons & BUTTON_BITS[i]) ? 0x80 : 0;
+    }
+
+    // Opposite directions cancel out
+    const int dx = ((pad.wButtons & XINPUT_GAMEPAD_DPAD_RIGHT) ? 1 : 0) - ((pad.wButtons & XINPUT_GAMEPAD_DPAD_LEFT) ? 1 : 0);
+    const int dy = ((pad.wButtons & XINPUT_GAMEPAD_DPAD_UP) ? 1 : 0) - ((pad.wButtons & XINPUT_GAMEPAD_DPAD_DOWN) ? 1 : 0);
+    js.rgdwPOV[0] = POV_BY_DIRECTION[dy + 1][dx + 1];
+    js.rgdwPOV[1] = js.rgdwPOV[2] = js.rgdwPOV[3] = 0xFFFFFFFF;
+}
+
+bool XInputDevice::TryToReconnect(HWND)
+{
+    if (m_connected) {
+        return true;
+    }
+
+    LOG_INFO_W(L"Attempting to reconnect device: " + m_deviceName);
+
+    if (!IsUserConnected(m_userIndex)) {
+        return false;
+    }
+
+    // Map the first state in full
+    m_hasPacket = false;
+    m_connected = true;
+    ResetReconnectBackoff();
+    LOG_INFO_W(L"Device reconnected successfully: " + m_deviceName);
+    return true;
+}
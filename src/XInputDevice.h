@@ -0,0 +1,47 @@
+#pragma once
+#include "GamepadDevice.h"
+#include <Xinput.h>
+
+/**
+ * @brief XInput backend for Xbox-class controllers (one XInput user index)
+ *
+ * XInputGetState is a single call with no COM in between, reports both
+ * triggers separately and carries a packet number that only changes when
+ * the pad state does, so an untouched pad costs one call per frame and no
+ * mapping work.
+ *
+ * The state is translated into DIJOYSTATE2 the way the DirectInput driver
+ * numbers these pads (A, B, X, Y, LB, RB, Back, Start, LS, RS = buttons
+ * 0-9), with the right stick on Z/Rz and the triggers on Rx/Ry
+ * (AnalogLayout::DirectInput), so existing mappings keep working. The
+ * device identity is a synthetic GUID per user index.
+ */
+class XInputDevice final : public GamepadDevice {
+public:
+    static constexpr DWORD MAX_USERS = XUSER_MAX_COUNT;
+
+    XInputDevice() = default;
+    ~XInputDevice() override;
+
+    // Initialization
+    bool Initialize(DWORD userIndex);
+
+    const wchar_t* GetBackendName() const override { return L"XInput"; }
+    DWORD GetUserIndex() const { return m_userIndex; }
+    bool TryToReconnect(HWND hWnd) override;
+
+    // Enumeration helpers
+    static GUID MakeGuid(DWORD userIndex);
+    static bool IsUserConnected(DWORD userIndex);
+
+protected:
+    bool ReadInput() override;
+    void CloseDevice() override {}
+
+private:
+    void TranslateState(const XINPUT_GAMEPAD& pad);
+
+    DWORD m_userIndex = 0;
+    DWORD m_lastPacket = 0;
+    bool m_hasPacket = false; // false: the next state is mapped whatever its packet number
+};